@@ -0,0 +1,216 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "AsyncImageLoader.h"
+#include "ImageLoader.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QFile>
+#include <QImageIOHandler>
+#include <QImageReader>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+
+#include <functional>
+
+namespace {
+
+// Decoders pull the compressed data strip by strip (TIFF) or row group by
+// row group (PNG, JPEG) from their device. Failing the next read after a
+// cancel stops them there, the position reports the decode progress.
+class CancelableBuffer : public QBuffer
+{
+public:
+  CancelableBuffer( QByteArray* data, const std::atomic<bool>& cancel, std::function<void(qint64)> onRead = {} )
+    : QBuffer(data), m_cancel(cancel), m_onRead(std::move(onRead)) {}
+
+protected:
+  qint64 readData( char* data, qint64 maxSize ) override {
+    if ( m_cancel ) {
+      setErrorString("Canceled");
+      return -1;
+    }
+    const qint64 n = QBuffer::readData(data, maxSize);
+    if ( m_onRead ) m_onRead(pos() + n);
+    return n;
+  }
+
+private:
+  const std::atomic<bool>& m_cancel;
+  std::function<void(qint64)> m_onRead;
+};
+
+// Subimage of a multi-page TIFF to use as preview: the smallest reduced
+// level still covering the preview size, else the largest reduced one.
+// Only pages with the aspect ratio of the first count as pyramid levels.
+int previewLevel( QImageReader& reader, const QSize& fullSize, const QSize& previewSize )
+{
+  const QSize fit = fullSize.scaled(previewSize, Qt::KeepAspectRatio);
+  int best = -1;
+  QSize bestSize;
+  for ( int i = 1; i < reader.imageCount() && reader.jumpToImage(i); ++i ) {
+    const QSize size = reader.size();
+    if ( !size.isValid() || size.width() >= fullSize.width() ||
+         qAbs(qreal(size.width()) / size.height() - qreal(fullSize.width()) / fullSize.height()) > 0.01 )
+      continue;
+    const bool covers = size.width() >= fit.width() && size.height() >= fit.height();
+    const bool bestCovers = best >= 0 && bestSize.width() >= fit.width() && bestSize.height() >= fit.height();
+    if ( best < 0 || ( covers && ( !bestCovers || size.width() < bestSize.width() ) ) ||
+         ( !covers && !bestCovers && size.width() > bestSize.width() ) ) {
+      best = i;
+      bestSize = size;
+    }
+  }
+  return best;
+}
+
+}
+
+// -------------------------- AsyncImageLoader --------------------------
+AsyncImageLoader::AsyncImageLoader( QObject* parent ) : QObject(parent)
+{
+}
+
+AsyncImageLoader::~AsyncImageLoader()
+{
+  if ( m_thread != nullptr ) {
+    m_cancel = true;
+    m_thread->wait();
+  }
+}
+
+void AsyncImageLoader::start( const QString& filePath, const QSize& previewSize )
+{
+  if ( m_thread != nullptr ) {
+    qWarning() << "AsyncImageLoader::start(): Loader is already running.";
+    return;
+  }
+  m_cancel = false;
+  m_thread = QThread::create([this, filePath, previewSize](){ run(filePath, previewSize); });
+  m_thread->setParent(this);
+  m_thread->start();
+}
+
+void AsyncImageLoader::dispose()
+{
+  disconnect(this, nullptr, nullptr, nullptr);
+  m_cancel = true;
+  if ( m_thread != nullptr ) {
+    connect(m_thread, &QThread::finished, this, &QObject::deleteLater);
+    if ( !m_thread->isFinished() )
+      return;
+  }
+  deleteLater();
+}
+
+void AsyncImageLoader::run( const QString& filePath, const QSize& previewSize )
+{
+  QFile file(filePath);
+  if ( !file.open(QIODevice::ReadOnly) ) {
+    emit failed(QString("Cannot open '%1': %2").arg(filePath, file.errorString()));
+    return;
+  }
+  // --- read once, in chunks so that cancel stays responsive ---
+  const qint64 fileSize = file.size();
+  QByteArray data;
+  data.reserve(qsizetype(fileSize));
+  while ( !file.atEnd() ) {
+    if ( m_cancel ) return;
+    data.append(file.read(4 << 20));
+    if ( fileSize > 0 ) emit progress(int(30 * data.size() / fileSize));
+  }
+  file.close();
+
+  // --- checksum concurrently to decoding, over the same bytes ---
+  QString checksum;
+  QSemaphore hashed;
+  QThreadPool::globalInstance()->start([&data, &checksum, &hashed](){
+    checksum = QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex();
+    hashed.release();
+  });
+
+  QImage image;
+  QString error;
+  if ( filePath.endsWith(".mnc", Qt::CaseInsensitive) || filePath.endsWith(".mnc2", Qt::CaseInsensitive) ) {
+    ImageLoader loader;
+    if ( loader.load(filePath, true) ) {
+      image = loader.getImage();
+    }
+  } else {
+    CancelableBuffer buffer(&data, m_cancel);
+    buffer.open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    QImageReader probe(&buffer);
+    const QSize fullSize = probe.size();
+    const bool wantPreview = previewSize.isValid() && fullSize.isValid() &&
+                             ( fullSize.width() > previewSize.width() || fullSize.height() > previewSize.height() );
+    const QSize fit = wantPreview ? fullSize.scaled(previewSize, Qt::KeepAspectRatio) : QSize();
+    bool previewSent = false;
+    if ( wantPreview && probe.supportsOption(QImageIOHandler::ScaledSize) ) {
+      // codecs decoding scaled (JPEG) need no full decode
+      probe.setScaledSize(fit);
+      const QImage preview = probe.read();
+      if ( !preview.isNull() && !m_cancel ) {
+        emit previewReady(preview, fullSize);
+        previewSent = true;
+      }
+    } else if ( wantPreview && probe.imageCount() > 1 ) {
+      // tiled TIFF sections carry reduced pyramid levels as subimages
+      const int level = previewLevel(probe, fullSize, previewSize);
+      if ( level > 0 && probe.jumpToImage(level) ) {
+        QImage preview = probe.read();
+        if ( !preview.isNull() && preview.width() > fit.width() ) {
+          preview = preview.scaled(fit, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+        if ( !preview.isNull() && !m_cancel ) {
+          emit previewReady(preview, fullSize);
+          previewSent = true;
+        }
+      }
+    }
+    emit progress(40);
+    if ( !m_cancel ) {
+      // progress while decoding, from the position of the decoder in the data
+      int lastPercent = 40;
+      CancelableBuffer source(&data, m_cancel, [this, &lastPercent, &data]( qint64 position ){
+        const int percent = 40 + int(55 * qMin(position, qint64(data.size())) / qMax(qint64(1), qint64(data.size())));
+        if ( percent > lastPercent ) {
+          lastPercent = percent;
+          emit progress(percent);
+        }
+      });
+      source.open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+      QImageReader reader(&source);
+      image = reader.read();
+      if ( image.isNull() ) error = reader.errorString();
+    }
+    // other codecs (PNG) get the preview from the decoded image
+    if ( wantPreview && !previewSent && !image.isNull() && !m_cancel ) {
+      emit previewReady(image.scaled(fit, Qt::KeepAspectRatio, Qt::FastTransformation), fullSize);
+    }
+  }
+  hashed.acquire();
+  if ( m_cancel ) return;
+  if ( image.isNull() ) {
+    emit failed(QString("Cannot decode '%1' %2").arg(filePath, error));
+    return;
+  }
+  emit progress(100);
+  emit finished(image, checksum);
+}
@@ -0,0 +1,64 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+#include <QObject>
+#include <QImage>
+#include <QSize>
+#include <QString>
+
+#include <atomic>
+
+class QThread;
+
+// -------------------------- AsyncImageLoader --------------------------
+// Reads an image file once on a worker thread. The MD5 checksum is computed
+// on the thread pool from the same bytes while they are decoded. Formats
+// which can decode scaled (e.g. JPEG) or carry pyramid levels (multi-page
+// TIFF) deliver a preview first, others one downscaled from the decoded
+// image. Cancel stops the decoder at its next strip or row read. Signals
+// are queued to the thread owning the loader.
+class AsyncImageLoader : public QObject {
+    Q_OBJECT
+
+public:
+
+    explicit AsyncImageLoader( QObject* parent = nullptr );
+    ~AsyncImageLoader() override;
+
+    void start( const QString& filePath, const QSize& previewSize = QSize() );
+    void cancel() { m_cancel = true; }
+    bool isCanceled() const { return m_cancel.load(); }
+    // disconnects, cancels and deletes the loader once the worker has ended
+    void dispose();
+
+signals:
+
+    void progress( int percent );
+    void previewReady( const QImage& preview, const QSize& fullSize );
+    void finished( const QImage& image, const QString& checksum );
+    void failed( const QString& reason );
+
+private:
+
+    void run( const QString& filePath, const QSize& previewSize );
+
+    QThread* m_thread = nullptr;
+    std::atomic<bool> m_cancel{false};
+
+};
@@ -87,6 +87,19 @@
       if ( QColor::isValidColorName(cursorBorderColor) ) {
         m_cursorBorderColor = QColor::fromString(cursorBorderColor);
       }
+      // repaint only changed items and the moved crosshair/brush preview
+      m_partialViewportUpdate = settings.value("Main/partialUpdates", true).toBool();
+      // OpenGL viewport (layer tiles as textures), raster is the fallback
+      m_openGLViewport = settings.value("Main/openGL", false).toBool();
+      // undo memory budget in MB, older undo images are spilled to disk above it (0 = unlimited)
+      int undoMemoryBudget = settings.value("Main/undoMemoryBudget", 1024).toInt();
+      if ( undoMemoryBudget >= 0 ) {
+        m_undoMemoryBudget = undoMemoryBudget;
+      }
+      // stroke and cage points of the history as packed base64 arrays instead of {"x","y"} objects;
+      // off by default: older versions cannot read packed files and cage points lose precision
+      // as float32 (ulp 0.004 px above 32768 px)
+      m_packedHistory = settings.value("Main/packedHistory", false).toBool();
       
       // Claude quads
       m_useClaudeQuads = settings.value("Cage/claudeQuads", true).toBool();
@@ -134,6 +147,12 @@
       if ( polygonWidth >= 0 ) {
         m_polygonWidth = polygonWidth;
       }
+      // Reduce polygon: Douglas-Peucker tolerance in pixel, Shift+double click keeps this percentage of the points (Visvalingam-Whyatt)
+      m_polygonReduceTolerance = settings.value("Polygon/reduceTolerance", 0.5).toDouble();
+      int polygonReducePercent = settings.value("Polygon/reducePercent", 50).toInt();
+      if ( polygonReducePercent > 0 && polygonReducePercent < 100 ) {
+        m_polygonReducePercent = polygonReducePercent;
+      }
       
       // ImageLayer allowIntegerMoveOnly
       m_allowIntegerMoveOnly = settings.value("ImageLayer/integerMoveOnly", true).toBool();
@@ -171,16 +190,22 @@
     QString windowSize() const { return m_windowSize; }
     QString version() const { return m_version; }
     int cursorSize() const { return m_cursorSize; }
+    int undoMemoryBudget() const { return m_undoMemoryBudget; }
     QColor cursorFillColor() const { return m_cursorFillColor; }
     QColor cursorBorderColor() const { return m_cursorBorderColor; }
     int lassoWidth() const { return m_lassoWidth; }
     int polygonWidth() const { return m_polygonWidth; }
+    double polygonReduceTolerance() const { return m_polygonReduceTolerance; }
+    int polygonReducePercent() const { return m_polygonReducePercent; }
     int controlPointRadius() const { return m_controlPointRadius; }
     double handleRadius() const { return m_handleRadius; }
     bool crosshair() const { return m_crosshair; }
     bool isLoggingEnabled() const { return m_loggingIsEnabled; }
     bool useCageQuads() const { return m_useCageQuads; }
     bool useGPU() const { return m_usegpu; }
+    bool openGLViewport() const { return m_openGLViewport; }
+    bool partialViewportUpdate() const { return m_partialViewportUpdate; }
+    bool packedHistory() const { return m_packedHistory; }
     bool useClaudeQuads() const { return m_useClaudeQuads; }
     bool hasPerspective() const { return m_hasPerspective; }
     bool binaryMasking() const { return m_binaryMasking; }
@@ -198,8 +223,11 @@
           m_handleSize(10),
           m_lassoWidth(3), 
           m_polygonWidth(10),
+          m_polygonReducePercent(50),
+          m_polygonReduceTolerance(0.5),
           m_handleRadius(4.0),
           m_cursorSize(0),
+          m_undoMemoryBudget(1024),
           m_controlPointRadius(4),
           m_gridColor(Qt::green),
           m_controlPointColor(Qt::red),
@@ -210,6 +238,9 @@
           m_loggingIsEnabled(false), 
           m_useCageQuads(true), 
           m_usegpu(false),
+          m_openGLViewport(false),
+          m_partialViewportUpdate(true),
+          m_packedHistory(false),
           m_allowIntegerMoveOnly(true),
           m_useClaudeQuads(true), 
           m_hasPerspective(true),
@@ -249,14 +280,20 @@
     bool m_binaryMasking;
     bool m_allowIntegerMoveOnly;
     bool m_usegpu;
+    bool m_openGLViewport;
+    bool m_partialViewportUpdate;
+    bool m_packedHistory;
     
     int m_lassoWidth;
     int m_polygonWidth;
+    int m_polygonReducePercent;
     int m_controlPointRadius;
     int m_handleSize;
     int m_cursorSize;
+    int m_undoMemoryBudget;
     
     double m_handleRadius;
+    double m_polygonReduceTolerance;
     double m_rotationSingleStep;
     double m_layerOverlayOpacity;
     
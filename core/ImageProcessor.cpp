@@ -23,17 +23,14 @@
 #include "Config.h"
 #include "ImageProcessor.h"
 #include "ImageLoader.h"
+#include "ProjectReader.h"
 
 #include "../layer/LayerItem.h"
 #include "../undo/AbstractCommand.h"
-#include "../undo/PaintStrokeCommand.h"
-#include "../undo/PerspectiveWarpCommand.h"
-#include "../undo/TransformLayerCommand.h"
-#include "../undo/DeleteUndoEntryCommand.h"
+#include "../undo/CommandRegistry.h"
 #include "../undo/LassoCutCommand.h"
-#include "../undo/MirrorLayerCommand.h"
-#include "../undo/MoveLayerCommand.h"
-#include "../undo/CageWarpCommand.h"
+#include "../undo/EditablePolygonCommand.h"
+#include "../util/QImageUtils.h"
 
 #include <iostream>
 #include <algorithm>
@@ -69,6 +66,58 @@ QString ImageProcessor::saveIntermediate( AbstractCommand *cmd, const QString &n
   return "";
 }
 
+// polygon which produced a cut, the GUI links a cut to the last polygon as well
+EditablePolygonCommand* ImageProcessor::polygonOfCut( int newLayerId ) const
+{
+  for ( EditablePolygonCommand* polyCmd : m_polygonCommands ) {
+    if ( polyCmd->childLayerId() == newLayerId ) 
+      return polyCmd;
+  }
+  return m_polygonCommands.isEmpty() ? nullptr : m_polygonCommands.last();
+}
+
+// Cut layer without stored image data: rebuilt from its polygon on the current
+// source layer, with the same mask and cut as ImageView::createNewLayer()
+LayerItem* ImageProcessor::buildPolygonCutLayer( const QJsonObject& cmdObj )
+{
+  qDebug() << "ImageProcessor::buildPolygonCutLayer(): newLayerId =" << cmdObj["newLayerId"].toInt(-1);
+  {
+    const int newLayerId = cmdObj["newLayerId"].toInt(-1);
+    LayerItem* base = AbstractCommand::getLayerItem(m_layers, cmdObj["originalLayerId"].toInt(-1));
+    EditablePolygonCommand* polyCmd = polygonOfCut(newLayerId);
+    if ( base == nullptr || polyCmd == nullptr || polyCmd->model() == nullptr ) {
+      qWarning() << "ImageProcessor::buildPolygonCutLayer(): No polygon or source layer for layer" << newLayerId;
+      return nullptr;
+    }
+    // the polygon may have been edited after the cut, the stored rect tells which state was used
+    const QJsonObject r = cmdObj["rect"].toObject();
+    const QRect rect(r["x"].toInt(),r["y"].toInt(),r["width"].toInt(),r["height"].toInt());
+    QPolygonF polygon = polyCmd->model()->polygon();
+    if ( polygon.boundingRect().toAlignedRect() != rect && polyCmd->polygon().boundingRect().toAlignedRect() == rect ) {
+      polygon = polyCmd->polygon();
+    }
+    if ( polygon.size() < 3 ) {
+      qWarning() << "ImageProcessor::buildPolygonCutLayer(): Polygon" << polyCmd->name() << "has less than 3 points.";
+      return nullptr;
+    }
+    // LassoCutCommand places the layer at the stored rect, the mask is aligned to it
+    const QRect bounds = rect.isValid() ? rect : polygon.boundingRect().toAlignedRect();
+    QImage mask = LassoCutCommand::polygonMask(polygon, bounds);
+    const int featherRadius = cmdObj["featherRadius"].toInt(0);
+    if ( featherRadius > 0 ) {
+      mask = QImageUtils::blurAlphaMask(mask, featherRadius);
+    }
+    const QImage cut = LassoCutCommand::cutImage(base->image(), mask, bounds);
+    LayerItem* newLayer = new LayerItem("SubImage",cut);
+    newLayer->setName(QString("%1 %2").arg(cmdObj.value("name").toString("Polygon")).arg(newLayerId));
+    newLayer->setIndex(newLayerId);
+    newLayer->setParent(nullptr);
+    newLayer->setUndoStack(m_undoStack);
+    m_layers << newLayer;
+    return newLayer;
+  }
+}
+
 void ImageProcessor::buildMainImageLayer() {
   if ( !m_image.isNull() ) {
      LayerItem* newLayer = new LayerItem("MainImage",m_image);
@@ -94,25 +143,21 @@ bool ImageProcessor::process( const QString& filePath, bool forcedAlphaMasking,
 {
  qDebug() << "ImageProcessor::process(): filePath='" << filePath << "', forcedAlphaMasking =" << forcedAlphaMasking << ", processHistory =" << processHistory;
  { 
-    QFile f(filePath);
-    if ( !f.open(QIODevice::ReadOnly) ) {
-     qDebug() << LogColor::Red << "ImageProcessor::process(): Cannot open '" << filePath << "'!" << LogColor::Reset;
+    // single pass over the file, layer images stay base64 until they are used
+    ProjectModel project;
+    ProjectReader reader;
+    if ( !reader.read(filePath, project) ) {
+     qDebug() << LogColor::Red << "ImageProcessor::process(): Cannot read '" << filePath << "':" << reader.errorString() << LogColor::Reset;
      return false;
     }
-    m_jsonDocument = QJsonDocument::fromJson(f.readAll());
-    f.close();
-    if ( !m_jsonDocument.isObject() ) return false;
-    QJsonObject root = m_jsonDocument.object();
     
     // layers
     QJsonArray updatedLayers;
-    QJsonArray layerArray = root["layers"].toArray();
     if ( !m_skipMainImage ) {
       bool haveMainImage = false;
-      for ( const QJsonValue& v : layerArray ) {
-        QJsonObject layerObj = v.toObject();
-        QString name = layerObj["name"].toString();
-        int id = layerObj["id"].toInt();
+      for ( const ProjectLayer& projectLayer : project.layers() ) {
+        const QJsonObject& layerObj = projectLayer.json();
+        int id = projectLayer.id();
         if ( id == 0 ) {
           QString filename = layerObj["filename"].toString();
           QString pathname = layerObj["pathname"].toString();
@@ -137,35 +182,23 @@ bool ImageProcessor::process( const QString& filePath, bool forcedAlphaMasking,
     // loading layers
     qInfo() << "Processing layer stack...";
     int nCreatedLayers = m_layers.size();
-    for ( const QJsonValue& v : layerArray ) {
-     if ( v.isObject() ) {
-      QJsonObject layerObj = v.toObject();
-      QString name = layerObj["name"].toString();
-      int id = layerObj["id"].toInt();
+    for ( const ProjectLayer& projectLayer : project.layers() ) {
+      QJsonObject layerObj = projectLayer.json();
+      QString name = projectLayer.name();
+      int id = projectLayer.id();
       qInfo() << " " << name << ": id =" << id;
       if ( id != 0 ) {
-        if ( layerObj.contains("data") ) {
+        if ( projectLayer.hasData() ) {
          LayerItem* newLayer = nullptr;
-         QString imgBase64 = layerObj["data"].toString();
-         QByteArray ba = QByteArray::fromBase64(imgBase64.toUtf8());
          QImage mask;
-         mask.loadFromData(ba,"PNG");
+         mask.loadFromData(projectLayer.decode(),"PNG");
          bool isBinaryMask = layerObj.value("binaryMask").toBool(false);
          int x = layerObj.value("x").toInt(-1);
          int y = layerObj.value("y").toInt(-1);
-         if ( !(  x > 0 && y > 0 ) ) {
-           QJsonArray undoArray = root["undoStack"].toArray();
-           for ( const QJsonValue& v : undoArray ) {
-             QJsonObject cmdObj = v.toObject();
-             QString type = cmdObj["type"].toString();
-             if ( type == "LassoCut" || type == "LassoCutCommand" ) {
-               if( id == cmdObj["newLayerId"].toInt(-1) ) {
-                 QJsonObject r = cmdObj["rect"].toObject();
-                 x = r["x"].toInt();
-                 y = r["y"].toInt();
-               }
-             }
-           }
+         const QRect cutRect = project.cutRect(id);
+         if ( !(  x > 0 && y > 0 ) && !cutRect.isNull() ) {
+           x = cutRect.x();
+           y = cutRect.y();
          }
          QRect rect = QRect(x,y,mask.width(), mask.height());
          if ( isBinaryMask && x >= 0 && y >= 0 ) {
@@ -210,94 +243,97 @@ bool ImageProcessor::process( const QString& filePath, bool forcedAlphaMasking,
          newLayer->setIndex(id);
          newLayer->setParent(nullptr);
          newLayer->setUndoStack(m_undoStack);
+         newLayer->setRenderOpacity(layerObj.value("opacity").toDouble(1.0));
+         newLayer->setRenderVisible(layerObj.value("visible").toBool(true));
          m_layers << newLayer;
          nCreatedLayers += 1;
-         // build new json stack
-         if ( !isBinaryMask ) {
-          layerObj["data"] = newLayer->getAlphaMaskData();
-          layerObj["binaryMask"] = true;
-          layerObj["x"] = x;
-          layerObj["y"] = y;
+         // build new json stack, only needed for the output document
+         if ( !processHistory ) {
+          if ( isBinaryMask ) {
+           updatedLayers.append(projectLayer.toJson());
+          } else {
+           layerObj["data"] = newLayer->getAlphaMaskData();
+           layerObj["binaryMask"] = true;
+           layerObj["x"] = x;
+           layerObj["y"] = y;
+           updatedLayers.append(layerObj);
+          }
          }
-         updatedLayers.append(layerObj);  
         }
       }
-     } else {
-      updatedLayers.append(v);
-     }
     }
-    // loading undoStack
-    qInfo() << "Processing undo stack...";
-    QJsonArray updateUndoStack;
-    QJsonArray undoStack = root["undoStack"].toArray();
-    for ( const QJsonValue& v : undoStack ) {
-     if ( v.isObject() ) {
-      QJsonObject layerObj = v.toObject();
-      QString name = layerObj["text"].toString();
-      QString type = layerObj["type"].toString();
-      if ( type == "CageWarp" ) {
-       QJsonObject topLeft = layerObj["topLeft_after"].toObject();
-       double x = topLeft["x"].toDouble();
-       double y = topLeft["y"].toDouble();
-       qInfo() << " " << name << ": type =" << type << ", topLeftPos = (" << x << ":" << y << ")";
-       topLeft["x"] = qRound(x);
-       topLeft["y"] = qRound(y);
-       layerObj["topLeft_after"] = topLeft;
-      } else if ( type == "MoveLayer" ) {
-       double fromX = layerObj["fromX"].toDouble();
-       double fromY = layerObj["fromY"].toDouble();
-       double toX = layerObj["toX"].toDouble();
-       double toY = layerObj["toY"].toDouble();
-       qInfo() << " " << name << ": type =" << type << ", from (" << fromX << ":" << fromY << ") to (" << toX << ":" << toY << ")";
-       layerObj["fromX"] = qRound(fromX);
-       layerObj["fromY"] = qRound(fromY);
-       layerObj["toX"] = qRound(toX);
-       layerObj["toY"] = qRound(toY);
-      } else {
-       qInfo() << " " << name << ": type =" << type;
+    // output: undoStack with rounded positions
+    if ( !processHistory ) {
+     qInfo() << "Processing undo stack...";
+     QJsonArray updateUndoStack;
+     for ( const QJsonValue& v : project.undoStack() ) {
+      if ( v.isObject() ) {
+       QJsonObject layerObj = v.toObject();
+       QString name = layerObj["text"].toString();
+       QString type = layerObj["type"].toString();
+       if ( type == "CageWarp" ) {
+        QJsonObject topLeft = layerObj["topLeft_after"].toObject();
+        double x = topLeft["x"].toDouble();
+        double y = topLeft["y"].toDouble();
+        qInfo() << " " << name << ": type =" << type << ", topLeftPos = (" << x << ":" << y << ")";
+        topLeft["x"] = qRound(x);
+        topLeft["y"] = qRound(y);
+        layerObj["topLeft_after"] = topLeft;
+       } else if ( type == "MoveLayer" ) {
+        double fromX = layerObj["fromX"].toDouble();
+        double fromY = layerObj["fromY"].toDouble();
+        double toX = layerObj["toX"].toDouble();
+        double toY = layerObj["toY"].toDouble();
+        qInfo() << " " << name << ": type =" << type << ", from (" << fromX << ":" << fromY << ") to (" << toX << ":" << toY << ")";
+        layerObj["fromX"] = qRound(fromX);
+        layerObj["fromY"] = qRound(fromY);
+        layerObj["toX"] = qRound(toX);
+        layerObj["toY"] = qRound(toY);
+       } else {
+        qInfo() << " " << name << ": type =" << type;
+       }
+       updateUndoStack.append(layerObj);
       }
-      updateUndoStack.append(layerObj);
      }
-    }
-    // output
-    if ( !processHistory ) {
-      root["layers"] = updatedLayers;
-      root["undoStack"] = updateUndoStack;
-      m_jsonDocument.setObject(root);
-      return true;
+     QJsonObject root = project.header();
+     root["layers"] = updatedLayers;
+     root["undoStack"] = updateUndoStack;
+     m_jsonDocument.setObject(root);
+     return true;
     }
   
     // --- Restore Undo/Redo Stack ---
     int nStep = 1;
     QString infoTextLines = "";
-    QJsonArray undoArray = root["undoStack"].toArray();
+    const QJsonArray& undoArray = project.undoStack();
+    CommandRegistry& registry = CommandRegistry::instance();
+    const int lassoCutType = registry.typeId("LassoCut");
     for ( const QJsonValue& v : undoArray ) {
       QJsonObject cmdObj = v.toObject();
       QString type = cmdObj["type"].toString();
       QString text = cmdObj["text"].toString();
       qDebug() << "ImageProcessor::process(): Processing undo call: type=" << type << ", text=" << text;
       if ( processHistory ) { 
-        AbstractCommand* cmd = nullptr;
-        if ( type == "PaintStroke" || type == "PaintStrokeCommand" ) {
-           cmd = PaintStrokeCommand::fromJson(cmdObj, m_layers);
-        } else if ( type == "LassoCut" || type == "LassoCutCommand" ) {
-           cmd = LassoCutCommand::fromJson(cmdObj, m_layers);
-        } else if ( type == "MoveLayer" || type == "MoveLayerCommand" ) {
-           cmd = MoveLayerCommand::fromJson(cmdObj, m_layers);
-        } else if ( type == "MirrorLayer" || type == "MirrorLayerCommand" ) {
-           cmd = MirrorLayerCommand::fromJson(cmdObj, m_layers);
-        } else if ( type == "CageWarp" || type == "CageWarpCommand" ) {
-           cmd = CageWarpCommand::fromJson(cmdObj, m_layers);
-        } else if ( type == "TransformLayer" || type == "TransformLayerCommand" ) {
-           cmd = TransformLayerCommand::fromJson(cmdObj, m_layers);
-        } else if ( type == "PerspectiveWarp" || type == "PerspectiveWarpCommand" ) {
-           cmd = PerspectiveWarpCommand::fromJson(cmdObj, m_layers);
-        } else if ( type == "DeleteUndoEntry" || type == "DeleteUndoEntryCommand" ) {
-           cmd = DeleteUndoEntryCommand::fromJson(m_undoStack, cmdObj, m_layers);
-        } else {
+        const int typeId = registry.typeId(type);
+        if ( typeId < 0 ) {
            qDebug() << LogColor::Red << "ImageProcessor::process(): Command " << type << " not yet processed." << LogColor::Reset;
+           nStep += 1;
+           continue;
+        }
+        if ( typeId == lassoCutType && AbstractCommand::getLayerItem(m_layers, cmdObj["newLayerId"].toInt(-1)) == nullptr ) {
+           buildPolygonCutLayer(cmdObj);
+        }
+        // the layers have no scene: polygon models and their edit history
+        // (PolygonMovePoint, PolygonSmooth, ...) are replayed without a view item
+        CommandRegistry::Context context;
+        context.layers = m_layers;
+        context.undoStack = m_undoStack;
+        AbstractCommand* cmd = registry.create(cmdObj, context);
+        if ( LassoCutCommand* cutCommand = dynamic_cast<LassoCutCommand*>(cmd) ) {
+           cutCommand->setController(polygonOfCut(cutCommand->layerId()));
+        } else if ( EditablePolygonCommand* polyCmd = dynamic_cast<EditablePolygonCommand*>(cmd) ) {
+           m_polygonCommands << polyCmd;
         }
-        // ggf. weitere Command-Typen hier hinzufügen
         if ( cmd ) {
             m_undoStack->push(cmd);
             infoTextLines += saveIntermediate(cmd,type,nStep);
@@ -339,13 +375,14 @@ bool ImageProcessor::process( const QString& filePath, bool forcedAlphaMasking,
        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
        for ( auto* item : sortedLayers ) {
         auto* layer = dynamic_cast<LayerItem*>(item);
-        if ( layer && layer->id() != 0 ) {
+        if ( layer && layer->id() != 0 && layer->isRendered() ) {
          QImage overlayImage = layer->image();
          if ( !overlayImage.isNull() ) {
           int x = static_cast<int>(layer->pos().x());
           int y = static_cast<int>(layer->pos().y());     
           qInfo() << " + drawing layer =" << layer->name() << ": size =" 
                     << overlayImage.width() << "x" << overlayImage.height();   
+          painter.setOpacity(layer->renderState().opacity);
           painter.drawImage(x, y, overlayImage);
          }
         }
@@ -356,13 +393,14 @@ bool ImageProcessor::process( const QString& filePath, bool forcedAlphaMasking,
        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
        for ( auto* item : m_layers ) {
         auto* layer = dynamic_cast<LayerItem*>(item);
-        if ( layer && layer->id() != 0 ) {
+        if ( layer && layer->id() != 0 && layer->isRendered() ) {
          QImage overlayImage = layer->image();
          if ( !overlayImage.isNull() ) {
           int x = layer->pos().x();
           int y = layer->pos().y();
           qInfo() << " + drawing layer =" << layer->name() << ": id =" << layer->id( )<< ", pos =" 
                << layer->pos() << ", rect =" << layer->boundingRect();
+          painter.setOpacity(layer->renderState().opacity);
           painter.drawImage(x, y, overlayImage);
          }
         }
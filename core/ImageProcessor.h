@@ -25,6 +25,7 @@
 
 // --- ---
 class AbstractCommand;
+class EditablePolygonCommand;
 class LayerItem;
 
 // -------------------------- ImageProcessor --------------------------
@@ -48,6 +49,8 @@ class ImageProcessor {
  private:
 
     QString saveIntermediate( AbstractCommand *cmd, const QString &name, int step );
+    EditablePolygonCommand* polygonOfCut( int newLayerId ) const;
+    LayerItem* buildPolygonCutLayer( const QJsonObject& cmdObj );
 
     bool m_skipMainImage = false;
     bool m_saveIntermediate = false;
@@ -63,6 +66,7 @@ class ImageProcessor {
     QUndoStack* m_undoStack = nullptr;
     
     QList<LayerItem*> m_layers;
+    QList<EditablePolygonCommand*> m_polygonCommands;   // replayed without view items
     
     void buildMainImageLayer();
 
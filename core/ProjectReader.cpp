@@ -0,0 +1,340 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "ProjectReader.h"
+#include "../undo/CommandRegistry.h"
+
+#include <QDebug>
+#include <QFile>
+
+// -------------------------- ProjectLayer --------------------------
+QByteArray ProjectLayer::decode() const
+{
+  if ( !hasData() )
+    return QByteArray();
+  return QByteArray::fromBase64(QByteArray::fromRawData(m_buffer.constData() + m_offset, m_length));
+}
+
+QJsonObject ProjectLayer::toJson() const
+{
+  QJsonObject obj = m_json;
+  if ( hasData() ) {
+    obj.insert("data", QString::fromLatin1(m_buffer.constData() + m_offset, m_length));
+  }
+  return obj;
+}
+
+// -------------------------- ProjectReader --------------------------
+bool ProjectReader::read( const QString& filePath, ProjectModel& model )
+{
+  QFile f(filePath);
+  if ( !f.open(QIODevice::ReadOnly) ) {
+    m_error = f.errorString();
+    qWarning() << "ProjectReader::read(): Cannot open" << filePath << ":" << m_error;
+    return false;
+  }
+  return parse(f.readAll(), model);
+}
+
+bool ProjectReader::parse( const QByteArray& data, ProjectModel& model )
+{
+  m_data = data;
+  m_begin = m_data.constData();
+  m_pos = m_begin;
+  m_end = m_begin + m_data.size();
+  m_error.clear();
+  model = ProjectModel();
+  if ( !parseRoot(model) ) {
+    qWarning() << "ProjectReader::parse():" << m_error;
+    return false;
+  }
+  return true;
+}
+
+bool ProjectReader::fail( const char* message )
+{
+  if ( m_error.isEmpty() ) {
+    m_error = QString("%1 at offset %2").arg(message).arg(m_pos - m_begin);
+  }
+  return false;
+}
+
+void ProjectReader::skipSpace()
+{
+  while ( m_pos < m_end && ( *m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t' ) ) {
+    ++m_pos;
+  }
+}
+
+bool ProjectReader::expect( char c )
+{
+  skipSpace();
+  if ( m_pos < m_end && *m_pos == c ) {
+    ++m_pos;
+    return true;
+  }
+  return false;
+}
+
+bool ProjectReader::parseRoot( ProjectModel& model )
+{
+  if ( !expect('{') )
+    return fail("Project file is not a JSON object");
+  CommandRegistry& registry = CommandRegistry::instance();
+  const int lassoCutType = registry.typeId("LassoCut");
+  if ( !expect('}') ) {
+    do {
+      QString key;
+      if ( !parseString(key) ) return false;
+      if ( !expect(':') ) return fail("Missing ':'");
+      if ( key == "layers" ) {
+        if ( !expect('[') ) return fail("'layers' is not an array");
+        if ( !expect(']') ) {
+          do {
+            ProjectLayer layer;
+            if ( !parseLayer(layer) ) return false;
+            model.m_layers.append(layer);
+          } while ( expect(',') );
+          if ( !expect(']') ) return fail("Missing ']'");
+        }
+      } else if ( key == "undoStack" ) {
+        if ( !expect('[') ) return fail("'undoStack' is not an array");
+        if ( !expect(']') ) {
+          do {
+            QJsonValue v;
+            if ( !parseValue(v) ) return false;
+            const QJsonObject cmdObj = v.toObject();
+            if ( lassoCutType >= 0 && registry.typeId(cmdObj) == lassoCutType ) {
+              const QJsonObject r = cmdObj.value("rect").toObject();
+              model.m_cutRects.insert(cmdObj.value("newLayerId").toInt(-1),
+                                      QRect(r.value("x").toInt(), r.value("y").toInt(), r.value("width").toInt(), r.value("height").toInt()));
+            }
+            model.m_undoStack.append(v);
+          } while ( expect(',') );
+          if ( !expect(']') ) return fail("Missing ']'");
+        }
+      } else {
+        QJsonValue v;
+        if ( !parseValue(v) ) return false;
+        model.m_header.insert(key, v);
+      }
+    } while ( expect(',') );
+    if ( !expect('}') ) return fail("Missing '}'");
+  }
+  skipSpace();
+  if ( m_pos != m_end )
+    return fail("Unexpected data after the project object");
+  return true;
+}
+
+bool ProjectReader::parseLayer( ProjectLayer& layer )
+{
+  if ( !expect('{') )
+    return fail("Layer is not a JSON object");
+  if ( expect('}') )
+    return true;
+  do {
+    QString key;
+    if ( !parseString(key) ) return false;
+    if ( !expect(':') ) return fail("Missing ':'");
+    skipSpace();
+    if ( key == "data" && m_pos < m_end && *m_pos == '"' ) {
+      // base64 text stays in the file buffer, escapes (e.g. "\/") need a copy
+      const char* start = m_pos;
+      bool escaped = false;
+      if ( !scanString(layer.m_offset, layer.m_length, escaped) ) return false;
+      layer.m_buffer = m_data;
+      if ( escaped ) {
+        m_pos = start;
+        QString text;
+        if ( !parseString(text) ) return false;
+        layer.m_buffer = text.toLatin1();
+        layer.m_offset = 0;
+        layer.m_length = layer.m_buffer.size();
+      }
+    } else {
+      QJsonValue v;
+      if ( !parseValue(v) ) return false;
+      layer.m_json.insert(key, v);
+    }
+  } while ( expect(',') );
+  if ( !expect('}') ) return fail("Missing '}'");
+  return true;
+}
+
+bool ProjectReader::parseValue( QJsonValue& value, int depth )
+{
+  if ( depth > 256 )
+    return fail("JSON nested too deeply");
+  skipSpace();
+  if ( m_pos >= m_end )
+    return fail("Unexpected end of file");
+  switch ( *m_pos ) {
+    case '{': {
+      ++m_pos;
+      QJsonObject obj;
+      if ( !expect('}') ) {
+        do {
+          QString key;
+          if ( !parseString(key) ) return false;
+          if ( !expect(':') ) return fail("Missing ':'");
+          QJsonValue v;
+          if ( !parseValue(v, depth + 1) ) return false;
+          obj.insert(key, v);
+        } while ( expect(',') );
+        if ( !expect('}') ) return fail("Missing '}'");
+      }
+      value = obj;
+      return true;
+    }
+    case '[': {
+      ++m_pos;
+      QJsonArray arr;
+      if ( !expect(']') ) {
+        do {
+          QJsonValue v;
+          if ( !parseValue(v, depth + 1) ) return false;
+          arr.append(v);
+        } while ( expect(',') );
+        if ( !expect(']') ) return fail("Missing ']'");
+      }
+      value = arr;
+      return true;
+    }
+    case '"': {
+      QString text;
+      if ( !parseString(text) ) return false;
+      value = text;
+      return true;
+    }
+    case 't':
+      if ( m_end - m_pos >= 4 && qstrncmp(m_pos, "true", 4) == 0 ) { m_pos += 4; value = true; return true; }
+      return fail("Invalid literal");
+    case 'f':
+      if ( m_end - m_pos >= 5 && qstrncmp(m_pos, "false", 5) == 0 ) { m_pos += 5; value = false; return true; }
+      return fail("Invalid literal");
+    case 'n':
+      if ( m_end - m_pos >= 4 && qstrncmp(m_pos, "null", 4) == 0 ) { m_pos += 4; value = QJsonValue(QJsonValue::Null); return true; }
+      return fail("Invalid literal");
+    default:
+      return parseNumber(value);
+  }
+}
+
+bool ProjectReader::scanString( qsizetype& offset, qsizetype& length, bool& escaped )
+{
+  if ( m_pos >= m_end || *m_pos != '"' )
+    return fail("Expected string");
+  const char* start = ++m_pos;
+  escaped = false;
+  while ( m_pos < m_end ) {
+    if ( *m_pos == '\\' ) {
+      escaped = true;
+      m_pos += 2;
+      continue;
+    }
+    if ( *m_pos == '"' ) {
+      offset = start - m_begin;
+      length = m_pos - start;
+      ++m_pos;
+      return true;
+    }
+    ++m_pos;
+  }
+  return fail("Unterminated string");
+}
+
+bool ProjectReader::parseString( QString& text )
+{
+  skipSpace();
+  if ( m_pos >= m_end || *m_pos != '"' )
+    return fail("Expected string");
+  ++m_pos;
+  text.clear();
+  const char* chunk = m_pos;
+  while ( m_pos < m_end ) {
+    const char c = *m_pos;
+    if ( c == '"' ) {
+      text += QString::fromUtf8(chunk, m_pos - chunk);
+      ++m_pos;
+      return true;
+    }
+    if ( c != '\\' ) {
+      ++m_pos;
+      continue;
+    }
+    text += QString::fromUtf8(chunk, m_pos - chunk);
+    if ( m_end - m_pos < 2 )
+      break;
+    const char e = m_pos[1];
+    m_pos += 2;
+    switch ( e ) {
+      case '"':  text += QLatin1Char('"'); break;
+      case '\\': text += QLatin1Char('\\'); break;
+      case '/':  text += QLatin1Char('/'); break;
+      case 'b':  text += QLatin1Char('\b'); break;
+      case 'f':  text += QLatin1Char('\f'); break;
+      case 'n':  text += QLatin1Char('\n'); break;
+      case 'r':  text += QLatin1Char('\r'); break;
+      case 't':  text += QLatin1Char('\t'); break;
+      case 'u': {
+        // UTF-16 code unit, surrogate pairs arrive as two escapes
+        bool ok = false;
+        const ushort unit = ( m_end - m_pos >= 4 ) ? QByteArray(m_pos, 4).toUShort(&ok, 16) : 0;
+        if ( !ok ) return fail("Invalid \\u escape");
+        text += QChar(unit);
+        m_pos += 4;
+        break;
+      }
+      default:
+        return fail("Invalid escape sequence");
+    }
+    chunk = m_pos;
+  }
+  return fail("Unterminated string");
+}
+
+bool ProjectReader::parseNumber( QJsonValue& value )
+{
+  const char* start = m_pos;
+  bool integral = true;
+  while ( m_pos < m_end ) {
+    const char c = *m_pos;
+    if ( c == '.' || c == 'e' || c == 'E' ) {
+      integral = false;
+    } else if ( !( ( c >= '0' && c <= '9' ) || c == '-' || c == '+' ) ) {
+      break;
+    }
+    ++m_pos;
+  }
+  if ( m_pos == start )
+    return fail("Unexpected character");
+  const QByteArray token = QByteArray::fromRawData(start, m_pos - start);
+  bool ok = false;
+  if ( integral ) {
+    const qint64 v = token.toLongLong(&ok);
+    if ( ok ) {
+      value = QJsonValue(v);
+      return true;
+    }
+  }
+  const double v = token.toDouble(&ok);
+  if ( !ok )
+    return fail("Invalid number");
+  value = v;
+  return true;
+}
@@ -0,0 +1,110 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QRect>
+#include <QString>
+#include <QVector>
+
+// -------------------------- ProjectLayer --------------------------
+// Layer entry of a project file. The embedded image ("data") is kept as a
+// view on the base64 text in the file buffer and only decoded on request.
+class ProjectLayer {
+
+public:
+
+    int id() const { return m_json.value("id").toInt(); }
+    QString name() const { return m_json.value("name").toString(); }
+    const QJsonObject& json() const { return m_json; }   // all members except "data"
+
+    bool hasData() const { return m_length > 0; }
+    QByteArray decode() const;          // image file bytes (PNG), safe to call from worker threads
+    QJsonObject toJson() const;         // json() with the base64 "data" member restored
+
+private:
+
+    friend class ProjectReader;
+
+    QJsonObject m_json;
+    QByteArray m_buffer;                // shared file buffer (or an unescaped copy)
+    qsizetype m_offset = 0;
+    qsizetype m_length = 0;
+
+};
+
+// -------------------------- ProjectModel --------------------------
+class ProjectModel {
+
+public:
+
+    const QJsonObject& header() const { return m_header; }   // top level members besides layers and undoStack
+    const QVector<ProjectLayer>& layers() const { return m_layers; }
+    const QJsonArray& undoStack() const { return m_undoStack; }
+
+    // rect of the LassoCut which created the layer, null if there is none
+    QRect cutRect( int newLayerId ) const { return m_cutRects.value(newLayerId); }
+
+private:
+
+    friend class ProjectReader;
+
+    QJsonObject m_header;
+    QVector<ProjectLayer> m_layers;
+    QJsonArray m_undoStack;
+    QHash<int, QRect> m_cutRects;       // newLayerId -> rect of its cut
+
+};
+
+// -------------------------- ProjectReader --------------------------
+// Reads a project file in a single pass over the file buffer, without
+// building a QJsonDocument of the whole file. Layer payloads are not copied,
+// undo commands become small QJsonObjects and LassoCut rects are indexed on
+// the way.
+class ProjectReader {
+
+public:
+
+    bool read( const QString& filePath, ProjectModel& model );
+    bool parse( const QByteArray& data, ProjectModel& model );
+
+    QString errorString() const { return m_error; }
+
+private:
+
+    bool fail( const char* message );
+    void skipSpace();
+    bool expect( char c );
+
+    bool parseRoot( ProjectModel& model );
+    bool parseLayer( ProjectLayer& layer );
+    bool parseValue( QJsonValue& value, int depth = 0 );
+    bool parseString( QString& text );
+    bool scanString( qsizetype& offset, qsizetype& length, bool& escaped );
+    bool parseNumber( QJsonValue& value );
+
+    QByteArray m_data;
+    const char* m_begin = nullptr;
+    const char* m_pos = nullptr;
+    const char* m_end = nullptr;
+    QString m_error;
+
+};
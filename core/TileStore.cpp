@@ -0,0 +1,347 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "TileStore.h"
+#include "../util/Compress.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QMutexLocker>
+#include <QPainter>
+
+#include <cstring>
+
+std::atomic<qint64> TileStore::s_bytes{0};
+std::atomic<int> TileStore::s_tiles{0};
+std::atomic<qint64> UndoSpill::s_bytes{0};
+std::atomic<int> UndoSpill::s_records{0};
+
+// -------------------------- Tile --------------------------
+TileStore::Tile::Tile( const QImage& img, size_t h ) : image(img), hash(h)
+{
+  bytes = image.sizeInBytes();
+  TileStore::s_bytes += bytes;
+  TileStore::s_tiles += 1;
+}
+
+TileStore::Tile::~Tile()
+{
+  TileStore::s_bytes -= bytes;
+  TileStore::s_tiles -= 1;
+}
+
+// -------------------------- TileStore --------------------------
+TileStore& TileStore::instance()
+{
+  static TileStore store;
+  return store;
+}
+
+size_t TileStore::contentHash( const QImage& tile )
+{
+  const qsizetype lineBytes = (qsizetype(tile.width()) * tile.depth() + 7) / 8;
+  size_t h = qHash(tile.width()) ^ (qHash(tile.height()) << 1) ^ (qHash(int(tile.format())) << 2);
+  for ( int y = 0; y < tile.height(); ++y ) {
+    h = qHashBits(tile.constScanLine(y), size_t(lineBytes), h);
+  }
+  return h;
+}
+
+bool TileStore::sameContent( const QImage& a, const QImage& b )
+{
+  if ( a.size() != b.size() || a.format() != b.format() )
+    return false;
+  const size_t lineBytes = (size_t(a.width()) * a.depth() + 7) / 8;
+  for ( int y = 0; y < a.height(); ++y ) {
+    if ( std::memcmp(a.constScanLine(y), b.constScanLine(y), lineBytes) != 0 )
+      return false;
+  }
+  return true;
+}
+
+TileStore::TilePtr TileStore::intern( const QImage& tile )
+{
+  const size_t h = contentHash(tile);
+  QMutexLocker locker(&m_mutex);
+  QList<std::weak_ptr<const Tile>>& bucket = m_index[h];
+  for ( auto it = bucket.begin(); it != bucket.end(); ) {
+    TilePtr existing = it->lock();
+    if ( !existing ) {
+      it = bucket.erase(it);
+      continue;
+    }
+    if ( sameContent(existing->image, tile) )
+      return existing;
+    ++it;
+  }
+  // QImage is copy on write, later changes of the caller's image detach
+  TilePtr created = std::make_shared<const Tile>(tile, h);
+  bucket.append(created);
+  if ( ++m_internCount % 4096 == 0 ) {
+    purge();
+  }
+  return created;
+}
+
+void TileStore::purge()
+{
+  for ( auto it = m_index.begin(); it != m_index.end(); ) {
+    QList<std::weak_ptr<const Tile>>& bucket = it.value();
+    bucket.removeIf([](const std::weak_ptr<const Tile>& w){ return w.expired(); });
+    if ( bucket.isEmpty() ) {
+      it = m_index.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+// -------------------------- UndoSpill --------------------------
+UndoSpill::Record::~Record()
+{
+  UndoSpill::instance().release(*this);
+}
+
+UndoSpill& UndoSpill::instance()
+{
+  static UndoSpill spill;
+  return spill;
+}
+
+UndoSpill::RecordPtr UndoSpill::write( const QByteArray& data )
+{
+  QMutexLocker locker(&m_mutex);
+  if ( !m_file.isOpen() ) {
+    m_file.setFileTemplate(QDir::tempPath() + "/imageeditor-undo-XXXXXX.spill");
+    if ( !m_file.open() ) {
+      qWarning() << "UndoSpill::write(): Cannot open spill file:" << m_file.errorString();
+      return nullptr;
+    }
+  }
+  const qint64 offset = m_file.size();
+  if ( !m_file.seek(offset) || m_file.write(data) != data.size() ) {
+    qWarning() << "UndoSpill::write(): Cannot write" << data.size() << "bytes to" << m_file.fileName();
+    return nullptr;
+  }
+  auto record = std::make_shared<Record>();
+  record->offset = offset;
+  record->size = data.size();
+  s_bytes += record->size;
+  s_records += 1;
+  return record;
+}
+
+QByteArray UndoSpill::read( const Record& record )
+{
+  QMutexLocker locker(&m_mutex);
+  if ( !m_file.isOpen() || !m_file.seek(record.offset) ) {
+    qWarning() << "UndoSpill::read(): Cannot seek to" << record.offset;
+    return QByteArray();
+  }
+  QByteArray data = m_file.read(record.size);
+  if ( data.size() != record.size ) {
+    qWarning() << "UndoSpill::read(): Short read," << data.size() << "of" << record.size << "bytes";
+    return QByteArray();
+  }
+  return data;
+}
+
+void UndoSpill::release( const Record& record )
+{
+  QMutexLocker locker(&m_mutex);
+  s_bytes -= record.size;
+  if ( --s_records == 0 && m_file.isOpen() ) {
+    m_file.resize(0);
+  }
+}
+
+// -------------------------- TileSnapshot --------------------------
+TileSnapshot::TileSnapshot( const QImage& source, const QRect& region )
+{
+  if ( source.isNull() )
+    return;
+  // tiles are compared bytewise, palette and bit packed formats are expanded
+  const QImage image = ( source.depth() < 8 || source.format() == QImage::Format_Indexed8 )
+                        ? source.convertToFormat(QImage::Format_ARGB32) : source;
+  m_imageSize = image.size();
+  m_format = image.format();
+  m_rect = region.isNull() ? image.rect() : (region & image.rect());
+  if ( m_rect.isEmpty() )
+    return;
+  const int ts = TileStore::TileSize;
+  const int c0 = m_rect.left() / ts;
+  const int r0 = m_rect.top() / ts;
+  const int c1 = m_rect.right() / ts;
+  const int r1 = m_rect.bottom() / ts;
+  m_tileRange = QRect(QPoint(c0, r0), QPoint(c1, r1));
+  m_tiles.reserve(m_tileRange.width() * m_tileRange.height());
+  TileStore& store = TileStore::instance();
+  for ( int r = r0; r <= r1; ++r ) {
+    for ( int c = c0; c <= c1; ++c ) {
+      const QRect tileRect = QRect(c * ts, r * ts, ts, ts) & image.rect();
+      // copy() detaches only the tile area, interning may drop it again
+      m_tiles.append(store.intern(image.copy(tileRect)));
+    }
+  }
+}
+
+QImage TileSnapshot::image() const
+{
+  rehydrate();
+  if ( isNull() || m_spilled )
+    return QImage();
+  QImage result(m_rect.size(), m_format);
+  const int ts = TileStore::TileSize;
+  const int bpp = result.depth() / 8;
+  for ( int r = m_tileRange.top(); r <= m_tileRange.bottom(); ++r ) {
+    for ( int c = m_tileRange.left(); c <= m_tileRange.right(); ++c ) {
+      const QImage& tile = m_tiles[(r - m_tileRange.top()) * m_tileRange.width() + (c - m_tileRange.left())]->image;
+      const QRect tileRect(c * ts, r * ts, tile.width(), tile.height());
+      const QRect part = tileRect & m_rect;
+      for ( int y = part.top(); y <= part.bottom(); ++y ) {
+        const uchar* src = tile.constScanLine(y - tileRect.top()) + (part.left() - tileRect.left()) * bpp;
+        uchar* dst = result.scanLine(y - m_rect.top()) + (part.left() - m_rect.left()) * bpp;
+        std::memcpy(dst, src, size_t(part.width()) * bpp);
+      }
+    }
+  }
+  return result;
+}
+
+void TileSnapshot::restore( QImage& target ) const
+{
+  rehydrate();
+  if ( isNull() || m_spilled || target.isNull() )
+    return;
+  if ( target.format() != m_format || target.depth() < 8 ) {
+    QPainter painter(&target);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage(m_rect.topLeft(), image());
+    painter.end();
+    return;
+  }
+  const int ts = TileStore::TileSize;
+  const int bpp = target.depth() / 8;
+  const QRect area = m_rect & target.rect();
+  for ( int r = m_tileRange.top(); r <= m_tileRange.bottom(); ++r ) {
+    for ( int c = m_tileRange.left(); c <= m_tileRange.right(); ++c ) {
+      const QImage& tile = m_tiles[(r - m_tileRange.top()) * m_tileRange.width() + (c - m_tileRange.left())]->image;
+      const QRect tileRect(c * ts, r * ts, tile.width(), tile.height());
+      const QRect part = tileRect & area;
+      for ( int y = part.top(); y <= part.bottom(); ++y ) {
+        const uchar* src = tile.constScanLine(y - tileRect.top()) + (part.left() - tileRect.left()) * bpp;
+        std::memcpy(target.scanLine(y) + part.left() * bpp, src, size_t(part.width()) * bpp);
+      }
+    }
+  }
+}
+
+qint64 TileSnapshot::byteCount() const
+{
+  qint64 bytes = 0;
+  for ( const TileStore::TilePtr& tile : m_tiles ) {
+    bytes += tile->bytes;
+  }
+  return bytes;
+}
+
+void TileSnapshot::collectTiles( QSet<const void*>& tiles, qint64& bytes ) const
+{
+  for ( const TileStore::TilePtr& tile : m_tiles ) {
+    if ( !tiles.contains(tile.get()) ) {
+      tiles.insert(tile.get());
+      bytes += tile->bytes;
+    }
+  }
+}
+
+qint64 TileSnapshot::addTiles( QHash<const void*,int>& refs ) const
+{
+  qint64 bytes = 0;
+  for ( const TileStore::TilePtr& tile : m_tiles ) {
+    if ( refs[tile.get()]++ == 0 )
+      bytes += tile->bytes;
+  }
+  return bytes;
+}
+
+qint64 TileSnapshot::removeTiles( QHash<const void*,int>& refs ) const
+{
+  qint64 bytes = 0;
+  for ( const TileStore::TilePtr& tile : m_tiles ) {
+    auto it = refs.find(tile.get());
+    if ( it == refs.end() )
+      continue;
+    if ( --it.value() == 0 ) {
+      refs.erase(it);
+      bytes += tile->bytes;
+    }
+  }
+  return bytes;
+}
+
+bool TileSnapshot::spill() const
+{
+  if ( isNull() || m_spilled )
+    return false;
+  if ( !m_spill ) {
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << qint32(m_tiles.size());
+    for ( const TileStore::TilePtr& tile : m_tiles ) {
+      out << CompressUtils::toCompressedRaw(tile->image);
+    }
+    m_spill = UndoSpill::instance().write(payload);
+    if ( !m_spill )
+      return false;
+  }
+  m_tiles.clear();
+  m_tiles.squeeze();
+  m_spilled = true;
+  return true;
+}
+
+void TileSnapshot::rehydrate() const
+{
+  if ( !m_spilled || !m_spill )
+    return;
+  const QByteArray payload = UndoSpill::instance().read(*m_spill);
+  QDataStream in(payload);
+  qint32 count = 0;
+  in >> count;
+  if ( count != m_tileRange.width() * m_tileRange.height() ) {
+    qWarning() << "TileSnapshot::rehydrate(): Spilled snapshot is corrupt, expected"
+               << m_tileRange.width() * m_tileRange.height() << "tiles, got" << count;
+    return;
+  }
+  QVector<TileStore::TilePtr> tiles;
+  tiles.reserve(count);
+  TileStore& store = TileStore::instance();
+  for ( int i = 0; i < count; ++i ) {
+    QByteArray data;
+    in >> data;
+    const QImage tile = CompressUtils::fromCompressedRaw(data);
+    if ( tile.isNull() ) {
+      qWarning() << "TileSnapshot::rehydrate(): Cannot decode tile" << i;
+      return;
+    }
+    tiles.append(store.intern(tile));
+  }
+  m_tiles = tiles;
+  m_spilled = false;
+}
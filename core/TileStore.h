@@ -0,0 +1,156 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QRect>
+#include <QSet>
+#include <QTemporaryFile>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+// -------------------------- TileStore --------------------------
+// Process wide pool of immutable 256x256 pixel tiles. Tiles with identical
+// content are interned once and shared (refcounted) by every snapshot which
+// references them, so unchanged parts of a layer cost nothing in later undo
+// states.
+class TileStore {
+
+public:
+
+    static constexpr int TileSize = 256;
+
+    struct Tile {
+      explicit Tile( const QImage& img, size_t h );
+      ~Tile();
+      QImage image;
+      size_t hash = 0;
+      qint64 bytes = 0;
+    };
+    using TilePtr = std::shared_ptr<const Tile>;
+
+    static TileStore& instance();
+
+    TilePtr intern( const QImage& tile );
+
+    qint64 bytes() const { return s_bytes.load(); }
+    int tileCount() const { return s_tiles.load(); }
+
+private:
+
+    TileStore() = default;
+
+    static size_t contentHash( const QImage& tile );
+    static bool sameContent( const QImage& a, const QImage& b );
+    void purge();
+
+    static std::atomic<qint64> s_bytes;
+    static std::atomic<int> s_tiles;
+
+    QMutex m_mutex;
+    QHash<size_t, QList<std::weak_ptr<const Tile>>> m_index;
+    int m_internCount = 0;
+
+};
+
+// -------------------------- UndoSpill --------------------------
+// Append only temporary file holding compressed snapshots which were moved
+// out of memory. A record releases its bytes when the last snapshot using
+// it is destroyed, the file is truncated once no record is alive.
+class UndoSpill {
+
+public:
+
+    struct Record {
+      ~Record();
+      qint64 offset = 0;
+      qint64 size = 0;
+    };
+    using RecordPtr = std::shared_ptr<const Record>;
+
+    static UndoSpill& instance();
+
+    RecordPtr write( const QByteArray& data );
+    QByteArray read( const Record& record );
+
+    qint64 bytes() const { return s_bytes.load(); }
+    int recordCount() const { return s_records.load(); }
+
+private:
+
+    UndoSpill() = default;
+
+    void release( const Record& record );
+
+    static std::atomic<qint64> s_bytes;
+    static std::atomic<int> s_records;
+
+    QMutex m_mutex;
+    QTemporaryFile m_file;
+
+};
+
+// -------------------------- TileSnapshot --------------------------
+// Copy of an image (or a region of it) stored as shared tiles on the global
+// tile grid. Copying a snapshot is O(number of tiles) and never copies pixels.
+class TileSnapshot {
+
+public:
+
+    TileSnapshot() = default;
+    explicit TileSnapshot( const QImage& source, const QRect& region = QRect() );
+
+    bool isNull() const { return m_rect.isEmpty(); }
+    QRect rect() const { return m_rect; }
+    QSize imageSize() const { return m_imageSize; }
+    QImage::Format format() const { return m_format; }
+
+    QImage image() const;               // pixels of rect() as a new image
+    void restore( QImage& target ) const;  // writes rect() back into target
+
+    qint64 byteCount() const;           // pixel bytes referenced by this snapshot
+    void collectTiles( QSet<const void*>& tiles, qint64& bytes ) const;
+    // reference counted bookkeeping over several snapshots: addTiles returns
+    // the bytes of tiles seen for the first time, removeTiles those released
+    qint64 addTiles( QHash<const void*,int>& refs ) const;
+    qint64 removeTiles( QHash<const void*,int>& refs ) const;
+
+    // Moves the tiles into the UndoSpill file, image() and restore() load
+    // them back transparently. The pixel content never changes, hence const.
+    bool spill() const;
+    bool isSpilled() const { return m_spilled; }
+    qint64 spilledBytes() const { return m_spill ? m_spill->size : 0; }
+
+private:
+
+    void rehydrate() const;
+
+    QSize m_imageSize;
+    QImage::Format m_format = QImage::Format_Invalid;
+    QRect m_rect;
+    QRect m_tileRange;                  // tile columns/rows covering m_rect
+    mutable QVector<TileStore::TilePtr> m_tiles;
+    mutable UndoSpill::RecordPtr m_spill;   // kept after rehydrate, a second spill is free
+    mutable bool m_spilled = false;
+
+};
@@ -32,6 +32,8 @@
 #include "../undo/InvertLayerCommand.h"
 #include "../undo/DeleteLayerCommand.h"
 #include "../undo/LassoCutCommand.h"
+#include "../undo/LayerHistory.h"
+#include "../core/TileStore.h"
 
 #include "../util/GeometryUtils.h"
 #include "../util/QUndoSortDialog.h"
@@ -40,13 +42,17 @@
 
 #include <QMessageBox>
 #include <QMouseEvent>
+#include <QOpenGLContext>
+#include <QOpenGLWidget>
 #include <QPainter>
 #include <QFileInfo>
 #include <QJsonDocument>
 #include <QGraphicsScene>
+#include <QScreen>
 #include <QScrollBar>
 #include <QWheelEvent>
 
+#include <algorithm>
 #include <iostream>
 #include <limits>
 
@@ -90,10 +96,34 @@ ImageView::ImageView( QWidget* parent ) : QGraphicsView(parent),
     
     m_scene = new QGraphicsScene(this);
     m_scene->setItemIndexMethod(QGraphicsScene::NoIndex); // Hack to prevent crash
+    m_layerIndex.setScene(m_scene);
+    // cursor colour is sampled at most once per display frame
+    m_colorSampleTimer = new QTimer(this);
+    m_colorSampleTimer->setSingleShot(true);
+    connect(m_colorSampleTimer, &QTimer::timeout, this, [this](){
+      if ( m_colorSamplePending ) {
+        m_colorSamplePending = false;
+        sampleCursorColor();
+      }
+    });
+    // optional GL viewport: layer tiles become textures (see TilePyramid),
+    // overlays are still scene items and drawn on top in z-order
+    if ( EditorStyle::instance().openGLViewport() ) {
+      QOpenGLContext probe;
+      if ( probe.create() ) {
+        setViewport(new QOpenGLWidget());
+        qInfo() << "ImageView::ImageView(): Using OpenGL viewport" << probe.format().majorVersion() << "." << probe.format().minorVersion();
+      } else {
+        qWarning() << "ImageView::ImageView(): Cannot create an OpenGL context, using raster viewport.";
+      }
+    }
     // setup 
     setMouseTracking(true);
     setRenderHint(QPainter::Antialiasing);
-    setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+    // GL viewports always repaint completely, raster ones keep the backing
+    // store and repaint only dirty items plus the foreground (see updateForeground)
+    m_partialUpdates = EditorStyle::instance().partialViewportUpdate() && qobject_cast<QOpenGLWidget*>(viewport()) == nullptr;
+    setViewportUpdateMode(m_partialUpdates ? QGraphicsView::MinimalViewportUpdate : QGraphicsView::FullViewportUpdate);
     setDragMode(QGraphicsView::NoDrag);
     m_undoStack = new QUndoStack(this);
     connect(m_undoStack, &QUndoStack::cleanChanged, this, [this](bool isClean){
@@ -246,6 +276,8 @@ ImageView::ImageView( QWidget* parent ) : QGraphicsView(parent),
         }
       }
       m_lastIndex = currentIndex;
+      // pushes add snapshots, undo and redo load spilled ones back
+      enforceUndoMemoryBudget();
     });
    /** 
     setDragMode(QGraphicsView::NoDrag);
@@ -257,16 +289,90 @@ ImageView::ImageView( QWidget* parent ) : QGraphicsView(parent),
 }
 
 // ------------------------ Self info -------------------------------------
+// Bytes of pixel snapshots held by the undo stack. Tiles shared between
+// commands are counted once, logicalBytes returns the unshared sum.
+qint64 ImageView::undoStackMemory( qint64* logicalBytes ) const
+{
+  QSet<const void*> tiles;
+  qint64 bytes = 0;
+  qint64 logical = 0;
+  for ( int i = 0; i < m_undoStack->count(); ++i ) {
+    auto* cmd = dynamic_cast<const AbstractCommand*>(m_undoStack->command(i));
+    if ( !cmd ) continue;
+    for ( const TileSnapshot* snapshot : cmd->snapshots() ) {
+      if ( !snapshot ) continue;
+      snapshot->collectTiles(tiles,bytes);
+      logical += snapshot->byteCount();
+    }
+  }
+  if ( logicalBytes != nullptr ) *logicalBytes = logical;
+  return bytes;
+}
+
+// Spills the snapshots of the commands farthest away from the current index
+// until the resident undo memory fits into the configured budget. Spilled
+// snapshots are loaded back by the command itself when undo/redo reaches it.
+// Runs on every index change; tile references are counted once and every
+// spill subtracts the bytes of the tiles it released.
+void ImageView::enforceUndoMemoryBudget()
+{
+  QHash<const void*,int> refs;
+  qint64 bytes = 0;
+  for ( int i = 0; i < m_undoStack->count(); ++i ) {
+    auto* cmd = dynamic_cast<const AbstractCommand*>(m_undoStack->command(i));
+    if ( !cmd ) continue;
+    for ( const TileSnapshot* snapshot : cmd->snapshots() ) {
+      if ( snapshot ) bytes += snapshot->addTiles(refs);
+    }
+  }
+  const qint64 budget = qint64(EditorStyle::instance().undoMemoryBudget()) * 1048576;
+  if ( budget > 0 && bytes > budget ) {
+    const int current = m_undoStack->index() - 1;
+    QList<int> candidates;
+    for ( int i = 0; i < m_undoStack->count(); ++i ) {
+      // the next undo and redo steps stay in memory, stepping back and forth
+      // does not spill what it just loaded
+      if ( qAbs(i - current) > 2 ) candidates.append(i);
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [current](int a, int b){
+      return qAbs(a - current) > qAbs(b - current);
+    });
+    for ( int i : candidates ) {
+      if ( bytes <= budget ) break;
+      auto* cmd = dynamic_cast<const AbstractCommand*>(m_undoStack->command(i));
+      if ( !cmd ) continue;
+      for ( const TileSnapshot* snapshot : cmd->snapshots() ) {
+        if ( !snapshot || snapshot->isSpilled() ) continue;
+        const qint64 released = snapshot->removeTiles(refs);
+        if ( snapshot->spill() ) {
+          bytes -= released;
+        } else {
+          snapshot->addTiles(refs);
+        }
+      }
+    }
+    qCDebug(logEditor) << "ImageView::enforceUndoMemoryBudget(): resident =" << bytes << ", spilled =" << UndoSpill::instance().bytes();
+  }
+  emit undoMemoryChanged(bytes, UndoSpill::instance().bytes());
+}
+
 void ImageView::printself() 
 {
   qInfo() << " ImageView::printself():";
   qInfo() << "  + Pixmap items in scene:" << getScene()->items().count();
   qInfo() << "  + nEditablePolygons:" << m_editablePolygons.size();
   qInfo() << "  + undoStackSize:" << m_undoStack->count();
+  qint64 logicalBytes = 0;
+  qint64 undoBytes = undoStackMemory(&logicalBytes);
+  qInfo().noquote() << QString("  + undoStackMemory: %1 MB (unshared %2 MB, tile store %3 MB in %4 tiles)")
+                         .arg(undoBytes / 1048576.0, 0, 'f', 2).arg(logicalBytes / 1048576.0, 0, 'f', 2)
+                         .arg(TileStore::instance().bytes() / 1048576.0, 0, 'f', 2).arg(TileStore::instance().tileCount());
+  qInfo().noquote() << QString("  + undoSpill: %1 MB in %2 records")
+                         .arg(UndoSpill::instance().bytes() / 1048576.0, 0, 'f', 2).arg(UndoSpill::instance().recordCount());
   auto items = getScene()->items();
   for ( QGraphicsItem* item : items ) {
     if ( auto pixmapItem = qgraphicsitem_cast<QGraphicsPixmapItem*>(item) ) {
-        qInfo() << "   + Pixmap found: Size =" << pixmapItem->pixmap().size() << ", position =" << item->pos() << ", visible =" << item->isVisible();
+        qInfo() << "   + Pixmap found: Size =" << pixmapItem->shape().boundingRect().size() << ", position =" << item->pos() << ", visible =" << item->isVisible();
     } else if ( auto polyItem = qgraphicsitem_cast<QGraphicsPolygonItem*>(item) ) {
         qInfo() << "   + Polygon found with " << polyItem->polygon().size() << "points, " << ", visible =" << item->isVisible();
     } else if ( auto lineItem = qgraphicsitem_cast<QGraphicsLineItem*>(item) ) {
@@ -340,7 +446,7 @@ void ImageView::setImage( const QImage& img )
 // ------------------------ UndoStack -------------------------------------
 void ImageView::rebuildUndoStack()
 {
-  if ( !m_undoStack || m_layers.size() == 0 ) return;
+  if ( !m_undoStack || m_layers.size() == 0 || m_editingLocked ) return;
   qCDebug(logEditor) << "ImageView::rebuildUndoStack(): undoStack =" << m_undoStack->count();
   {
     QList<int> possible_ids;
@@ -357,7 +463,6 @@ void ImageView::rebuildUndoStack()
       int id;
       int originalIndex;
     };
-    QList<QUndoCommand*> sortedCommands;
     QList<int> sortedLayerIdents;
     std::vector<CommandEntry> entries;
     for ( int i=0; i < m_undoStack->count(); ++i ) {
@@ -414,30 +519,158 @@ void ImageView::rebuildUndoStack()
     
     // finalize
     for ( const auto& entry : entries ) {
-      sortedLayerIdents.append(entry.originalIndex);
-    }
-    for ( int i = 0; i < sortedLayerIdents.count(); ++i ) {
-      const QUndoCommand* base = m_undoStack->command(sortedLayerIdents[i]);
-      auto* cmd = dynamic_cast<const AbstractCommand*>(base);
+      auto* cmd = dynamic_cast<const AbstractCommand*>(entry.cmd);
       if ( cmd && cmd->layer() ) {
-        qDebug() << " cloning " << cmd->text();
-        sortedCommands.append(cmd->clone());
+        sortedLayerIdents.append(entry.originalIndex);
       }
     }
-    m_undoStack->clear();
-    for ( auto* base : sortedCommands ) {
-      auto* cmd = dynamic_cast<AbstractCommand*>(base);
-      if ( cmd ) {
-        // cmd->setSilent(true);
-        m_undoStack->push(cmd);
-        // cmd->setSilent(false);
+    // the sort covers the whole stack, the redo history is applied first
+    m_undoStack->setIndex(m_undoStack->count());
+    replayUndoHistory(sortedLayerIdents);
+  }
+}
+
+// ------------------------ --- -------------------------------------
+// Applies the commands at the old stack indices 'order' instead of the
+// applied history. The history is partitioned by layer (LayerHistory):
+// only layers whose command chain changes, and the layers coupled to them
+// by lasso cuts, are executed again. The commands of all other layers are
+// moved over silently (cloneApplied) and keep their current state.
+// ------------------------ --- -------------------------------------
+
+bool ImageView::replayUndoHistory( const QList<int>& order, const std::function<void()>& beforeReplay )
+{
+  qCDebug(logEditor) << "ImageView::replayUndoHistory(): order =" << order.size() << ", index =" << m_undoStack->index();
+  {
+    const LayerHistory history(m_undoStack, m_undoStack->index());
+    // commands in front of the first moved one keep their position and state
+    int first = 0;
+    while ( first < order.count() && order[first] == first ) {
+      ++first;
+    }
+    QSet<int> affected = history.affectedLayers(order);
+    std::vector<std::unique_ptr<AbstractCommand>> commandsToReplay;
+    int executed = 0;
+    bool complete = false;
+    while ( !complete ) {
+      complete = true;
+      commandsToReplay.clear();
+      executed = 0;
+      for ( int i = first; i < order.count(); ++i ) {
+        auto* cmd = dynamic_cast<const AbstractCommand*>(m_undoStack->command(order[i]));
+        if ( !cmd ) {
+          qWarning() << "ImageView::replayUndoHistory(): Cannot rebuild undo stack: command is not AbstractCommand at index" << order[i];
+          return false;
+        }
+        const int layerId = history.layerOf(order[i]);
+        AbstractCommand* clone = nullptr;
+        if ( layerId >= 0 && !affected.contains(layerId) ) {
+          clone = cmd->cloneApplied();
+          if ( !clone ) {
+            // this layer has to be executed again, start over with the larger set
+            affected.insert(layerId);
+            affected = history.affectedLayers(order, affected);
+            complete = false;
+            break;
+          }
+          clone->setSilent(true);
+        } else {
+          clone = cmd->clone();
+          if ( !clone ) {
+            qWarning() << "ImageView::replayUndoHistory(): Cannot rebuild undo stack: clone failed at index" << order[i];
+            return false;
+          }
+          ++executed;
+        }
+        commandsToReplay.emplace_back(clone);
       }
     }
-    
-    // re-run the complete undo stack
-    m_undoStack->setIndex(0);
-    m_undoStack->setIndex(m_undoStack->count());
-    
+    qCDebug(logEditor) << "ImageView::replayUndoHistory(): executing" << executed << "of" << commandsToReplay.size() 
+                       << "commands from index" << first << ", affected layers =" << affected;
+    return replaceUndoHistory(first, commandsToReplay, beforeReplay);
+  }
+}
+
+// ------------------------ --- -------------------------------------
+// Replaces the history from index 'first' on by 'commandsToReplay'. The
+// stack is walked back to 'first' instead of 0: every undo restores the
+// tile snapshot of its own command, so nothing in front of 'first' is
+// executed again and the original commands (with their snapshots) stay.
+// Only the replacement is replayed; the first push drops the old tail.
+// Silent commands are not executed, their layers get the current state.
+// ------------------------ --- -------------------------------------
+
+bool ImageView::replaceUndoHistory( int first, std::vector<std::unique_ptr<AbstractCommand>>& commandsToReplay,
+                                    const std::function<void()>& beforeReplay )
+{
+  qCDebug(logEditor) << "ImageView::replaceUndoHistory(): first =" << first << ", replay =" << commandsToReplay.size() << ", count =" << m_undoStack->count();
+  {
+   first = qBound(0, first, m_undoStack->count());
+   if ( commandsToReplay.empty() && first < m_undoStack->count() ) {
+    // QUndoStack discards the redo tail only on push, the last kept command is replayed once
+    if ( first == 0 ) {
+      m_undoStack->setIndex(0);
+      m_undoStack->clear();
+      if ( beforeReplay ) beforeReplay();
+      return true;
+    }
+    const auto* last = dynamic_cast<const AbstractCommand*>(m_undoStack->command(first - 1));
+    AbstractCommand* clone = last != nullptr ? last->cloneApplied() : nullptr;
+    if ( clone ) {
+      clone->setSilent(true);
+    } else if ( last != nullptr ) {
+      clone = last->clone();
+    }
+    if ( !clone ) {
+      qWarning() << "ImageView::replaceUndoHistory(): Cannot drop the redo history: clone failed at index" << first - 1;
+      return false;
+    }
+    commandsToReplay.emplace_back(clone);
+    --first;
+   }
+   // layers which are only moved over keep the state they have now
+   QHash<LayerItem*, LayerItem::HistoryState> keptStates;
+   for ( const auto& command : commandsToReplay ) {
+     LayerItem* layer = command->layer();
+     if ( command->isSilent() && layer && !keptStates.contains(layer) ) {
+       keptStates.insert(layer, layer->historyState());
+     }
+   }
+   // the walk back skips the commands of those layers, their undo would only
+   // recompute pixels (a transform re-interpolates the layer) that are dropped
+   QList<AbstractCommand*> silenced;
+   for ( int i = first; i < m_undoStack->index(); ++i ) {
+     auto* cmd = dynamic_cast<AbstractCommand*>(const_cast<QUndoCommand*>(m_undoStack->command(i)));
+     if ( cmd && !cmd->isSilent() && keptStates.contains(cmd->layer()) ) {
+       cmd->setSilent(true);
+       silenced.append(cmd);
+     }
+   }
+   // Undo through QUndoStack, not by calling QUndoCommand::undo() directly.
+   // This keeps the stack index and Qt's internal state consistent.
+   m_undoStack->setIndex(first);
+   // the tail is dropped by the first push below, until then it stays redoable
+   for ( AbstractCommand* cmd : silenced ) {
+     cmd->setSilent(false);
+   }
+   if ( beforeReplay ) beforeReplay();
+   // push() calls redo(), which is intended here: the document is at the
+   // state in front of 'first' and the replacement is applied on top of it.
+   for ( auto& command : commandsToReplay ) {
+     AbstractCommand* cmd = command.release();
+     const bool silent = cmd->isSilent();
+     const int index = m_undoStack->index();
+     m_undoStack->push(cmd);
+     // a merged command is deleted by the stack, otherwise later redos run again
+     if ( silent && m_undoStack->index() == index + 1 ) {
+       cmd->setSilent(false);
+     }
+   }
+   commandsToReplay.clear();
+   for ( auto it = keptStates.cbegin(); it != keptStates.cend(); ++it ) {
+     it.key()->restoreHistoryState(it.value());
+   }
+   return true;
   }
 }
 
@@ -449,36 +682,16 @@ void ImageView::removeOperationsByIndexUndoStack(const QString& name, int index)
 {
   qDebug() << "ImageView::removeOperationsByIndexUndoStack(): name =" << name << ", index =" << index;
   {
-   if ( !m_undoStack ) {
+   if ( !m_undoStack || m_editingLocked ) {
     return;
    }
    if ( index < 0 || index > m_undoStack->count() ) {
     return;
    }
+   // Commands in front of index stay as they are, everything from index on is dropped.
+   m_undoStack->setIndex(index);
    std::vector<std::unique_ptr<AbstractCommand>> commandsToReplay;
-   commandsToReplay.reserve(index);
-   for ( int i = 0; i < index; ++i ) {
-    const auto* cmd =
-      dynamic_cast<const AbstractCommand*>(m_undoStack->command(i));
-    if (!cmd) {
-      qWarning() << "ImageView::removeOperationsByIdUndoStack(): Cannot rebuild undo stack: command is not AbstractCommand at index" << i;
-      return;
-    }
-    auto* clone = cmd->clone();
-    if ( !clone ) {
-      qWarning() << "ImageView::removeOperationsByIdUndoStack(): Cannot rebuild undo stack: clone failed at index" << i;
-      return;
-    }
-    commandsToReplay.emplace_back(clone);
-   }
-   // Roll document state back to the base state through QUndoStack.
-   m_undoStack->setIndex(0);
-   m_undoStack->clear();
-   // Reconstruct document state and history up to index.
-   // push() calls redo(); that is intended here because we start from index 0.
-   for ( auto& command : commandsToReplay ) {
-    m_undoStack->push(command.release());
-   }
+   replaceUndoHistory(index, commandsToReplay);
   }
 }
 
@@ -488,14 +701,13 @@ void ImageView::removeOperationsByIdUndoStack( int layerId )
 {
   qDebug() << "ImageView::removeOperationsByIdUndoStack(): layerId =" << layerId;
   {
-   if ( !m_undoStack ) {
+   if ( !m_undoStack || m_editingLocked ) {
     return;
    }
    const int oldIndex = m_undoStack->index();
-   std::vector<std::unique_ptr<AbstractCommand>> commandsToReplay;
-   commandsToReplay.reserve(oldIndex);
-   // Clone only commands that are currently applied.
+   // Only commands that are currently applied are kept.
    // Commands after oldIndex are redo history and are intentionally discarded.
+   QList<int> order;
    for ( int i = 0; i < oldIndex; ++i ) {
     const auto* cmd = dynamic_cast<const AbstractCommand*>(m_undoStack->command(i));
     if ( !cmd ) {
@@ -506,31 +718,17 @@ void ImageView::removeOperationsByIdUndoStack( int layerId )
     if ( layer && layer->id() == layerId ) {
       continue;
     }
-    auto* cloned = cmd->clone();
-    if ( !cloned ) {
-      qWarning() << "ImageView::removeOperationsByIdUndoStack(): Cannot rebuild undo stack: clone failed at index" << i;
-      return;
-    }
-    qDebug() << cloned->type();
-    commandsToReplay.emplace_back(cloned);
-   }
-   // Undo through QUndoStack, not by calling QUndoCommand::undo() directly.
-   // This keeps the stack index and Qt's internal state consistent.
-   m_undoStack->setIndex(0);
-   // Now it is safe to delete the old command objects.
-   m_undoStack->clear();
-   // Mark layer as deleted before replaying remaining commands.
-   for ( auto* layer : m_layers ) {
-    if ( layer && layer->id() == layerId ) {
-      layer->m_deleted = true;
-      break;
-    }
-   }
-   // Rebuild the stack. push() calls redo(), which is intended here:
-   // we are reconstructing the current document state from the base state.
-   for ( auto& command : commandsToReplay ) {
-     m_undoStack->push(command.release());
+    order.append(i);
    }
+   replayUndoHistory(order, [this, layerId]() {
+     // Mark layer as deleted before replaying remaining commands.
+     for ( auto* layer : m_layers ) {
+      if ( layer && layer->id() == layerId ) {
+        layer->m_deleted = true;
+        break;
+      }
+     }
+   });
   }
 }
 
@@ -715,7 +913,7 @@ void ImageView::deleteLayer( Layer* layer )
 {
   qDebug() << "ImageView::deleteLayer(): Processing...";
   {
-   if ( layer == nullptr || layer->m_item == nullptr ) return;
+   if ( layer == nullptr || layer->m_item == nullptr || m_editingLocked ) return;
    LayerItem *imageLayer = dynamic_cast<LayerItem*>(layer->m_item);
    m_undoStack->push(new DeleteLayerCommand(imageLayer,imageLayer->pos(),layer->id()));
   }
@@ -771,7 +969,7 @@ void ImageView::setActiveLayer( const QString &name, bool initialize )
 void ImageView::setColorTable( const QVector<QRgb> &lut )
 {
   LayerItem* layer = currentLayer();
-  if ( !layer ) return;
+  if ( !layer || m_editingLocked ) return;
   m_undoStack->push(new InvertLayerCommand(layer,lut));
 }
 
@@ -788,6 +986,10 @@ void ImageView::keyPressEvent( QKeyEvent* event )
 {
   qCDebug(logEditor) << "ImageView::keyPressEvent(): key =" << event->key();
   {
+    if ( m_editingLocked ) {
+      QGraphicsView::keyPressEvent(event);
+      return;
+    }
     MainWindow *mainWindow = dynamic_cast<MainWindow*>(m_parent);
     if ( mainWindow != nullptr ) {
       MainWindow::MainOperationMode opMode = mainWindow->getOperationMode();
@@ -948,6 +1150,10 @@ void ImageView::mousePressEvent( QMouseEvent* event )
         setCursor(Qt::ClosedHandCursor);
         return; // kein weiteres Event behandeln
     }
+    if ( m_editingLocked ) {
+        event->accept();
+        return;
+    }
     
     // --- Main window processing ---
     if ( mainWindow->getOperationMode() == MainWindow::MainOperationMode::ImageLayer && event->button() == Qt::LeftButton ) {
@@ -994,8 +1200,8 @@ void ImageView::mousePressEvent( QMouseEvent* event )
             m_currentStroke.clear();
             m_currentStroke << localPos;
             //ALT: m_undoStack->push(new PaintStrokeCommand(layer, localPos, m_brushColor, m_brushRadius, m_brushHardness));
-            layer->updateOriginalImage();
-            layer->paintStrokeSegment(localPos,localPos,m_brushColor,m_brushRadius,m_brushHardness);
+            layer->beginStroke();
+            layer->paintStrokeSegment(localPos,localPos,m_brushColor,m_brushRadius,m_brushHardness,m_brushMode);
             viewport()->update();
             break;
         }
@@ -1062,6 +1268,8 @@ void ImageView::mouseDoubleClickEvent( QMouseEvent* event )
 {
   qCDebug(logEditor) << "ImageView::mouseDoubleClickEvent(): Processing...";
   {
+    if ( m_editingLocked )
+      return;
     MainWindow *mainWindow = dynamic_cast<MainWindow*>(m_parent);
     if ( mainWindow != nullptr ) {
       if ( mainWindow->getOperationMode() == MainWindow::MainOperationMode::Polygon &&
@@ -1125,26 +1333,17 @@ void ImageView::mouseMoveEvent( QMouseEvent* event )
         
     QPointF scenePos = mapToScene(event->pos());
     m_cursorPos = scenePos;
+    updateForeground();
 
     emit cursorPositionChanged(int(scenePos.x()), int(scenePos.y()));
     emit scaleChanged(transform().m11());
 
-    // --- Cursor-Farbe unter Maus ---
-    bool colorFound = false;
-    auto itemsUnderCursor = scene()->items(scenePos);
-    for ( auto* item : itemsUnderCursor ) {
-        auto* layer = dynamic_cast<LayerItem*>(item);
-        if ( !layer ) continue;
-        QPoint layerPos = layer->mapFromScene(scenePos).toPoint();
-        if ( layer->image().rect().contains(layerPos) ) {
-            QColor c = layer->image().pixelColor(layerPos);
-            emit cursorColorChanged(c);
-            colorFound = true;
-            break;
-        }
+    // --- Cursor-Farbe unter Maus (throttled) ---
+    if ( m_colorSampleTimer->isActive() ) {
+        m_colorSamplePending = true;
+    } else {
+        sampleCursorColor();
     }
-    if ( !colorFound )
-        emit cursorColorChanged(Qt::transparent);
 
     // --- Shift-Pan: nur wenn Shift gedr?ckt & linke Maustaste ---
     // std::cout << "shift-pan: processing: shift=" << (event->modifiers() & Qt::ShiftModifier) << "..." << std::endl;
@@ -1155,24 +1354,19 @@ void ImageView::mouseMoveEvent( QMouseEvent* event )
         m_lastMousePos = event->pos();
         return;
     }
+    if ( m_editingLocked )
+        return;
 
     // --- Painting ---
     if ( m_painting && m_paintToolEnabled ) {
-        auto itemsUnderCursor = m_scene->items(scenePos);
-        for ( auto* item : itemsUnderCursor ) {
-          auto* layer = dynamic_cast<LayerItem*>(item);
-          if ( !layer || !layer->isVisible() ) continue;
-          QPoint localPos = layer->mapFromScene(scenePos).toPoint();
-          if ( !layer->image().rect().contains(localPos) ) continue;
-          // PaintCommand jetzt auf Layer
+        // the stroke stays on the layer it started on, its points are local to it
+        if ( LayerItem* layer = m_paintLayer ) {
+          const QPoint localPos = layer->mapFromScene(scenePos).toPoint();
           if ( m_currentStroke.isEmpty() || m_currentStroke.last() != localPos ) {
             m_currentStroke << localPos;
-            layer->paintStrokeSegment(m_currentStroke[m_currentStroke.size()-2],localPos,m_brushColor,m_brushRadius,m_brushHardness);
-            viewport()->update();
+            layer->paintStrokeSegment(m_currentStroke[m_currentStroke.size()-2],localPos,m_brushColor,m_brushRadius,m_brushHardness,m_brushMode);
           }
           //ALT: m_undoStack->push(new PaintStrokeCommand(layer, localPos, m_brushColor, m_brushRadius, m_brushHardness));
-          //ALT: viewport()->update();
-          break; // nur oberstes Layer malen
         }
         return;
     }
@@ -1229,14 +1423,14 @@ void ImageView::mouseMoveEvent( QMouseEvent* event )
 
     // --- Freie Auswahl (Path) ---
     if ( m_selecting ) {
+        const QPointF lastPos = m_selectionPath.currentPosition();
         m_selectionPath.lineTo(scenePos);
-        viewport()->update();
+        viewport()->update(mapFromScene(QRectF(lastPos, scenePos).normalized()).boundingRect().adjusted(-2,-2,2,2));
         return;
     }
     
     // --- Letzte Mausposition merken ---
     m_lastMousePos = event->pos();
-    viewport()->update();
     
     // >>>
     QGraphicsView::mouseMoveEvent(event);
@@ -1250,6 +1444,8 @@ void ImageView::mouseReleaseEvent( QMouseEvent* event )
   {
     if ( !scene() )
       return;
+    if ( m_editingLocked && !m_panning )
+      return;
       
     if ( m_panning == false ) {    
      // --- Cage warp beenden ---
@@ -1273,6 +1469,9 @@ void ImageView::mouseReleaseEvent( QMouseEvent* event )
          if( selectedCageLayer ) {
            selectedCageLayer->applyCageWarp("ImageView::1");
          }
+        } else {
+         // unchanged cage, drop the interactive preview
+         selectedCageLayer->cancelInteractiveWarp();
         }
         m_cageBefore.clear();
      }
@@ -1298,9 +1497,13 @@ void ImageView::mouseReleaseEvent( QMouseEvent* event )
      }
      // --- Painting beenden ---
      if ( m_painting && event->button() == Qt::LeftButton ) {
-        if ( m_currentStroke.size() > 1 ) {
+        // the command paints the stroke again with the same coverage, a single click is a dab
+        if ( m_paintLayer != nullptr ) {
+          m_paintLayer->endStroke();
+          if ( !m_currentStroke.isEmpty() ) {
             m_undoStack->push(new PaintStrokeCommand(m_paintLayer,m_currentStroke,m_brushColor,
-                                    m_brushRadius,m_brushHardness));
+                                    m_brushRadius,m_brushHardness,m_brushMode));
+          }
         }
         m_paintLayer = nullptr;
         m_currentStroke.clear();
@@ -1386,6 +1589,61 @@ bool ImageView::scaleScene( int direction )
 }
 
 // --------------------------------- drawing ---------------------------------
+// Colour of the topmost non transparent layer pixel under the cursor; the
+// next sample is due one display frame later (see m_colorSampleTimer)
+void ImageView::sampleCursorColor()
+{
+  QColor color;
+  m_layerIndex.opaqueLayerAt(m_cursorPos, &color);
+  emit cursorColorChanged(color);
+  const qreal refreshRate = screen() != nullptr ? screen()->refreshRate() : 60.0;
+  m_colorSampleTimer->start(qMax(1, qRound(1000.0 / qMax(1.0, refreshRate))));
+}
+
+// Viewport area covered by the crosshair lines and the brush preview at
+// the current cursor position (cosmetic pens, padded for antialiasing)
+QRegion ImageView::foregroundRegion() const
+{
+  QRegion region;
+  if ( !scene() )
+    return region;
+  const int pad = 2;
+  if ( m_crosshairVisible ) {
+    const QRect sceneArea = mapFromScene(scene()->sceneRect()).boundingRect();
+    const QPoint center = mapFromScene(m_cursorPos);
+    region += QRect(center.x() - pad, sceneArea.top(), 2 * pad + 1, sceneArea.height());
+    region += QRect(sceneArea.left(), center.y() - pad, sceneArea.width(), 2 * pad + 1);
+  }
+  if ( m_showBrushPreview && m_paintToolEnabled ) {
+    const QRectF brush(m_cursorPos - QPointF(m_brushRadius, m_brushRadius), QSizeF(2 * m_brushRadius, 2 * m_brushRadius));
+    region += mapFromScene(brush).boundingRect().adjusted(-pad, -pad, pad, pad);
+  }
+  return region & viewport()->rect();
+}
+
+// Invalidates the old and the new foreground area only, everything else
+// is kept in the viewport backing store
+void ImageView::updateForeground()
+{
+  if ( !m_partialUpdates ) {
+    viewport()->update();
+    return;
+  }
+  const QRegion region = foregroundRegion();
+  viewport()->update(m_foregroundRegion + region);
+  m_foregroundRegion = region;
+}
+
+void ImageView::scrollContentsBy( int dx, int dy )
+{
+  QGraphicsView::scrollContentsBy(dx, dy);
+  if ( m_partialUpdates ) {
+    // scrolling blits the drawn foreground together with the scene
+    viewport()->update(m_foregroundRegion.translated(dx, dy));
+    updateForeground();
+  }
+}
+
 void ImageView::drawForeground( QPainter* painter, const QRectF& )
 {
 
@@ -1448,6 +1706,16 @@ void ImageView::clearSelection()
 }
 
 // ---------------------------- Layer methods -----------------------------
+void ImageView::setLayerItemVisible( Layer* layer, bool visible )
+{
+  if ( auto* layerItem = dynamic_cast<LayerItem*>(layer->m_item) ) {
+    layerItem->setRenderVisible(visible);
+  } else {
+    layer->m_visible = visible;
+    layer->m_item->setVisible(visible);
+  }
+}
+
 void ImageView::setLayerVisible( int layerVisibleOp )
 {
   qCDebug(logEditor) << "ImageView::setLayerVisible(): layerVisibleOp =" << layerVisibleOp << ", m_oldVisibleLayerItemNum =" << m_oldVisibleLayerItemNum;
@@ -1458,8 +1726,7 @@ void ImageView::setLayerVisible( int layerVisibleOp )
       m_oldVisibleLayerItemNum = -1;
       for ( int i=0 ; i<m_layers.size() ; i++ ) {
         if ( m_layers[i]->m_item ) {
-         m_layers[i]->m_visible = true;
-         m_layers[i]->m_item->setVisible(true);
+         setLayerItemVisible(m_layers[i], true);
         }
       }
       mainWindow->updateLayerList();
@@ -1470,8 +1737,7 @@ void ImageView::setLayerVisible( int layerVisibleOp )
           if ( m_layers[i]->m_item->isSelected() ) {
             m_oldVisibleLayerItemNum = i;
             bool isVisible = m_layers[i]->m_visible;
-            m_layers[i]->m_visible = !isVisible;
-            m_layers[i]->m_item->setVisible(!isVisible);
+            setLayerItemVisible(m_layers[i], !isVisible);
             mainWindow->updateLayerList();
             IMainSystem::instance()->showMessage(QString("%1 layer %2").arg(isVisible?"Hide":"Show").arg(m_layers[i]->name()));
             return;
@@ -1479,8 +1745,7 @@ void ImageView::setLayerVisible( int layerVisibleOp )
             LayerItem *layerItem = dynamic_cast<LayerItem*>(m_layers[i]->m_item);
             if ( layerItem != nullptr ) {
              m_oldVisibleLayerItemNum = -1;
-             m_layers[i]->m_visible = true;
-             layerItem->setVisible(true);
+             layerItem->setRenderVisible(true);
              layerItem->setIsSelected(9,true);
              mainWindow->updateLayerList();
              layerItem->setCageVisible(9,true);
@@ -1581,7 +1846,7 @@ void ImageView::initCageWarpForLayer( LayerItem *layerItem )
 {
   qCDebug(logEditor) << "ImageView::initCageWarpForLayer(): layerItem =" << (layerItem?"ok":"null");
   {
-    if ( !layerItem || layerItem->cageMesh().needUpdate() == false ) return;
+    if ( !layerItem || layerItem->cageMesh().needUpdate() == false || m_editingLocked ) return;
     if ( layerItem->cageMesh().isInitialized() ) return;
     // --- initialize ---
     m_selectedLayer = layerItem;
@@ -1702,6 +1967,7 @@ void ImageView::clearLayers()
 
 void ImageView::createLassoLayer()
 {
+    if ( m_editingLocked ) return;
     createNewLayer(m_lassoPolygon,"Lasso Layer");
     emit lassoLayerAdded();
 }
@@ -1728,18 +1994,7 @@ LassoCutCommand* ImageView::createNewLayer( const QPolygonF& polygon, const QStr
     QRect bounds = boundsF.toAlignedRect();
     QImage backup = src.copy(bounds);
     // --- create mask ---
-    QImage mask(bounds.size(), QImage::Format_Alpha8);
-    mask.fill(0);
-    QPainter pm(&mask);
-     pm.setRenderHint(QPainter::Antialiasing);
-     pm.setBrush(backgroundColor); // Qt::white);
-     pm.setPen(Qt::NoPen);
-     // Polygon relativ zur Bounding-Box verschieben
-     QPolygonF relativePoly = polyF;
-     for ( int i=0; i<relativePoly.size(); ++i )
-      relativePoly[i] -= bounds.topLeft();
-     pm.drawPolygon(relativePoly);
-    pm.end();
+    QImage mask = LassoCutCommand::polygonMask(polyF, bounds);
     // --- lasso fear ---
     if ( m_lassoFeatherRadius > 0 ) {
       mask = QImageUtils::blurAlphaMask(mask,m_lassoFeatherRadius);
@@ -1803,18 +2058,8 @@ LassoCutCommand* ImageView::createNewLayer( const QPolygonF& polygon, const QStr
      }
      // --- --- --- --- ---
     } else {
-     for ( int y=0; y<bounds.height(); ++y ) {
-      uchar* m = mask.scanLine(y);
-      unsigned int ypos = bounds.top() + y;
-      for ( int x=0; x<bounds.width(); ++x ) {
-        QPoint imgPos(bounds.left() + x, ypos);
-        QColor c = src.pixelColor(imgPos);
-        if ( c != backgroundColor && m[x] > 0 ) {
-         // results in border artefacts: c.setAlpha(m[x]); cut.setPixelColor(x,y,c);
-         cut.setPixelColor(x,y,c);
-        }
-      }
-     }
+     // same cut as the batch replay of polygon layers
+     cut = LassoCutCommand::cutImage(src, mask, bounds);
     }
     // --- Neues LayerItem ---
     int nidx = 0;
@@ -1832,6 +2077,7 @@ LassoCutCommand* ImageView::createNewLayer( const QPolygonF& polygon, const QStr
     newLayer->setLayer(layer);
     newLayer->setUndoStack(m_undoStack);
     LassoCutCommand* cmd = new LassoCutCommand(base, newLayer, bounds, cut, nidx, name);
+    cmd->setFeatherRadius(m_lassoFeatherRadius);
     m_undoStack->push(cmd);
     newLayer->setPos(base->mapToScene(bounds.topLeft()));
     newLayer->setZValue(base->zValue()+1);
@@ -1884,7 +2130,7 @@ void ImageView::setIncreaseNumberOfCageControlPoints()
 {
   qCDebug(logEditor) << "ImageView::setIncreaseNumberOfCageControlPoints(): layer =" << (m_selectedLayer ? true : false);
   {
-   if ( !m_selectedLayer ) return;
+   if ( !m_selectedLayer || m_editingLocked ) return;
    {
      if ( !m_selectedLayer->hasActiveCage() ) {
        qWarning() << "ImageView::setIncreaseNumberOfCageControlPoints(): No active Cage available.";
@@ -1903,7 +2149,7 @@ void ImageView::setIncreaseNumberOfCageControlPoints()
 
 void ImageView::setDecreaseNumberOfCageControlPoints() 
 {
-   if ( !m_selectedLayer || !m_selectedLayer->hasActiveCage() ) return;
+   if ( !m_selectedLayer || !m_selectedLayer->hasActiveCage() || m_editingLocked ) return;
    auto* command = m_selectedLayer->getCageWarpCommand();
    if ( command ) {
     int n = m_selectedLayer->changeNumberOfActiveCagePoints(-1);
@@ -1916,6 +2162,7 @@ void ImageView::setNumberOfCageControlPoints( int nControlPoints )
 {
   qCDebug(logEditor) << "ImageView::setNumberOfCageControlPoints(): nControlPoints=" << nControlPoints;
   {
+    if ( m_editingLocked ) return;
     for ( auto* item : m_scene->items(Qt::DescendingOrder) ) {
       auto* layer = dynamic_cast<LayerItem*>(item);
       if ( layer && layer->getType() != LayerItem::MainImage ) {
@@ -2052,6 +2299,8 @@ void ImageView::undoPolygonOperation()
 {
   qCDebug(logEditor) << "ImageView::undoPolygonOperation(): polygonIndex =" << m_polygonIndex;
   {
+    if ( m_editingLocked )
+      return;
     EditablePolygonCommand* polyCmd = ImageView::getPolygonUndoCommand(QString("Editable Polygon %1").arg(m_polygonIndex));
     if ( polyCmd == nullptr )
       return;
@@ -2066,6 +2315,8 @@ void ImageView::redoPolygonOperation()
 {
   qCDebug(logEditor) << "ImageView::redoPolygonOperation(): polygonIndex =" << m_polygonIndex;
   {
+    if ( m_editingLocked )
+      return;
     EditablePolygonCommand* polyCmd = ImageView::getPolygonUndoCommand(QString("Editable Polygon %1").arg(m_polygonIndex));
     if ( polyCmd == nullptr )
       return;
@@ -2080,6 +2331,8 @@ void ImageView::createPolygonLayer()
 {
   qCDebug(logEditor) << "ImageView::createPolygonLayer(): polygonIndex =" << m_polygonIndex;
   {
+    if ( m_editingLocked )
+      return;
     // check whether a layer has been already created
     for ( int i=0 ; i<m_editablePolygons.size() ; i++ ) {
       if ( m_editablePolygons[i]->index() == m_polygonIndex ) {
@@ -2128,7 +2381,7 @@ void ImageView::finishPolygonDrawing( LayerItem* layer )
 {
   qCDebug(logEditor) << "ImageView::finishPolygonDrawing(): polygonIndex =" << m_polygonIndex << ", nEditablePolygons =" << m_editablePolygons.size();
   {
-    if ( !m_activePolygon || m_activePolygon->pointCount() < 3 )
+    if ( !m_activePolygon || m_activePolygon->pointCount() < 3 || m_editingLocked )
         return;
     QColor color = QColor(255,0,0);
     MainWindow *mainWindow = dynamic_cast<MainWindow*>(m_parent);
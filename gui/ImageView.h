@@ -27,10 +27,17 @@
 #include <QPainterPath>
 #include <QUndoStack>
 #include <QPolygon>
+#include <QRegion>
+#include <QTimer>
 #include <QHash>
 
+#include <functional>
+#include <memory>
+#include <vector>
+
 #include "../layer/Layer.h"
 #include "../layer/LayerItem.h"
+#include "../layer/LayerIndex.h"
 #include "../layer/MaskLayerItem.h"
 #include "../layer/EditablePolygonItem.h"
 #include "../layer/TransformOverlay.h"
@@ -88,6 +95,7 @@ class ImageView : public QGraphicsView
     LayerItem* baseLayer();
     
     void setLayerVisible( int layerVisibleOp );
+    void setLayerItemVisible( Layer* layer, bool visible );
     
     EditablePolygonCommand* getPolygonUndoCommand( const QString& name = "", bool isSelected = false );
     QImage& getImage() { return m_image; };
@@ -107,7 +115,10 @@ class ImageView : public QGraphicsView
     void setMaskBrushRadius( int r ) { m_maskBrushRadius = r; }
     void setBrushColor( const QColor& c ) { m_brushColor = c; }
     void setBrushHardness( qreal h ) { m_brushHardness = qBound(0.0, h, 1.0); }
+    void setBrushMode( int mode ) { m_brushMode = mode; }
     void setPaintToolEnabled( bool enabled ) { m_paintToolEnabled = enabled; }
+    void setEditingLocked( bool locked ) { m_editingLocked = locked; }   // view only, e.g. during project replay
+    bool isEditingLocked() const { return m_editingLocked; }
     void setBrushPreviewVisible( bool visible ) { m_showBrushPreview = visible; viewport()->update(); }
     void setMaskOpacity( qreal value ) { if ( m_maskItem ) m_maskItem->setOpacityFactor(value); }
     void setMaskLabel( quint8 index ) { m_currentMaskLabel = index; }
@@ -143,6 +154,8 @@ class ImageView : public QGraphicsView
     void undoPolygonOperation();
     void redoPolygonOperation();
     
+    qint64 undoStackMemory( qint64* logicalBytes = nullptr ) const;
+    void enforceUndoMemoryBudget();
     void printself();
 
  signals:
@@ -151,6 +164,7 @@ class ImageView : public QGraphicsView
     void pickedColorChanged( const QColor& color );
     void cursorPositionChanged( int x, int y );
     void scaleChanged( double scale );
+    void undoMemoryChanged( qint64 residentBytes, qint64 spilledBytes );
     void lassoLayerAdded();
     void layerAdded();
 
@@ -163,15 +177,22 @@ class ImageView : public QGraphicsView
     void mouseDoubleClickEvent( QMouseEvent* event ) override;
     void wheelEvent( QWheelEvent* event ) override;
     void drawForeground( QPainter* painter, const QRectF& rect ) override;
+    void scrollContentsBy( int dx, int dy ) override;
 
  private:
 
     void initCageWarpForLayer( LayerItem* layerItem );
+    QRegion foregroundRegion() const;
+    void sampleCursorColor();
+    void updateForeground();
     LassoCutCommand* createNewLayer( const QPolygonF& polygon, const QString& name );
     void setEnableTransformMode( LayerItem* layer );
     void disableTransformMode();
     void setEnablePerspectiveWarp( LayerItem* layer );
     void disablePerspectiveWarp();
+    bool replaceUndoHistory( int first, std::vector<std::unique_ptr<AbstractCommand>>& commandsToReplay,
+                             const std::function<void()>& beforeReplay = nullptr );
+    bool replayUndoHistory( const QList<int>& order, const std::function<void()>& beforeReplay = nullptr );
 
     QList<Layer*> m_layers;
     QList<QPointer<EditablePolygon>> m_editablePolygons;
@@ -203,9 +224,12 @@ class ImageView : public QGraphicsView
 
     bool m_maskStrokeActive = false;
     bool m_crosshairVisible = true;
+    bool m_partialUpdates = false;
+    bool m_colorSamplePending = false;
     bool m_lassoEnabled = false;
     bool m_selecting = false;
     bool m_panning = false;
+    bool m_editingLocked = false;
     bool m_pipette = false;
     bool m_needColormapUpdate = false;
     bool m_showBrushPreview = true;
@@ -222,6 +246,7 @@ class ImageView : public QGraphicsView
     QColor m_backgroundColor = Qt::white;
     int m_oldVisibleLayerItemNum = -1;
     int m_brushRadius = 5;
+    int m_brushMode = 0;
     int m_maskBrushRadius = 5;
     int m_lassoFeatherRadius = 0;
     int m_lastIndex = 0;
@@ -232,6 +257,9 @@ class ImageView : public QGraphicsView
     QGraphicsPolygonItem* m_lassoPreview = nullptr;
     QGraphicsRectItem* m_lassoBoundingBox = nullptr;
     QPainterPath m_selectionPath;
+    LayerIndex m_layerIndex;        // layer hit tests on mouse motion
+    QTimer* m_colorSampleTimer = nullptr;
+    QRegion m_foregroundRegion;     // viewport area of the last drawn crosshair/brush preview
     QVector<QPoint> m_currentStroke;
     QVector<QPoint> m_maskStrokePoints;
     QVector<QRgb> m_lut;
@@ -0,0 +1,102 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "LayerThumbnailCache.h"
+
+#include <QMetaObject>
+#include <QMutexLocker>
+
+// -------------------------- LayerThumbnailCache --------------------------
+LayerThumbnailCache::LayerThumbnailCache( const QSize& size, QObject* parent ) : QObject(parent), m_size(size)
+{
+  // one thread, requests are served in order and never compete with the warp workers
+  m_pool.setMaxThreadCount(1);
+}
+
+LayerThumbnailCache::~LayerThumbnailCache()
+{
+  m_pool.clear();
+  m_pool.waitForDone();
+}
+
+bool LayerThumbnailCache::isCurrent( int layerId, quint64 generation ) const
+{
+  auto it = m_entries.constFind(layerId);
+  return it != m_entries.constEnd() && ( it->generation == generation || it->pendingGeneration == generation );
+}
+
+void LayerThumbnailCache::request( int layerId, quint64 generation, const QImage& preview )
+{
+  Entry& entry = m_entries[layerId];
+  if ( entry.generation == generation || entry.pendingGeneration == generation || preview.isNull() )
+    return;
+  entry.pendingGeneration = generation;
+  QMutexLocker locker(&m_mutex);
+  // a waiting request of the layer is replaced, its job picks up the new one
+  const bool queued = m_requests.contains(layerId);
+  m_requests.insert(layerId, { generation, preview });
+  if ( !queued ) {
+    m_pool.start([this, layerId](){ render(layerId); });
+  }
+}
+
+void LayerThumbnailCache::remove( int layerId )
+{
+  m_entries.remove(layerId);
+  QMutexLocker locker(&m_mutex);
+  m_requests.remove(layerId);
+}
+
+void LayerThumbnailCache::clear()
+{
+  m_entries.clear();
+  QMutexLocker locker(&m_mutex);
+  m_requests.clear();
+}
+
+// worker thread, only the scaled thumbnail is queued back
+void LayerThumbnailCache::render( int layerId )
+{
+  Request request;
+  {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_requests.find(layerId);
+    if ( it == m_requests.end() )
+      return;
+    request = std::move(it.value());
+    m_requests.erase(it);
+  }
+  const QImage scaled = request.preview.scaled(m_size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+  const quint64 generation = request.generation;
+  QMetaObject::invokeMethod(this, [this, layerId, generation, scaled](){
+    store(layerId, generation, scaled);
+  }, Qt::QueuedConnection);
+}
+
+void LayerThumbnailCache::store( int layerId, quint64 generation, const QImage& thumbnail )
+{
+  auto it = m_entries.find(layerId);
+  // removed meanwhile or overtaken by a newer request
+  if ( it == m_entries.end() || generation < it->generation )
+    return;
+  it->generation = generation;
+  if ( it->pendingGeneration == generation ) {
+    it->pendingGeneration = 0;
+  }
+  it->pixmap = QPixmap::fromImage(thumbnail);
+  emit thumbnailChanged(layerId, it->pixmap);
+}
@@ -0,0 +1,80 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QPixmap>
+#include <QSize>
+#include <QThreadPool>
+
+// -------------------------- LayerThumbnailCache --------------------------
+// Thumbnails of the layer dock keyed by layer id and the layer's content
+// generation. Outdated entries are downsampled on a worker thread from a
+// coarse preview of the layer, the old thumbnail is returned until the new
+// one is ready. Each layer has one request slot, a newer request replaces
+// the one still waiting for the worker.
+class LayerThumbnailCache : public QObject {
+    Q_OBJECT
+
+public:
+
+    explicit LayerThumbnailCache( const QSize& size = QSize(48,48), QObject* parent = nullptr );
+    ~LayerThumbnailCache() override;
+
+    QSize size() const { return m_size; }
+    // larger side of the preview a thumbnail is scaled from
+    int previewExtent() const { return 2 * qMax(m_size.width(), m_size.height()); }
+
+    // cached thumbnail, may be null or outdated
+    QPixmap thumbnail( int layerId ) const { return m_entries.value(layerId).pixmap; }
+    // preview: coarse level of the layer, a few times the thumbnail size
+    void request( int layerId, quint64 generation, const QImage& preview );
+    bool isCurrent( int layerId, quint64 generation ) const;
+    void remove( int layerId );
+    void clear();
+
+signals:
+
+    void thumbnailChanged( int layerId, const QPixmap& thumbnail );
+
+private:
+
+    void render( int layerId );
+    void store( int layerId, quint64 generation, const QImage& thumbnail );
+
+    struct Entry {
+      quint64 generation = 0;
+      quint64 pendingGeneration = 0;
+      QPixmap pixmap;
+    };
+
+    struct Request {
+      quint64 generation = 0;
+      QImage preview;
+    };
+
+    QSize m_size;
+    QHash<int, Entry> m_entries;
+    QMutex m_mutex;
+    QHash<int, Request> m_requests;     // latest request per layer, taken by the worker
+    QThreadPool m_pool;
+
+};
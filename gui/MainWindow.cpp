@@ -17,12 +17,16 @@
 
 #include "MainWindow.h"
 #include "ImageView.h"
+#include "LayerThumbnailCache.h"
 
 #include "../core/ImageLoader.h"
+#include "../core/AsyncImageLoader.h"
 #include "../core/ImageProcessor.h"
+#include "../core/ProjectReader.h"
 
 #include "../layer/LayerItem.h"
 #include "../undo/AbstractCommand.h"
+#include "../undo/CommandRegistry.h"
 #include "../undo/PaintStrokeCommand.h"
 #include "../undo/TransformLayerCommand.h"
 #include "../undo/PerspectiveWarpCommand.h"
@@ -32,9 +36,12 @@
 #include "../undo/MoveLayerCommand.h"
 #include "../undo/CageWarpCommand.h"
 
+#include "../util/BrushEngine.h"
 #include "../util/MaskUtils.h"
 #include "../util/ItemDelegate.h"
 #include "../util/QWidgetUtils.h"
+#include "../util/QImageUtils.h"
+#include "../util/Parallel.h"
 
 #ifdef HASITK
  #include "itkMultiThreaderBase.h"
@@ -71,6 +78,12 @@
 #include <QLineEdit>
 #include <QBuffer>
 #include <QTimer>
+#include <QEventLoop>
+#include <QProgressDialog>
+#include <QGraphicsPixmapItem>
+#include <QElapsedTimer>
+#include <QProgressBar>
+#include <QThread>
 
 #include <iostream>
 
@@ -271,14 +284,22 @@ bool MainWindow::loadImage( const QString& filePath, bool askForNewLoad )
 {
   qCDebug(logEditor) << "MainWindow::loadImage(): filePath =" << filePath << ", askForNewLoad =" << askForNewLoad;
   {
-    ImageLoader loader;
-    if ( !loader.load(filePath) ) {
+    QImage image;
+    QString checksum;
+    QString loadedPath = filePath;
+    bool canceled = false;
+    if ( !decodeImage(filePath,image,checksum,canceled) ) {
+      if ( canceled ) {
+        showMessage(QString("Loading of %1 canceled").arg(filePath),1);
+        return false;
+      }
       if ( askForNewLoad ) {
         QString updatedPath;
         if ( QWidgetUtils::handleMissingImage(filePath,updatedPath) == true ) {
-          if ( loader.load(updatedPath) ) {
+          if ( decodeImage(updatedPath,image,checksum,canceled) ) {
             QFileInfo fileInfo(updatedPath);
             m_mainImageName = fileInfo.fileName();
+            loadedPath = updatedPath;
           } else {
             showMessage(QString("Still invalid main image path '%1'. Loading aborted").arg(updatedPath),1);
             return false;
@@ -295,12 +316,12 @@ bool MainWindow::loadImage( const QString& filePath, bool askForNewLoad )
       QFileInfo fileInfo(filePath);
       m_mainImageName = fileInfo.fileName();
     }
-    Config::isWhiteBackgroundImage = loader.hasWhiteBackground();
+    Config::isWhiteBackgroundImage = !QImageUtils::hasBlackBackground(image);
     auto* scene = m_imageView->getScene();
     scene->clear();
     // main image = regular layer
-    m_layerItem = new LayerItem("MainImage",loader.getPixmap());
-    m_layerItem->setFileInfo(filePath);
+    m_layerItem = new LayerItem("MainImage",QPixmap::fromImage(image));
+    m_layerItem->setFileInfo(loadedPath,checksum);
     m_layerItem->setType(LayerItem::MainImage);
     m_layerItem->setParent(this);
     m_layerItem->setZValue(1);
@@ -316,6 +337,60 @@ bool MainWindow::loadImage( const QString& filePath, bool askForNewLoad )
   }
 }
 
+// Decodes on a worker thread (see AsyncImageLoader) while the GUI keeps
+// running: a scaled preview is shown in the scene as soon as it is there,
+// the progress dialog offers a cancel button.
+bool MainWindow::decodeImage( const QString& filePath, QImage& image, QString& checksum, bool& canceled )
+{
+  qCDebug(logEditor) << "MainWindow::decodeImage(): filePath =" << filePath;
+  {
+    canceled = false;
+    if ( filePath.isEmpty() ) 
+      return false;
+    bool success = false;
+    QEventLoop loop;
+    QGraphicsPixmapItem* previewItem = nullptr;
+    QProgressDialog progress(QString("Loading %1 ...").arg(QFileInfo(filePath).fileName()), "Cancel", 0, 100, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+    AsyncImageLoader* loader = new AsyncImageLoader(this);
+    connect(loader, &AsyncImageLoader::progress, &progress, &QProgressDialog::setValue);
+    connect(loader, &AsyncImageLoader::previewReady, &loop, [&](const QImage& preview, const QSize& fullSize){
+      auto* scene = m_imageView->getScene();
+      previewItem = scene->addPixmap(QPixmap::fromImage(preview));
+      previewItem->setTransformationMode(Qt::SmoothTransformation);
+      previewItem->setScale(qreal(fullSize.width()) / preview.width());
+      previewItem->setZValue(1);
+      scene->setSceneRect(previewItem->sceneBoundingRect());
+      m_imageView->fitInView(previewItem,Qt::KeepAspectRatio);
+    });
+    connect(loader, &AsyncImageLoader::finished, &loop, [&](const QImage& result, const QString& md5){
+      image = result;
+      checksum = md5;
+      success = true;
+      loop.quit();
+    });
+    connect(loader, &AsyncImageLoader::failed, &loop, [&](const QString& reason){
+      qWarning() << "MainWindow::decodeImage():" << reason;
+      loop.quit();
+    });
+    connect(&progress, &QProgressDialog::canceled, &loop, [&](){
+      canceled = true;
+      loop.quit();
+    });
+    loader->start(filePath,m_imageView->viewport()->size());
+    loop.exec();
+    // a canceled decode stops at the next strip and is dropped
+    loader->dispose();
+    progress.reset();
+    if ( previewItem != nullptr ) {
+      m_imageView->getScene()->removeItem(previewItem);
+      delete previewItem;
+    }
+    return success;
+  }
+}
+
 void MainWindow::openImage()
 {
   qCDebug(logEditor) << "MainWindow::openImage(): Processing...";
@@ -483,6 +558,7 @@ bool MainWindow::saveProject( const QString& filePath )
          }
         }
         layerObj["opacity"] = layer->opacity();
+        layerObj["visible"] = layer->m_visible;
         layerObj["creator"] = layer->creator();
         layerArray.append(layerObj);
     }
@@ -513,24 +589,129 @@ bool MainWindow::saveProject( const QString& filePath )
     return true;
 }
 
+// --- layer of a project file, decoded off the GUI thread ---
+struct DecodedProjectLayer {
+  int id = 0;
+  QString name;
+  ProjectLayer source;
+  QImage mask;
+  QImage image;
+  QString itemName;
+  QRect rect;
+  bool isBinaryMask = false;
+};
+
+// Only reads shared Qt containers through const accessors, hence safe to run
+// for several layers in parallel.
+static void decodeProjectLayer( DecodedProjectLayer& layer, const ProjectModel& project, const QImage& mainImage, bool binaryMasking )
+{
+  QImage mask;
+  mask.loadFromData(layer.source.decode(),"PNG");
+  const QJsonObject& json = layer.source.json();
+  bool isBinaryMask = json.value("binaryMask").toBool(false);
+  int x = json.value("x").toInt(-1);
+  int y = json.value("y").toInt(-1);
+  // ensure that m_bounds is always defined correctly
+  const QRect cutRect = project.cutRect(layer.id);
+  if ( !(  x > 0 && y > 0 ) && !cutRect.isNull() ) {
+    x = cutRect.x();
+    y = cutRect.y();
+  }
+  layer.rect = QRect(x,y,mask.width(), mask.height());
+  // binary masking
+  if ( isBinaryMask ) {
+    QImage subImage = mainImage.copy(x, y, mask.width(), mask.height());
+    subImage = subImage.convertToFormat(QImage::Format_ARGB32);
+    int backgroundPixelColor = Config::isWhiteBackgroundImage ? 255 : 0;
+    for ( int y = 0; y < subImage.height(); ++y ) {
+     QRgb *rowData = reinterpret_cast<QRgb*>(subImage.scanLine(y));
+     const uchar *maskData = mask.constScanLine(y);
+     for ( int x = 0; x < subImage.width(); ++x ) {
+      if (maskData[x] != 255 || qRed(rowData[x]) == backgroundPixelColor) {
+        rowData[x] = qRgba(qRed(rowData[x]), qGreen(rowData[x]), qBlue(rowData[x]), 0);
+      }
+     }
+    }
+    layer.image = subImage;
+    layer.itemName = "SubImage";
+  } else if ( binaryMasking ) {
+     if ( mask.format() != QImage::Format_ARGB32 && mask.format() != QImage::Format_ARGB32_Premultiplied ) {
+       mask = mask.convertToFormat(QImage::Format_ARGB32);
+     }
+     QImage subImage = mainImage.copy(x, y, mask.width(), mask.height());
+     subImage = subImage.convertToFormat(QImage::Format_ARGB32);
+     int backgroundPixelColor = Config::isWhiteBackgroundImage ? 255 : 0;
+     for ( int y = 0; y < subImage.height(); ++y ) {
+      auto *rowData = reinterpret_cast<QRgb*>(subImage.scanLine(y));
+      const auto *maskRowData = reinterpret_cast<const QRgb*>(mask.constScanLine(y));  
+      for ( int x = 0; x < subImage.width(); ++x ) {
+       // OLD: if ( qRed(rowData[x]) == backgroundPixelColor || qAlpha(maskRowData[x]) != 255 ) {
+       if ( qRed(rowData[x]) == backgroundPixelColor && qAlpha(maskRowData[x]) == 255 ) {
+        rowData[x] = 0; 
+       }
+      }
+     }
+     layer.image = subImage;
+     layer.itemName = "SubImage";
+     isBinaryMask = false;
+  } else {
+     layer.image = mask;
+     layer.itemName = "MaskImage";
+     isBinaryMask = false;
+  }
+  layer.mask = mask;
+  layer.isBinaryMask = isBinaryMask;
+}
+
+void MainWindow::runInBackground( const QString& message, const std::function<void()>& work )
+{
+  qCDebug(logEditor) << "MainWindow::runInBackground(): message =" << message;
+  {
+    // the GUI keeps repainting while the worker runs, user input is locked by the caller
+    QEventLoop loop;
+    QThread* worker = QThread::create(work);
+    connect(worker, &QThread::finished, &loop, &QEventLoop::quit);
+    m_messageLabel->setText(message);
+    m_progressBar->setRange(0,0);
+    m_progressBar->show();
+    worker->start();
+    if ( !worker->isFinished() ) {
+      loop.exec(QEventLoop::ExcludeUserInputEvents);
+    }
+    worker->wait();
+    delete worker;
+    m_progressBar->hide();
+  }
+}
+
 bool MainWindow::loadProject( const QString& filePath, bool skipMainImage )
 {
   qCDebug(logEditor) << "MainWindow::loadProject(): filename=" << filePath << ", skipMainImage =" << skipMainImage;
   {
-    QFile f(filePath);
-    if ( !f.open(QIODevice::ReadOnly) ) return false;
+    if ( m_replay ) {
+      showMessage(QString("Cannot load '%1' while the current project is still loading").arg(filePath),1);
+      return false;
+    }
+    
+    // --- Reading and parsing, embedded layer data makes project files large ---
+    // layer images stay base64 in the file buffer until they are decoded
+    ProjectModel project;
+    ProjectReader reader;
+    bool isRead = false;
+    runInBackground(QString("Reading %1 ...").arg(QFileInfo(filePath).fileName()), [&](){
+      isRead = reader.read(filePath, project);
+    });
+    if ( !isRead ) {
+      showMessage(QString("Cannot read '%1': %2").arg(filePath).arg(reader.errorString()),1);
+      return false;
+    }
     m_projectFileName = filePath;
-    QJsonDocument doc = QJsonDocument::fromJson(f.readAll());
-    f.close();
-    if ( !doc.isObject() ) return false;
-    QJsonObject root = doc.object();
     
     // --- Loading and verify main image ---
-    QJsonArray layerArray = root["layers"].toArray();
     if ( !skipMainImage ) {
       bool foundMainImage = false;
-      for ( const QJsonValue& v : layerArray ) {
-        QJsonObject layerObj = v.toObject();
+      for ( const ProjectLayer& projectLayer : project.layers() ) {
+        const QJsonObject& layerObj = projectLayer.json();
         QString name = layerObj["name"].toString();
         int id = layerObj["id"].toInt();
         if ( id == 0 ) {
@@ -551,8 +732,8 @@ bool MainWindow::loadProject( const QString& filePath, bool skipMainImage )
     }
     
     // --- Check whether the main input image and the main project image are identical ---
-    for ( const QJsonValue& v : layerArray ) {
-       QJsonObject layerObj = v.toObject();
+    for ( const ProjectLayer& projectLayer : project.layers() ) {
+       const QJsonObject& layerObj = projectLayer.json();
        QString name = layerObj["name"].toString();
        int id = layerObj["id"].toInt();
        if ( id == 0 && !Config::skipValidation ) {
@@ -576,158 +757,165 @@ bool MainWindow::loadProject( const QString& filePath, bool skipMainImage )
     if ( undoStack != nullptr ) undoStack->clear();
     
     // --- Parsing layers (does not contain layer positions) ---
-    int nCreatedLayers = 0;
-    for ( const QJsonValue& v : layerArray ) {
-      QJsonObject layerObj = v.toObject();
-      int id = layerObj["id"].toInt();
-      if ( id != 0 ) {
-        QString name = layerObj["name"].toString();
-        if ( layerObj.contains("data") ) {
-         QRect rect;
-         LayerItem* newLayer = nullptr;
-         QString imgBase64 = layerObj["data"].toString();
-         QByteArray ba = QByteArray::fromBase64(imgBase64.toUtf8());
-         QImage mask;
-         mask.loadFromData(ba,"PNG");
-         bool isBinaryMask = layerObj.value("binaryMask").toBool(false);
-         int x = layerObj.value("x").toInt(-1);
-         int y = layerObj.value("y").toInt(-1);
-         // fix by Claude to ensure that m_bounds is always defined correctly
-         if ( !(  x > 0 && y > 0 ) ) {
-           QJsonArray undoArray = root["undoStack"].toArray();
-           for ( const QJsonValue& v : undoArray ) {
-             QJsonObject cmdObj = v.toObject();
-             QString type = cmdObj["type"].toString();
-             if ( type == "LassoCut" || type == "LassoCutCommand" ) {
-               if( id == cmdObj["newLayerId"].toInt(-1) ) {
-                 QJsonObject r = cmdObj["rect"].toObject();
-                 x = r["x"].toInt();
-                 y = r["y"].toInt();
-               }
-             }
-           }
-         }
-         rect = QRect(x,y,mask.width(), mask.height());
-         // binary masking
-         if ( isBinaryMask ) {
-           QImage mainImage = m_layerItem->image();
-           QImage subImage = mainImage.copy(x, y, mask.width(), mask.height());
-           subImage = subImage.convertToFormat(QImage::Format_ARGB32);
-           int backgroundPixelColor = Config::isWhiteBackgroundImage ? 255 : 0;
-           for ( int y = 0; y < subImage.height(); ++y ) {
-            QRgb *rowData = reinterpret_cast<QRgb*>(subImage.scanLine(y));
-            const uchar *maskData = mask.constScanLine(y);
-            for ( int x = 0; x < subImage.width(); ++x ) {
-             // if ( maskData[x] != 255 ) {
-             //  rowData[x] = qRgba(qRed(rowData[x]), qGreen(rowData[x]), qBlue(rowData[x]), 0);
-             // }
-             if (maskData[x] != 255 || qRed(rowData[x]) == backgroundPixelColor) {
-               rowData[x] = qRgba(qRed(rowData[x]), qGreen(rowData[x]), qBlue(rowData[x]), 0);
-             }
-            }
-           }
-           newLayer = new LayerItem("SubImage",subImage);
-         } else if ( EditorStyle::instance().binaryMasking() ) {
-            if ( mask.format() != QImage::Format_ARGB32 && mask.format() != QImage::Format_ARGB32_Premultiplied ) {
-              mask = mask.convertToFormat(QImage::Format_ARGB32);
-            }
-            QImage mainImage = m_layerItem->image();
-            QImage subImage = mainImage.copy(x, y, mask.width(), mask.height());
-            subImage = subImage.convertToFormat(QImage::Format_ARGB32);
-            int backgroundPixelColor = Config::isWhiteBackgroundImage ? 255 : 0;
-            for ( int y = 0; y < subImage.height(); ++y ) {
-             auto *rowData = reinterpret_cast<QRgb*>(subImage.scanLine(y));
-             const auto *maskRowData = reinterpret_cast<const QRgb*>(mask.constScanLine(y));  
-             for ( int x = 0; x < subImage.width(); ++x ) {
-              // OLD: if ( qRed(rowData[x]) == backgroundPixelColor || qAlpha(maskRowData[x]) != 255 ) {
-              if ( qRed(rowData[x]) == backgroundPixelColor && qAlpha(maskRowData[x]) == 255 ) {
-               rowData[x] = 0; 
-              }
-             }
-            }
-            newLayer = new LayerItem("SubImage",subImage);
-            isBinaryMask = false;
-         } else {
-            newLayer = new LayerItem("MaskImage",mask);
-            isBinaryMask = false;
-         }
-         newLayer->setIndex(id);
-         newLayer->setParent(this);
-         newLayer->setUndoStack(m_imageView->undoStack());
-         Layer* layer = new Layer(id,mask);
-         layer->m_binaryMask = isBinaryMask;
-         layer->m_name = name;
-         layer->m_item = newLayer;
-         layer->m_bounds = rect;
-         newLayer->setLayer(layer);
-         m_imageView->layers().push_back(layer);
-         m_imageView->getScene()->addItem(newLayer);
-         nCreatedLayers += 1;
-        }
+    const QJsonArray& undoArray = project.undoStack();
+    QVector<DecodedProjectLayer> decodedLayers;
+    for ( const ProjectLayer& projectLayer : project.layers() ) {
+      int id = projectLayer.id();
+      if ( id != 0 && projectLayer.hasData() ) {
+        DecodedProjectLayer layer;
+        layer.id = id;
+        layer.name = projectLayer.name();
+        layer.source = projectLayer;
+        decodedLayers.push_back(layer);
       }
     }
-    if ( nCreatedLayers > 0 ) {
+    if ( !decodedLayers.isEmpty() ) {
+      const QImage mainImage = m_layerItem != nullptr ? m_layerItem->image() : QImage();
+      const bool binaryMasking = EditorStyle::instance().binaryMasking();
+      runInBackground(QString("Decoding %1 layers ...").arg(decodedLayers.size()), [&](){
+        ParallelUtils::forRows(decodedLayers.size(), [&](int begin, int end){
+          for ( int i = begin; i < end; ++i ) {
+            decodeProjectLayer(decodedLayers[i], project, mainImage, binaryMasking);
+          }
+        }, 1);
+      });
+    }
+    
+    // --- Creating layer items, scene changes stay on the GUI thread ---
+    for ( const DecodedProjectLayer& decoded : decodedLayers ) {
+      LayerItem* newLayer = new LayerItem(decoded.itemName,decoded.image);
+      newLayer->setIndex(decoded.id);
+      newLayer->setParent(this);
+      newLayer->setUndoStack(m_imageView->undoStack());
+      Layer* layer = new Layer(decoded.id,decoded.mask);
+      layer->m_binaryMask = decoded.isBinaryMask;
+      layer->m_name = decoded.name;
+      layer->m_item = newLayer;
+      layer->m_bounds = decoded.rect;
+      newLayer->setLayer(layer);
+      newLayer->setRenderOpacity(decoded.source.json().value("opacity").toDouble(1.0));
+      newLayer->setRenderVisible(decoded.source.json().value("visible").toBool(true));
+      m_imageView->layers().push_back(layer);
+      m_imageView->getScene()->addItem(newLayer);
+    }
+    if ( !decodedLayers.isEmpty() ) {
       rebuildLayerList();
     }
     
-    QList<LayerItem*> layers;
+    // --- 3. Restore Undo/Redo Stack ---
+    // Commands redo on layer items, so they are replayed on the GUI thread in
+    // time slices. The view stays responsive and layers which have no pending
+    // command left can be inspected while the rest of the history is replayed.
+    m_replay.reset(new ProjectReplay);
+    m_replay->commands = undoArray;
     for ( auto* item : m_imageView->getScene()->items(Qt::DescendingOrder) ) {
       auto* layer = dynamic_cast<LayerItem*>(item);
       if ( layer ) {
-        layers << layer;
+        m_replay->layers << layer;
       }  
     }
+    // progress follows the estimated pixel work, not the command count
+    CommandRegistry::Context context;
+    context.layers = m_replay->layers;
+    m_replay->doneCost.reserve(undoArray.size() + 1);
+    m_replay->doneCost << 0;
+    for ( int i = 0; i < undoArray.size(); i++ ) {
+      const QJsonObject cmdObj = undoArray[i].toObject();
+      for ( int id : CommandRegistry::instance().layerIds(cmdObj) ) {
+        if ( id > 0 ) m_replay->lastCommandOfLayer.insert(id,i);
+      }
+      m_replay->doneCost << m_replay->doneCost.last() + CommandRegistry::instance().cost(cmdObj, context);
+    }
+    setProjectReplayActive(true);
+    m_progressBar->setRange(0,1000);
+    m_progressBar->setValue(0);
+    m_progressBar->show();
+    replayProjectStep();
+    
+    return true;
+  }
+}
 
-    // --- 3. Restore Undo/Redo Stack ---
-    QHash<int, QRectF> boundingBoxLayerMap;
-    QList<EditablePolygonCommand*> editablePolygonCommands;
-    EditablePolygonCommand* editablePolyCommand = nullptr;
-    QJsonArray undoArray = root["undoStack"].toArray();
-    for ( const QJsonValue& v : undoArray ) {
-        QJsonObject cmdObj = v.toObject();
+void MainWindow::replayProjectStep()
+{
+  qCDebug(logEditor) << "MainWindow::replayProjectStep(): next =" << ( m_replay ? m_replay->next : -1 );
+  {
+    if ( !m_replay )
+      return;
+    QUndoStack* undoStack = m_imageView->undoStack();
+    // a single warp, cut or transform of a large layer takes longer than a
+    // slice, its pixel work is prepared on a worker thread before the push
+    constexpr qint64 workerCost = 4 * 1024 * 1024;
+    QElapsedTimer slice;
+    slice.start();
+    const int count = m_replay->commands.size();
+    while ( m_replay->next < count && slice.elapsed() < 30 ) {
+        QJsonObject cmdObj = m_replay->commands[m_replay->next].toObject();
         QString type = cmdObj["type"].toString();
         QString text = cmdObj["text"].toString();
-        qCDebug(logEditor) << "MainWindow::loadProject(): Found undo call: type=" << type << ", text=" << text;
+        qCDebug(logEditor) << "MainWindow::replayProjectStep(): Found undo call: type=" << type << ", text=" << text;
+        CommandRegistry::Context context;
+        context.layers = m_replay->layers;
+        context.undoStack = undoStack;
         AbstractCommand* cmd = nullptr;
-        if ( type == "PaintStroke" || type == "PaintStrokeCommand" ) {
-           cmd = PaintStrokeCommand::fromJson(cmdObj, layers);
-        } else if ( type == "LassoCut" || type == "LassoCutCommand" ) {
-           cmd = LassoCutCommand::fromJson(cmdObj, layers);
-           LassoCutCommand* cutCommand = dynamic_cast<LassoCutCommand*>(cmd);
-           if ( cutCommand != nullptr ) {
-             cutCommand->setController(editablePolyCommand);
-           }
-           boundingBoxLayerMap.insert(cutCommand->layerId(),cutCommand->rect());
-        } else if ( type == "MoveLayer" || type == "MoveLayerCommand" ) {
-           cmd = MoveLayerCommand::fromJson(cmdObj, layers);
-        } else if ( type == "MirrorLayer" || type == "MirrorLayerCommand" ) {
-           cmd = MirrorLayerCommand::fromJson(cmdObj, layers);
-        } else if ( type == "CageWarp" || type == "CageWarpCommand" ) {
-           cmd = CageWarpCommand::fromJson(cmdObj, layers);
-        } else if ( type == "TransformLayer" || type == "TransformLayerCommand" ) {
-           cmd = TransformLayerCommand::fromJson(cmdObj, layers);
-        } else if ( type == "PerspectiveTransform" || type == "PerspectiveTransformCommand" ) {
-           // cmd = PerspectiveTransformCommand::fromJson(cmdObj, layers);
-        } else if ( type == "PerspectiveWarp" || type == "PerspectiveWarpCommand" ) {
-           cmd = PerspectiveWarpCommand::fromJson(cmdObj, layers);
-        } else if ( type == "EditablePolygon" || type == "EditablePolygonCommand" ) {
-           cmd = EditablePolygonCommand::fromJson(cmdObj, layers);
-           editablePolyCommand = dynamic_cast<EditablePolygonCommand*>(cmd);
+        if ( CommandRegistry::instance().typeId(type) < 0 ) {
+           qDebug() << LogColor::Red << "MainWindow::replayProjectStep(): " << type << " not yet processed."  << LogColor::Reset;
+        } else {
+           cmd = CommandRegistry::instance().create(cmdObj, context);
+        }
+        if ( LassoCutCommand* cutCommand = dynamic_cast<LassoCutCommand*>(cmd) ) {
+           cutCommand->setController(m_replay->editablePolyCommand);
+           m_replay->boundingBoxLayerMap.insert(cutCommand->layerId(),cutCommand->rect());
+        } else if ( EditablePolygonCommand* editablePolyCommand = dynamic_cast<EditablePolygonCommand*>(cmd) ) {
+           m_replay->editablePolyCommand = editablePolyCommand;
            int npolygons = m_imageView->pushEditablePolygon(editablePolyCommand->model());
            if ( editablePolyCommand->childLayerId() == -1 || npolygons < 0 ) {
-             editablePolygonCommands.push_back(editablePolyCommand);
+             m_replay->editablePolygonCommands.push_back(editablePolyCommand);
            }
-        } else if ( type == "DeleteUndoEntry" || type == "DeleteUndoEntryCommand" ) {
-            cmd = DeleteUndoEntryCommand::fromJson(undoStack, cmdObj, layers);
-        } else {
-           qDebug() << LogColor::Red << "MainWindow::loadProject(): " << type << " not yet processed."  << LogColor::Reset;
         }
-        // ggf. weitere Command-Typen hier hinzufügen
+        const qint64 cost = m_replay->doneCost[m_replay->next + 1] - m_replay->doneCost[m_replay->next];
+        if ( cmd && cost >= workerCost ) {
+          runInBackground(QString("Replaying %1 ...").arg(cmd->text()), [cmd](){ cmd->prepare(); });
+          m_progressBar->setRange(0,1000);
+          m_progressBar->show();
+        }
         if ( cmd )
           undoStack->push(cmd);
+        m_replay->next += 1;
+    }
+    
+    // --- layers without pending commands are final ---
+    QHashIterator<int, int> it(m_replay->lastCommandOfLayer);
+    while ( it.hasNext() ) {
+      it.next();
+      if ( it.value() < m_replay->next ) {
+        m_replay->finalLayers.insert(it.key());
+      }
     }
     
+    if ( m_replay->next >= count ) {
+      finishProjectReplay();
+      return;
+    }
+    // pushing commands re-enables the undo actions
+    m_undoAction->setEnabled(false);
+    m_redoAction->setEnabled(false);
+    m_progressBar->setValue(int(1000 * m_replay->doneCost[m_replay->next] / m_replay->doneCost.last()));
+    m_messageLabel->setText(QString("Replaying history: %1 of %2 commands, %3 of %4 layers final")
+                               .arg(m_replay->next).arg(count)
+                               .arg(m_imageView->layers().size() - m_replay->lastCommandOfLayer.size() + m_replay->finalLayers.size())
+                               .arg(m_imageView->layers().size()));
+    QTimer::singleShot(0, this, &MainWindow::replayProjectStep);
+  }
+}
+
+void MainWindow::finishProjectReplay()
+{
+  qCDebug(logEditor) << "MainWindow::finishProjectReplay(): Processing...";
+  {
     // --- 4. Correct misnamed polygon - layer couples ---
+    QList<EditablePolygonCommand*>& editablePolygonCommands = m_replay->editablePolygonCommands;
+    const QHash<int, QRectF>& boundingBoxLayerMap = m_replay->boundingBoxLayerMap;
     if ( !editablePolygonCommands.isEmpty() ) {
       for ( int i = 0; i < editablePolygonCommands.size(); i++ ) {
         QRectF polyBox = editablePolygonCommands[i]->polygon().boundingRect();
@@ -764,7 +952,29 @@ bool MainWindow::loadProject( const QString& filePath, bool skipMainImage )
     // --- 5. set clean flag in undo stack ---
     m_imageView->undoStack()->setClean();
     
-    return true;
+    const int count = m_replay->commands.size();
+    m_replay.reset();
+    setProjectReplayActive(false);
+    m_progressBar->hide();
+    showMessage(QString("Loaded project '%1' (%2 commands)").arg(QFileInfo(m_projectFileName).fileName()).arg(count));
+  }
+}
+
+void MainWindow::setProjectReplayActive( bool active )
+{
+  qCDebug(logEditor) << "MainWindow::setProjectReplayActive(): active =" << active;
+  {
+    // scrolling, zooming and layer selection stay available
+    m_imageView->setEditingLocked(active);
+    m_undoView->setEnabled(!active);
+    m_openAction->setEnabled(!active);
+    m_openHistoryAction->setEnabled(!active);
+    m_saveHistoryAction->setEnabled(!active);
+    m_sortHistoryAction->setEnabled(!active);
+    m_polygonCreateLayerAction->setEnabled(!active && m_polygonLayerEnabled);
+    m_colorTableCombo->setEnabled(!active);
+    m_undoAction->setEnabled(!active && m_imageView->undoStack()->canUndo());
+    m_redoAction->setEnabled(!active && m_imageView->undoStack()->canRedo());
   }
 }
 
@@ -814,6 +1024,23 @@ void MainWindow::createDockWidgets()
    m_layerList->setSelectionMode(QAbstractItemView::SingleSelection);
    m_layerList->setDragDropMode(QAbstractItemView::InternalMove);
    m_layerList->setDefaultDropAction(Qt::MoveAction);
+   m_thumbnails = new LayerThumbnailCache(QSize(48,48), this);
+   m_layerList->setIconSize(m_thumbnails->size());
+   connect(m_thumbnails, &LayerThumbnailCache::thumbnailChanged, this, [this](int layerId, const QPixmap& thumbnail){
+     for ( int row = 0; row < m_layerList->count(); ++row ) {
+       QListWidgetItem* item = m_layerList->item(row);
+       if ( item->data(Qt::UserRole+1).toInt() == layerId ) {
+         const bool updating = m_updatingLayerList;
+         m_updatingLayerList = true;
+         item->setIcon(QIcon(thumbnail));
+         item->setData(Qt::UserRole+2, thumbnail.cacheKey());
+         m_updatingLayerList = updating;
+         return;
+       }
+     }
+   });
+   // thumbnails follow pixel changes, the entries themselves stay untouched
+   connect(m_imageView->undoStack(), &QUndoStack::indexChanged, this, &MainWindow::refreshLayerThumbnails);
    m_layerDock->setWidget(m_layerList);
    m_layerDock->hide();
    addDockWidget(Qt::RightDockWidgetArea, m_layerDock);
@@ -948,7 +1175,10 @@ void MainWindow::toggleDocks()
   if ( m_historyDock->isVisible() ) m_historyDock->hide();
   else m_historyDock->show();
   if ( m_layerDock->isVisible() ) m_layerDock->hide();
-  else m_layerDock->show();
+  else {
+    m_layerDock->show();
+    refreshLayerThumbnails();
+  }
 }
 
 // --------------------------------- Layer tools ---------------------------------
@@ -1003,14 +1233,15 @@ void MainWindow::toggleLayerVisibility(  QListWidgetItem* item )
     Layer* layer = static_cast<Layer*>(item->data(Qt::UserRole).value<void*>());
     if ( !layer || !layer->m_item ) return;
     // Sichtbarkeit umschalten
-    layer->m_visible = !layer->m_visible;
-    layer->m_item->setVisible(layer->m_visible);
+    if ( auto* layerItem = dynamic_cast<LayerItem*>(layer->m_item) ) {
+      layerItem->setRenderVisible(!layer->m_visible);
+    } else {
+      layer->m_visible = !layer->m_visible;
+      layer->m_item->setVisible(layer->m_visible);
+    }
     // Flag setzen, damit wir Änderungen nicht rekursiv triggern
     m_updatingLayerList = true;
-    // Update Auge-Icon
-    item->setIcon(QIcon(layer->m_visible
-        ? ":/icons/eye_open.png"
-        : ":/icons/eye_closed.png"));
+    // the icon shows the layer thumbnail, visibility is the check state
     // Update CheckState
     item->setCheckState(layer->m_visible ? Qt::Checked : Qt::Unchecked);
     m_updatingLayerList = false;
@@ -1023,25 +1254,70 @@ void MainWindow::updateLayerList() {
    rebuildLayerList();
 }
 
+void MainWindow::refreshLayerThumbnails()
+{
+  qCDebug(logEditor) << "MainWindow::refreshLayerThumbnails(): Processing...";
+  {
+    if ( !m_layerDock->isVisible() )
+      return;
+    for ( int row = 0; row < m_layerList->count(); ++row ) {
+      Layer* layer = static_cast<Layer*>(m_layerList->item(row)->data(Qt::UserRole).value<void*>());
+      auto* layerItem = layer ? dynamic_cast<LayerItem*>(layer->m_item) : nullptr;
+      if ( layerItem && !m_thumbnails->isCurrent(layer->id(), layerItem->contentGeneration()) ) {
+        m_thumbnails->request(layer->id(), layerItem->contentGeneration(), layerItem->previewImage(m_thumbnails->previewExtent()));
+      }
+    }
+  }
+}
+
 void MainWindow::rebuildLayerList()
 {
   qCDebug(logEditor) << "MainWindow::rebuildLayerList(): Rebuild layer list...";
   {
     // updating layer list in docks widget
+    // entries are reused and only moved, added or removed where the layers changed
     m_updatingLayerList = true;
-    m_layerList->clear();
+    QHash<void*, QListWidgetItem*> existing;
+    for ( int row = 0; row < m_layerList->count(); ++row ) {
+        QListWidgetItem* item = m_layerList->item(row);
+        existing.insert(item->data(Qt::UserRole).value<void*>(), item);
+    }
     const auto& layers = m_imageView->layers();
+    int row = 0;
     for ( int i = layers.size()-1; i >= 0; --i ) {
         Layer* layer = layers[i];
         if ( !layer || !layer->m_item || !layer->m_active ) continue;
-        QListWidgetItem* item = new QListWidgetItem(QString("Layer %1").arg(layer->id())); // layer->name());
-        item->setCheckState(layer->m_visible ? Qt::Checked : Qt::Unchecked);
-        item->setData(Qt::UserRole, QVariant::fromValue<void*>(layer));
-        //item->setIcon(layer->m_visible?m_iconOpen:m_iconClosed);
-        //item->setIcon(QIcon(layer->m_visible
-        //    ? ":/icons/eye_open.png"
-        //    : ":/icons/eye_closed.png"));
-        m_layerList->addItem(item);
+        QListWidgetItem* item = existing.take(layer);
+        if ( item == nullptr ) {
+          item = new QListWidgetItem();
+          item->setData(Qt::UserRole, QVariant::fromValue<void*>(layer));
+        } else if ( m_layerList->item(row) != item ) {
+          m_layerList->takeItem(m_layerList->row(item));
+        }
+        if ( m_layerList->item(row) != item ) {
+          m_layerList->insertItem(row, item);
+        }
+        item->setData(Qt::UserRole+1, layer->id());
+        const QString text = QString("Layer %1").arg(layer->id()); // layer->name());
+        if ( item->text() != text ) item->setText(text);
+        const Qt::CheckState checkState = layer->m_visible ? Qt::Checked : Qt::Unchecked;
+        if ( item->checkState() != checkState ) item->setCheckState(checkState);
+        if ( auto* layerItem = dynamic_cast<LayerItem*>(layer->m_item) ) {
+          if ( !m_thumbnails->isCurrent(layer->id(), layerItem->contentGeneration()) ) {
+            m_thumbnails->request(layer->id(), layerItem->contentGeneration(), layerItem->previewImage(m_thumbnails->previewExtent()));
+          }
+          const QPixmap thumbnail = m_thumbnails->thumbnail(layer->id());
+          if ( !thumbnail.isNull() && item->data(Qt::UserRole+2).toLongLong() != thumbnail.cacheKey() ) {
+            item->setIcon(QIcon(thumbnail));
+            item->setData(Qt::UserRole+2, thumbnail.cacheKey());
+          }
+        }
+        row += 1;
+    }
+    for ( QListWidgetItem* stale : std::as_const(existing) ) {
+        // the layer itself may be gone already, use the stored id
+        m_thumbnails->remove(stale->data(Qt::UserRole+1).toInt());
+        delete m_layerList->takeItem(m_layerList->row(stale));
     }
     m_updatingLayerList = false;
     // updating layer list in m_selectLayerItem WITHOUT sending a signal 
@@ -1197,9 +1473,27 @@ void MainWindow::showLayerContextMenu( const QPoint& pos )
           qCDebug(logEditor) << "  geometry: " << layer->m_item->boundingRect();
         }
     });
-    menu.addAction("Delete Layer", this, &MainWindow::deleteLayer);
-    menu.addAction("Merge Layer", this, &MainWindow::mergeLayer);
-    menu.addAction("Duplicate Layer", this, &MainWindow::duplicateLayer);
+    menu.addAction("Solo Layer", [this, item]() {
+        Layer* layer = static_cast<Layer*>(item->data(Qt::UserRole).value<void*>());
+        auto* layerItem = layer ? dynamic_cast<LayerItem*>(layer->m_item) : nullptr;
+        if ( !layerItem ) return;
+        layerItem->setSolo(!layerItem->renderState().solo);
+        showMessage(QString("%1 solo layer %2").arg(layerItem->renderState().solo?"Show":"End").arg(layer->id()));
+    });
+    menu.addAction("Layer Opacity...", [this, item]() {
+        Layer* layer = static_cast<Layer*>(item->data(Qt::UserRole).value<void*>());
+        auto* layerItem = layer ? dynamic_cast<LayerItem*>(layer->m_item) : nullptr;
+        if ( !layerItem ) return;
+        bool ok = false;
+        int value = QInputDialog::getInt(this, "Layer Opacity", QString("Opacity of %1 [%]").arg(layer->name()),
+                                           qRound(layerItem->renderState().opacity * 100), 0, 100, 5, &ok);
+        if ( ok ) layerItem->setRenderOpacity(value / 100.0);
+    });
+    // these change the history, which is read only while a project is replayed
+    const bool editable = !m_imageView->isEditingLocked();
+    menu.addAction("Delete Layer", this, &MainWindow::deleteLayer)->setEnabled(editable);
+    menu.addAction("Merge Layer", this, &MainWindow::mergeLayer)->setEnabled(editable);
+    menu.addAction("Duplicate Layer", this, &MainWindow::duplicateLayer)->setEnabled(editable);
     menu.addAction("Rename Layer", this, &MainWindow::renameLayer);
     menu.addAction("Link to Image", [this, item]() {
         Layer* layer = static_cast<Layer*>(item->data(Qt::UserRole).value<void*>());
@@ -1225,7 +1519,9 @@ void MainWindow::showLayerContextMenu( const QPoint& pos )
         if ( !layer->m_polygon.isEmpty() )
             polygonPoints = layer->m_polygon.size();
         QSize pixmapSize;
-        if ( auto pixmapItem = dynamic_cast<QGraphicsPixmapItem*>(layer->m_item) )
+        if ( auto layerItem = dynamic_cast<LayerItem*>(layer->m_item) )
+            pixmapSize = layerItem->image().size();
+        else if ( auto pixmapItem = dynamic_cast<QGraphicsPixmapItem*>(layer->m_item) )
             pixmapSize = pixmapItem->pixmap().size();
         qInfo() << "Layer Info:";
         qInfo() << " Name:" << layer->name();
@@ -1245,6 +1541,7 @@ void MainWindow::deleteLayer()
 {
   qCDebug(logEditor) << "MainWindow::deleteLayer(): Processing...";
   {
+    if ( m_imageView->isEditingLocked() ) return;
     QListWidgetItem* item = m_layerList->currentItem();
     if ( !item ) return;
     Layer* layer = static_cast<Layer*>(item->data(Qt::UserRole).value<void*>());
@@ -1281,6 +1578,7 @@ void MainWindow::duplicateLayer()
 {
   qCDebug(logEditor) << "MainWindow::duplicateLayer(): Processing...";
   {
+    if ( m_imageView->isEditingLocked() ) return;
     QListWidgetItem* item = m_layerList->currentItem();
     if ( !item ) return;
     Layer* layer = static_cast<Layer*>(item->data(Qt::UserRole).value<void*>());
@@ -1288,7 +1586,9 @@ void MainWindow::duplicateLayer()
     Layer* newLayer = new Layer(100);  // !!! WARNING !!!
     newLayer->m_name = layer->name() + " Copy";
     newLayer->m_visible = layer->m_visible;
-    newLayer->m_item = m_imageView->getScene()->addPixmap(
+    // layer items draw their image and hold no pixmap
+    auto* layerItem = dynamic_cast<LayerItem*>(layer->m_item);
+    newLayer->m_item = m_imageView->getScene()->addPixmap( layerItem ? QPixmap::fromImage(layerItem->image()) :
         static_cast<QGraphicsPixmapItem*>(layer->m_item)->pixmap());
     newLayer->m_item->setPos(layer->m_item->pos());
     newLayer->m_item->setFlags(QGraphicsItem::ItemIsMovable | QGraphicsItem::ItemIsSelectable);
@@ -1619,13 +1919,13 @@ void MainWindow::createToolbars()
     fileToolbar->addAction(m_fitAction);
     fileToolbar->addAction(m_crosshairAction);
     // color tables
-    QComboBox* colorTableCombo = new QComboBox();
-    colorTableCombo->addItems({"Original","Invert","Red","Green","Blue"});
-    fileToolbar->addWidget(colorTableCombo);
-    connect(colorTableCombo, &QComboBox::currentTextChanged, m_imageView, [this](const QString& text){
+    m_colorTableCombo = new QComboBox();
+    m_colorTableCombo->addItems({"Original","Invert","Red","Green","Blue"});
+    fileToolbar->addWidget(m_colorTableCombo);
+    connect(m_colorTableCombo, &QComboBox::currentTextChanged, m_imageView, [this](const QString& text){
        QVector<QRgb> lut(256);
        if (text=="Original") for(int i=0;i<256;i++) lut[i] = qRgb(i,i,i);
-       else if(text=="Invert") for(int i=0;i<256;i++) lut[i] = qRgb(255-i,255-i,255-i);
+       else if(text=="Invert") lut.clear();   // empty table: colour invert of InvertLayerCommand
        else if(text=="Red") for(int i=0;i<256;i++) lut[i] = qRgb(i,0,0);
        else if(text=="Green") for(int i=0;i<256;i++) lut[i] = qRgb(0,i,0);
        else if(text=="Blue") for(int i=0;i<256;i++) lut[i] = qRgb(0,0,i);
@@ -1731,6 +2031,18 @@ void MainWindow::createToolbars()
       m_imageView->setBrushHardness(val/100.0);
       hardnessValueLabel->setText(QString::number(val) + "%");
     });
+    // Brush mode
+    QLabel* brushModeLabel = new QLabel(" Mode:");
+    m_editToolbar->addWidget(brushModeLabel);
+    QComboBox* brushModeCombo = new QComboBox();
+    brushModeCombo->setFocusPolicy(Qt::ClickFocus);
+    brushModeCombo->addItem("Dabs", BrushEngine::Dabs);
+    brushModeCombo->addItem("Capsule", BrushEngine::Capsule);
+    brushModeCombo->setToolTip("Dabs: stamp the brush along the stroke. Capsule: render each segment analytically, every pixel is blended once.");
+    m_editToolbar->addWidget(brushModeCombo);
+    connect(brushModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), m_imageView, [this,brushModeCombo](int){
+      m_imageView->setBrushMode(brushModeCombo->currentData().toInt());
+    });
     
     // ============================================================
     // create layer toolbar
@@ -2133,12 +2445,25 @@ void MainWindow::createStatusbar()
     QLabel* cursorColorLabel = new QLabel(this);
     cursorColorLabel->setFixedSize(24,24);
     QLabel* cursorColorText = new QLabel(this);
-
+    QLabel* undoMemoryLabel = new QLabel(this);
+    m_progressBar = new QProgressBar(this);
+    m_progressBar->setMaximumWidth(160);
+    m_progressBar->setMaximumHeight(16);
+    m_progressBar->setTextVisible(false);
+    m_progressBar->hide();
+
+    statusBar()->addPermanentWidget(m_progressBar);
+    statusBar()->addPermanentWidget(undoMemoryLabel);
     statusBar()->addPermanentWidget(scaleLabel);
     statusBar()->addPermanentWidget(posLabel);
     statusBar()->addPermanentWidget(cursorColorText);
     statusBar()->addPermanentWidget(cursorColorLabel);
     
+    connect(m_imageView, &ImageView::undoMemoryChanged, this, [undoMemoryLabel](qint64 resident, qint64 spilled){
+        undoMemoryLabel->setText(QString("Undo: %1 MB").arg(resident / 1048576.0, 0, 'f', 1) 
+           + ( spilled > 0 ? QString(" (spilled %1 MB)").arg(spilled / 1048576.0, 0, 'f', 1) : QString() ) + "  |");
+    });
+    
     connect(m_imageView, &ImageView::scaleChanged, this, [scaleLabel](double scale){
         scaleLabel->setText(QString("Scale: %1×").arg(scale, 0, 'f', 2));
     });
@@ -2266,10 +2591,12 @@ void MainWindow::setPolygonOperationMode( int mode )
   qCDebug(logEditor) << "MainWindow::setPolygonOperationMode(): mode =" << mode;
   {
     if ( mode == -1 ) {
+     m_polygonLayerEnabled = false;
      m_polygonCreateLayerAction->setEnabled(false);
      m_polygonAction->setEnabled(true);
     } else if ( mode == -2 ) {
-     m_polygonCreateLayerAction->setEnabled(true);
+     m_polygonLayerEnabled = true;
+     m_polygonCreateLayerAction->setEnabled(!m_imageView->isEditingLocked());
      m_polygonAction->setEnabled(false);
     } else {
      m_polygonOperationItem->setCurrentIndex(mode-10);
@@ -31,10 +31,20 @@
 #include <QToolBar>
 #include <QLabel>
 #include <QIcon>
+#include <QJsonArray>
+#include <QHash>
+#include <QSet>
+#include <QRectF>
+
+#include <functional>
+#include <memory>
 
 class ImageView;
 class LayerItem;
+class EditablePolygonCommand;
+class QProgressBar;
 class DarkHistoryDelegate;
+class LayerThumbnailCache;
 
 class MainWindow : public QMainWindow, public IMainSystem
 {
@@ -80,6 +90,7 @@ class MainWindow : public QMainWindow, public IMainSystem
  private slots:
 
     void rebuildLayerList();
+    void refreshLayerThumbnails();
     void newLassoLayerCreated();
     void toggleLayerVisibility( QListWidgetItem* item );
     void layerItemClicked( QListWidgetItem* item );
@@ -110,9 +121,14 @@ class MainWindow : public QMainWindow, public IMainSystem
     
     bool checkUnsavedData( bool isCloseProgram = true );
     bool loadImage( const QString&, bool askForNewLoad=false );
+    bool decodeImage( const QString& filePath, QImage& image, QString& checksum, bool& canceled );
     void loadHistory( const QString& );
     bool saveProject( const QString& );
     bool loadProject( const QString&, bool );
+    void replayProjectStep();
+    void finishProjectReplay();
+    void setProjectReplayActive( bool active );
+    void runInBackground( const QString& message, const std::function<void()>& work );
     
     void createDockWidgets();
     void createActions();
@@ -133,6 +149,7 @@ class MainWindow : public QMainWindow, public IMainSystem
     QDockWidget* m_layerDock;
     QDockWidget* m_historyDock;
     QListWidget* m_layerList;
+    LayerThumbnailCache* m_thumbnails = nullptr;
     
     QToolBar* m_editToolbar = nullptr;
     QToolBar* m_lassoToolbar = nullptr;
@@ -180,12 +197,14 @@ class MainWindow : public QMainWindow, public IMainSystem
     QAction* m_infoAction = nullptr; 
     
     QLabel *m_messageLabel = nullptr;
+    QProgressBar* m_progressBar = nullptr;
     
     QComboBox* m_polygonIndexBox = nullptr;
     QComboBox* m_transformLayerItem = nullptr;
     QComboBox* m_polygonOperationItem = nullptr;
     QComboBox* m_selectLayerItem = nullptr;
     QComboBox* m_mirrorDirectionCombo = nullptr;
+    QComboBox* m_colorTableCombo = nullptr;
     
     QDoubleSpinBox* m_rotationLayerAngleSpin = nullptr;
     QDoubleSpinBox* m_scaleXLayerSpin = nullptr;
@@ -199,5 +218,20 @@ class MainWindow : public QMainWindow, public IMainSystem
     
     bool m_updatingLayerList = false;
     bool m_saveImageDataInProjectFile = false;
+    bool m_polygonLayerEnabled = true;      // state of the create polygon layer action outside of replays
+    
+    // --- undo history of a loaded project, replayed in time slices ---
+    struct ProjectReplay {
+      QJsonArray commands;
+      int next = 0;
+      QList<LayerItem*> layers;
+      QHash<int, QRectF> boundingBoxLayerMap;
+      QList<EditablePolygonCommand*> editablePolygonCommands;
+      EditablePolygonCommand* editablePolyCommand = nullptr;
+      QHash<int, int> lastCommandOfLayer;     // layer id -> index of its last command
+      QVector<qint64> doneCost;               // estimated cost of the commands before index i
+      QSet<int> finalLayers;
+    };
+    std::unique_ptr<ProjectReplay> m_replay;
     
 };
\ No newline at end of file
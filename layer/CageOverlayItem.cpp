@@ -20,12 +20,17 @@
 #include "CageMesh.h"
 #include "../core/Config.h"
 
+#include <QGraphicsSceneMouseEvent>
 #include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QtMath>
 
 CageOverlayItem::CageOverlayItem( LayerItem* layer ) : m_layer(layer)
 {
     setZValue(10000);
-    setAcceptedMouseButtons(Qt::NoButton);
+    // presses which do not hit a control point are ignored and reach the layer
+    setAcceptedMouseButtons(Qt::LeftButton);
+    setFlag(ItemUsesExtendedStyleOption);
 }
 
 QRectF CageOverlayItem::boundingRect() const
@@ -33,34 +38,177 @@ QRectF CageOverlayItem::boundingRect() const
     return m_layer->boundingRect();
 }
 
-void CageOverlayItem::paint( QPainter* p, const QStyleOptionGraphicsItem*, QWidget* )
+void CageOverlayItem::setHandlesVisible( bool visible )
+{
+    if ( m_handlesVisible == visible )
+        return;
+    m_handlesVisible = visible;
+    if ( !visible )
+        m_activePoint = -1;
+    update();
+}
+
+qreal CageOverlayItem::handleRadius() const
+{
+    return qMax(1, m_layer->cageMesh().getRadius());
+}
+
+// Square of a control point as drawn, boundary points are shifted inwards
+QRectF CageOverlayItem::handleRect( const QPointF& point, int index, int cols, int rows, qreal r )
+{
+    const int col = index % cols;
+    const int row = index / cols;
+    const qreal dx = ( col == 0 ) ? 0 : ( ( col == cols - 1 ) ? -2 * r : -r );
+    const qreal dy = ( row == 0 ) ? 0 : ( ( row == rows - 1 ) ? -2 * r : -r );
+    return QRectF(point.x() + dx, point.y() + dy, 2 * r, 2 * r);
+}
+
+// The batch holds the centers of the drawn handles. It is only refilled when
+// the mesh changed: m_meshPoints shares the point array with the mesh, so any
+// change of the mesh detaches it.
+void CageOverlayItem::syncHandles()
+{
+    const CageMesh& mesh = m_layer->cageMesh();
+    const QVector<QPointF>& pts = mesh.points();
+    const qreal r = handleRadius();
+    if ( m_meshPoints.isSharedWith(pts) && m_handleRadius == r && m_cols == mesh.cols() && m_rows == mesh.rows() )
+        return;
+    m_meshPoints = pts;
+    m_handleRadius = r;
+    m_cols = mesh.cols();
+    m_rows = mesh.rows();
+    QVector<QPointF> centers;
+    if ( m_cols > 0 && m_rows > 0 && pts.size() >= m_cols * m_rows ) {
+        centers.reserve(pts.size());
+        for ( int i = 0; i < pts.size(); ++i ) {
+            centers.append(handleRect(pts[i], i, m_cols, m_rows, r).center());
+        }
+    }
+    m_batch.setPoints(centers);
+}
+
+void CageOverlayItem::paint( QPainter* p, const QStyleOptionGraphicsItem* opt, QWidget* )
 {
   // qDebug() << "CageOverlayItem::paint(): Processing...";
   {
     const CageMesh& mesh = m_layer->cageMesh();
     if ( mesh.pointCount() == 0 )
         return;
-    QPen pen(EditorStyle::instance().cageGridColor()); // Cage color
-    pen.setWidth(0);
-    p->setPen(pen);
+    const QRectF exposed = opt != nullptr ? opt->exposedRect : boundingRect();
+    const qreal lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(p->worldTransform());
     int cols = mesh.cols();
     int rows = mesh.rows();
     const auto& pts = mesh.points();
+    if ( cols < 1 || rows < 1 || pts.size() < cols * rows )
+        return;
+    // zoomed out the grid lines would merge, only every step-th row/column is drawn
+    int step = 1;
+    const QRectF bounds = QPolygonF(pts).boundingRect();
+    const qreal spacing = qMin(bounds.width() / qMax(1, cols - 1), bounds.height() / qMax(1, rows - 1)) * lod;
+    if ( spacing > 0.0 && spacing < 4.0 )
+        step = qCeil(4.0 / spacing);
+    auto kept = [step]( int i, int n ) { return i % step == 0 || i == n - 1; };
+    QVector<QLineF> lines;
+    auto addLine = [&]( const QPointF& a, const QPointF& b ) {
+        if ( QRectF(a, b).normalized().adjusted(-1, -1, 1, 1).intersects(exposed) )
+            lines.append(QLineF(a, b));
+    };
     // horizontale Linien
     for ( int y = 0; y < rows; ++y ) {
-        for ( int x = 0; x + 1 < cols; ++x ) {
-            int i1 = y * cols + x;
-            int i2 = i1 + 1;
-            p->drawLine(pts[i1], pts[i2]);
+        if ( !kept(y, rows) ) continue;
+        int prev = 0;
+        for ( int x = 1; x < cols; ++x ) {
+            if ( !kept(x, cols) ) continue;
+            addLine(pts[y * cols + prev], pts[y * cols + x]);
+            prev = x;
         }
     }
     // vertikale Linien
     for ( int x = 0; x < cols; ++x ) {
-        for ( int y = 0; y + 1 < rows; ++y ) {
-            int i1 = y * cols + x;
-            int i2 = i1 + cols;
-            p->drawLine(pts[i1], pts[i2]);
+        if ( !kept(x, cols) ) continue;
+        int prev = 0;
+        for ( int y = 1; y < rows; ++y ) {
+            if ( !kept(y, rows) ) continue;
+            addLine(pts[prev * cols + x], pts[y * cols + x]);
+            prev = y;
         }
     }
+    QPen pen(EditorStyle::instance().cageGridColor()); // Cage color
+    pen.setWidth(0);
+    p->setPen(pen);
+    p->drawLines(lines);
+    if ( !m_handlesVisible )
+        return;
+    // control points, boundary points are shifted inwards
+    syncHandles();
+    const qreal r = m_handleRadius;
+    const QVector<int> visible = m_batch.visibleIndices(exposed, r, lod, qMax(2 * r * lod, 4.0));
+    QVector<QRectF> rects;
+    rects.reserve(visible.size());
+    for ( int i : visible ) {
+        rects.append(handleRect(pts[i], i, cols, rows, r));
+    }
+    p->setPen(QPen(Qt::black, 0));
+    p->setBrush(EditorStyle::instance().controlPointColor());
+    p->drawRects(rects);
+  }
+}
+
+// ---------------- Interaction ----------------
+
+void CageOverlayItem::mousePressEvent( QGraphicsSceneMouseEvent* e )
+{
+  qCDebug(logEditor) << "CageOverlayItem::mousePressEvent(): Processing...";
+  {
+    m_activePoint = -1;
+    if ( !m_handlesVisible || e->button() != Qt::LeftButton ) {
+      e->ignore();
+      return;
+    }
+    // nearest drawn handle, the press has to be inside its square
+    syncHandles();
+    m_activePoint = m_batch.hitTest(e->pos(), M_SQRT2 * m_handleRadius);
+    if ( m_activePoint >= 0 &&
+         !handleRect(m_meshPoints[m_activePoint], m_activePoint, m_cols, m_rows, m_handleRadius).contains(e->pos()) ) {
+      m_activePoint = -1;
+    }
+    if ( m_activePoint < 0 ) {
+      e->ignore();
+      return;
+    }
+    // The purpose of this offset is to account for the small
+    // distance between the mouse click position and the center of
+    // the control point. This gives a smooth motion of the cage.
+    QPointF local = m_layer->mapFromScene(e->scenePos());
+    m_clickOffset = local - m_layer->cageMesh().point(m_activePoint);
+    m_layer->setCageEditing(true);
+    e->accept();
+  }
+}
+
+void CageOverlayItem::mouseMoveEvent( QGraphicsSceneMouseEvent* e )
+{
+  qCDebug(logEditor) << "CageOverlayItem::mouseMoveEvent(): index =" << m_activePoint;
+  {
+    if ( m_activePoint < 0 ) {
+      e->ignore();
+      return;
+    }
+    m_layer->setCagePoint(m_activePoint, e->scenePos() - m_clickOffset);
+    e->accept();
+  }
+}
+
+void CageOverlayItem::mouseReleaseEvent( QGraphicsSceneMouseEvent* e )
+{
+  qCDebug(logEditor) << "CageOverlayItem::mouseReleaseEvent(): index =" << m_activePoint;
+  {
+    if ( m_activePoint < 0 ) {
+      e->ignore();
+      return;
+    }
+    m_activePoint = -1;
+    m_layer->setCageEditing(false);
+    e->accept();
   }
 }
@@ -19,6 +19,8 @@
 
 #include <QGraphicsItem>
 
+#include "OverlayBatch.h"
+
 class LayerItem;
 
 class CageOverlayItem : public QGraphicsItem
@@ -28,9 +30,31 @@ class CageOverlayItem : public QGraphicsItem
     explicit CageOverlayItem( LayerItem* layer );
 
     QRectF boundingRect() const override;
-    void paint( QPainter* p, const QStyleOptionGraphicsItem*, QWidget* ) override;
+    void paint( QPainter* p, const QStyleOptionGraphicsItem* opt, QWidget* ) override;
+
+    // control points are part of the overlay, no item per point
+    void setHandlesVisible( bool visible );
+    bool handlesVisible() const { return m_handlesVisible; }
+
+  protected:
+
+    void mousePressEvent( QGraphicsSceneMouseEvent* e ) override;
+    void mouseMoveEvent( QGraphicsSceneMouseEvent* e ) override;
+    void mouseReleaseEvent( QGraphicsSceneMouseEvent* e ) override;
 
   private:
   
+    qreal handleRadius() const;
+    static QRectF handleRect( const QPointF& point, int index, int cols, int rows, qreal r );
+    void syncHandles();
+
     LayerItem* m_layer;
+    OverlayBatch m_batch;         // centers of the drawn handles
+    QVector<QPointF> m_meshPoints;  // shared with the mesh while it is unchanged
+    qreal m_handleRadius = 0.0;
+    int m_cols = 0;
+    int m_rows = 0;
+    bool m_handlesVisible = false;
+    int m_activePoint = -1;
+    QPointF m_clickOffset;
 };
@@ -0,0 +1,82 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "CageWarpPipeline.h"
+
+#include <QMutexLocker>
+#include <QThread>
+
+// -------------------------- CageWarpPipeline --------------------------
+CageWarpPipeline::CageWarpPipeline( QObject* parent ) : QObject(parent)
+{
+  m_thread = QThread::create([this](){ run(); });
+  m_thread->start(QThread::LowPriority);
+}
+
+CageWarpPipeline::~CageWarpPipeline()
+{
+  {
+    QMutexLocker locker(&m_mutex);
+    m_quit = true;
+    m_pending = nullptr;
+    m_generation += 1;
+  }
+  m_wake.wakeAll();
+  m_thread->wait();
+  delete m_thread;
+}
+
+quint64 CageWarpPipeline::request( const WarpJob& job )
+{
+  QMutexLocker locker(&m_mutex);
+  // bumping the generation also cancels the warp in flight
+  m_pending = job;
+  m_pendingGeneration = ++m_generation;
+  m_wake.wakeOne();
+  return m_pendingGeneration;
+}
+
+void CageWarpPipeline::cancel()
+{
+  QMutexLocker locker(&m_mutex);
+  m_pending = nullptr;
+  m_generation += 1;
+}
+
+void CageWarpPipeline::run()
+{
+  for (;;) {
+    WarpJob job;
+    quint64 generation = 0;
+    {
+      QMutexLocker locker(&m_mutex);
+      while ( !m_quit && !m_pending ) {
+        m_wake.wait(&m_mutex);
+      }
+      if ( m_quit )
+        return;
+      job = std::move(m_pending);
+      m_pending = nullptr;
+      generation = m_pendingGeneration;
+    }
+    const CancelFn isCanceled = [this, generation](){ return m_generation.load() != generation; };
+    const QImage frame = job(isCanceled);
+    if ( !frame.isNull() && !isCanceled() ) {
+      emit frameReady(frame, generation);
+    }
+  }
+}
@@ -0,0 +1,66 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+#include <QObject>
+#include <QImage>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <functional>
+
+class QThread;
+
+// -------------------------- CageWarpPipeline --------------------------
+// Single worker thread for interactive warps. Requests go into a one slot
+// mailbox, a newer request replaces a pending one and cancels the warp in
+// flight. Finished frames are queued to the thread owning the pipeline,
+// frames of outdated requests are dropped.
+class CageWarpPipeline : public QObject {
+    Q_OBJECT
+
+public:
+
+    using CancelFn = std::function<bool()>;
+    using WarpJob = std::function<QImage( const CancelFn& isCanceled )>;
+
+    explicit CageWarpPipeline( QObject* parent = nullptr );
+    ~CageWarpPipeline() override;
+
+    quint64 request( const WarpJob& job );
+    void cancel();
+    quint64 generation() const { return m_generation.load(); }
+
+signals:
+
+    void frameReady( const QImage& frame, quint64 generation );
+
+private:
+
+    void run();
+
+    QThread* m_thread = nullptr;
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    WarpJob m_pending;
+    quint64 m_pendingGeneration = 0;
+    bool m_quit = false;
+    std::atomic<quint64> m_generation{0};
+
+};
@@ -18,18 +18,16 @@
 #include "EditablePolygon.h"
 
 #include "../undo/AbstractCommand.h"
-#include "../undo/PolygonTranslateCommand.h"
-#include "../undo/PolygonDeletePointCommand.h"
-#include "../undo/PolygonTranslateCommand.h"
-#include "../undo/PolygonInsertPointCommand.h"
-#include "../undo/PolygonMovePointCommand.h"
-#include "../undo/PolygonSmoothCommand.h"
-#include "../undo/PolygonReduceCommand.h"
+#include "../undo/CommandRegistry.h"
 
 #include "../gui/MainWindow.h"
 #include "../core/Config.h"
+#include "../util/PolygonSimplify.h"
+#include "../util/SplineSmooth.h"
 
 #include <QDebug>
+#include <QLineF>
+#include <QPainterPath>
 
 #include <iostream>
 
@@ -80,28 +78,65 @@ void EditablePolygon::translate( const QPointF& delta )
   emit changed();
 }
 
-// --- smooth edges (Cubic splines / bezier-curves) ---
-void EditablePolygon::smooth()
+// --- smooth edges (cubic splines) ---
+// maxError: max. distance (pixel) between the spline and the new edges
+// maxPoints: vertex budget, 0 keeps max(current points, 256), so repeated smoothing does not grow the polygon
+// basis: SplineSmooth::CatmullRom (through the points) or SplineSmooth::BSpline (rounder, shrinks slightly)
+void EditablePolygon::smooth( qreal maxError, int maxPoints, int basis )
 {
-  QPainterPath path;
-  if ( !m_polygon.isEmpty() ) {
-     path.moveTo(m_polygon.at(0));
-     int np = m_polygon.size();
-     for ( int i = 1; i <= m_polygon.size(); ++i ) {
+  qCDebug(logEditor) << "EditablePolygon::smooth(): maxError=" << maxError << ", maxPoints=" << maxPoints << ", basis=" << basis << ", points=" << m_polygon.size();
+  {
+    if ( m_polygon.size() < 3 )
+      return;
+    const int budget = maxPoints > 0 ? maxPoints : qMax(int(m_polygon.size()), 256);
+    m_polygon = SplineSmooth::smooth(m_polygon, basis == SplineSmooth::BSpline ? SplineSmooth::BSpline : SplineSmooth::CatmullRom, maxError, budget);
+    emit changed();
+  }
+}
+
+// --- reduce number of points ---
+// tolerance: max. distance (pixel) of a dropped point to the new outline (Douglas-Peucker)
+// targetCount > 0: keep this many points, least significant first (Visvalingam-Whyatt)
+void EditablePolygon::reduce( qreal tolerance, int targetCount )
+{
+  qCDebug(logEditor) << "EditablePolygon::reduce(): tolerance=" << tolerance << ", target=" << targetCount << ", points=" << m_polygon.size();
+  {
+    if ( m_polygon.size() <= 3 )
+      return;
+    const QPolygonF reduced = targetCount > 0 ? PolygonSimplify::visvalingam(m_polygon, 0.0, targetCount)
+                                              : PolygonSimplify::douglasPeucker(m_polygon, tolerance);
+    if ( reduced.size() == m_polygon.size() )
+      return;
+    m_polygon = reduced;
+    emit changed();
+  }
+}
+
+// --- projects saved before the spline / Douglas-Peucker versions ---
+// replayed with the old algorithms, so their history gives the same points
+void EditablePolygon::smoothLegacy()
+{
+  qCDebug(logEditor) << "EditablePolygon::smoothLegacy(): points=" << m_polygon.size();
+  {
+    QPainterPath path;
+    if ( !m_polygon.isEmpty() ) {
+      path.moveTo(m_polygon.at(0));
+      int np = m_polygon.size();
+      for ( int i = 1; i <= m_polygon.size(); ++i ) {
         int i1 = (i-1) % np;
         int i2 = i % np;
         QPointF midPoint = (m_polygon.at(i1) + m_polygon.at(i2)) / 2;
         path.quadTo(m_polygon.at(i1), midPoint);
-     }
-     m_polygon = path.toFillPolygon();
+      }
+      m_polygon = path.toFillPolygon();
+    }
+    emit changed();
   }
-  emit changed();
 }
 
-// --- reduce number of points (Douglas-Peucker-Algorithmus) ---
-void EditablePolygon::reduce( qreal tolerance )
+void EditablePolygon::reduceLegacy( qreal tolerance )
 {
-  qCDebug(logEditor) << "EditablePolygon::reduce(): tolerance=" << tolerance;
+  qCDebug(logEditor) << "EditablePolygon::reduceLegacy(): tolerance=" << tolerance << ", points=" << m_polygon.size();
   {
     if ( m_polygon.size() > 3 ) {
       QPainterPath path;
@@ -110,7 +145,6 @@ void EditablePolygon::reduce( qreal tolerance )
       m_polygon = simplifiedPath.toFillPolygon();
       emit changed();
     }
-    // does not work
     if ( m_polygon.size() > 3 ) {
       QPolygonF result;
       result << m_polygon.first();
@@ -141,13 +175,16 @@ QPointF EditablePolygon::point( int idx ) const
 void EditablePolygon::addPoint( const QPointF& p )
 {
     m_polygon << p;
+    emit pointInserted(m_polygon.size() - 1);
     emit changed();
 }
 
 void EditablePolygon::setPoint( int idx, const QPointF& p )
 {
     if ( idx < 0 || idx >= m_polygon.size() ) return;
+    const QPointF oldPos = m_polygon[idx];
     m_polygon[idx] = p;
+    emit pointMoved(idx, oldPos);
     emit changed();
 }
 
@@ -158,13 +195,16 @@ void EditablePolygon::insertPoint( int idx, const QPointF& p )
       IMainSystem::instance()->showMessage(QString("Inserted point (%1:%2) at position %3").arg(p.x()).arg(p.y()).arg(idx));
     }
     m_polygon.insert(idx, p);
+    emit pointInserted(idx);
     emit changed();
 }
 
 void EditablePolygon::removePoint( int idx )
 {
     if ( idx < 0 || idx >= m_polygon.size() ) return;
+    const QPointF oldPos = m_polygon[idx];
     m_polygon.removeAt(idx);
+    emit pointRemoved(idx, oldPos);
     emit changed();
 }
 
@@ -207,29 +247,11 @@ void EditablePolygon::undoStackFromJson( const QJsonArray& arr )
   qCDebug(logEditor) << "EditablePolygon::undoStackFromJson(): Processing...";
   {
     m_undoStack.clear();
+    CommandRegistry::Context context;
+    context.polygon = this;
     for ( const QJsonValue& v : arr ) {
         QJsonObject o = v.toObject();
-        QString type = o["type"].toString();
-        AbstractCommand* cmd = nullptr;
-        if ( type == "PolygonMovePoint" )
-            cmd = PolygonMovePointCommand::fromJson(o, this);
-        else if ( type == "PolygonInsertPoint" )
-            cmd = PolygonInsertPointCommand::fromJson(o, this);
-        else if ( type == "PolygonDeletePoint" )
-            cmd = PolygonDeletePointCommand::fromJson(o, this);
-        else if ( type == "TranslatePolygon" )
-        	cmd = PolygonTranslateCommand::fromJson(o, this);
-        else if ( type == "SmoothPolygon" )
-        	cmd = PolygonSmoothCommand::fromJson(o, this);
-        else if ( type == "ReducePolygon" )
-        	cmd = PolygonReduceCommand::fromJson(o, this);
-        else if ( type == "PolygonTranslate" )
-        	cmd = PolygonTranslateCommand::fromJson(o, this);
-        else if ( type == "PolygonSmooth" )
-            cmd = PolygonSmoothCommand::fromJson(o, this);
-        else if ( type == "PolygonReduce" )
-            cmd = PolygonReduceCommand::fromJson(o, this);
-        else qDebug() << "EditablePolygon::undoStackFromJson(): " << type << " not found.";
+        AbstractCommand* cmd = CommandRegistry::instance().create(o, context);
         if ( cmd ) 
             m_undoStack.push(cmd);
     }
@@ -48,9 +48,11 @@ class EditablePolygon : public QObject
     QPointF point( int idx ) const;
 
     // --- Modifikation (NUR über Commands aufrufen!) ---
-    void smooth();
+    void smooth( qreal maxError = 0.25, int maxPoints = 0, int basis = 0 );
     void remove();
-    void reduce( qreal tolerance = 0.5 );
+    void reduce( qreal tolerance = 0.5, int targetCount = 0 );
+    void smoothLegacy();
+    void reduceLegacy( qreal tolerance = 0.5 );
     void translate( const QPointF& d );
     void addPoint( const QPointF& p );
     void setPoint( int idx, const QPointF& p );
@@ -81,6 +83,10 @@ class EditablePolygon : public QObject
  signals:
 
     void changed();
+    // single point edits, emitted right before changed() (views update incrementally)
+    void pointMoved( int idx, const QPointF& oldPos );
+    void pointInserted( int idx );
+    void pointRemoved( int idx, const QPointF& oldPos );
     void visibilityChanged();
     void selectionChanged();
 
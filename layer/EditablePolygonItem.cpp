@@ -16,6 +16,7 @@
 */
 
 #include "EditablePolygonItem.h"
+#include "OverlayBatch.h"
 
 #include "../gui/MainWindow.h"
 #include "../undo/PolygonTranslateCommand.h"
@@ -27,8 +28,10 @@
 
 #include <QPainter>
 #include <QGraphicsSceneMouseEvent>
+#include <QStyleOptionGraphicsItem>
 #include <QtMath>
 
+#include <cmath>
 #include <iostream>
 
 // --------------------------------- Constructor ---------------------------------
@@ -44,18 +47,23 @@ EditablePolygonItem::EditablePolygonItem( EditablePolygon* poly, QGraphicsItem*
     Q_ASSERT(m_layer);
     setParentItem(nullptr);
     setZValue(99999);
-    setFlags(ItemIsSelectable | ItemIsFocusable);
+    setFlags(ItemIsSelectable | ItemIsFocusable | ItemUsesExtendedStyleOption);
     setAcceptHoverEvents(true);
+    // the point signals arrive before changed()
+    connect(m_poly, &EditablePolygon::pointMoved, this, &EditablePolygonItem::onPointMoved);
+    connect(m_poly, &EditablePolygon::pointInserted, this, &EditablePolygonItem::onPointInserted);
+    connect(m_poly, &EditablePolygon::pointRemoved, this, &EditablePolygonItem::onPointRemoved);
     connect(m_poly, &EditablePolygon::changed, this, &EditablePolygonItem::updateGeometry);
     connect(m_poly, &EditablePolygon::visibilityChanged, this, &EditablePolygonItem::onVisibilityChanged);
     connect(m_poly, &EditablePolygon::selectionChanged, this, &EditablePolygonItem::onSelectionChanged);
-    rebuildHandles();
+    rebuildIndex();
   }
 }
 
 QRectF EditablePolygonItem::boundingRect() const
 {
-    QRectF rect = m_poly->boundingRect();
+    // the index bounds are kept up to date without a scan over all points
+    QRectF rect = m_index.bounds();
     if ( rect.width() <= 0 || rect.height() <= 0 ) {
       rect = QRectF(0, 0, 1, 1);
     } else {
@@ -64,7 +72,7 @@ QRectF EditablePolygonItem::boundingRect() const
     return rect;
 }
 
-void EditablePolygonItem::paint( QPainter* p, const QStyleOptionGraphicsItem*, QWidget* )
+void EditablePolygonItem::paint( QPainter* p, const QStyleOptionGraphicsItem* opt, QWidget* )
 {
   qCDebug(logEditor) << "EditablePolygonItem::paint(): m_handleRadius =" << m_handleRadius;
   {
@@ -74,26 +82,33 @@ void EditablePolygonItem::paint( QPainter* p, const QStyleOptionGraphicsItem*, Q
     if ( poly.size() < 2 )
         return;
     p->setRenderHint(QPainter::Antialiasing);
-    if ( m_poly->isSelected() ) {
-      // Fill
-      p->setBrush(m_fillColor);
-      // p->setPen(QPen(m_lineColor, 1.5));
-      p->setPen(QPen(m_lineColor, 0.375*m_handleRadius));
-      p->drawPolygon(poly);
-      // Outline
-      p->setBrush(Qt::NoBrush);
-      p->setPen(QPen(m_lineColor, 0.5*m_handleRadius, Qt::DashLine));  // was 2
-      p->drawPolyline(poly);
-    } else {
-      // Fill
-      p->setBrush(m_fillColor);
-      p->setPen(QPen(m_lineColor, 0.375*m_handleRadius));  // was 1.5
-      p->drawPolygon(poly);
-      // Outline
-      p->setBrush(Qt::NoBrush);
-      p->setPen(QPen(m_lineColor, 0.5*m_handleRadius, Qt::SolidLine));   // was 2
-      p->drawPolyline(poly);
+    const QRectF exposed = opt != nullptr ? opt->exposedRect : boundingRect();
+    const qreal lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(p->worldTransform());
+    // Fill: whole polygon, vertices closer than half a screen pixel merged
+    p->setPen(Qt::NoPen);
+    p->setBrush(m_fillColor);
+    p->drawPolygon(fillPolygon(lod));
+    // Outline: only edges crossing the exposed rect
+    const QPainterPath outline = outlinePath(exposed.adjusted(-m_handleRadius, -m_handleRadius, m_handleRadius, m_handleRadius), lod);
+    p->setBrush(Qt::NoBrush);
+    p->setPen(QPen(m_lineColor, 0.375*m_handleRadius));  // was 1.5
+    p->drawPath(outline);
+    p->setPen(QPen(m_lineColor, 0.5*m_handleRadius, m_poly->isSelected() ? Qt::DashLine : Qt::SolidLine));  // was 2
+    p->drawPath(outline);
+    // Handles: culled to the exposed rect, one per handle sized screen cell
+    if ( !m_handlesVisible )
+      return;
+    const QVector<int> visible = m_index.verticesIn(poly, exposed.adjusted(-m_handleRadius, -m_handleRadius, m_handleRadius, m_handleRadius));
+    ScreenCellFilter cells(qMax(2 * m_handleRadius, 3.0 / qMax(lod, 1e-6)));
+    QPolygonF handles;
+    handles.reserve(visible.size());
+    for ( int i : visible ) {
+      if ( cells.accept(poly[i]) )
+        handles.append(poly[i]);
     }
+    p->setBrush(Qt::NoBrush);
+    p->setPen(QPen(m_handleColor, 2 * m_handleRadius, Qt::SolidLine, Qt::RoundCap));
+    p->drawPoints(handles);
   }
 }
 
@@ -220,7 +235,10 @@ void EditablePolygonItem::mouseDoubleClickEvent( QGraphicsSceneMouseEvent* e )
         return;
      }
     } else if ( mode == LayerItem::OperationMode::ReducePolygon ) {
-     m_poly->undoStack()->push(new PolygonReduceCommand(m_poly));
+     // Shift: down to a share of the points (Visvalingam-Whyatt), else by distance (Douglas-Peucker)
+     const EditorStyle& style = EditorStyle::instance();
+     const int targetCount = ( e->modifiers() & Qt::ShiftModifier ) ? qMax(3, m_poly->pointCount() * style.polygonReducePercent() / 100) : 0;
+     m_poly->undoStack()->push(new PolygonReduceCommand(m_poly, style.polygonReduceTolerance(), targetCount));
      e->accept();
      return;
     } else if ( mode == LayerItem::OperationMode::SmoothPolygon ) {
@@ -250,30 +268,15 @@ void EditablePolygonItem::pointMoved( int idx, const QPointF& scenePos )
 
 int EditablePolygonItem::hitTestPoint( const QPointF& scenePos ) const
 {
-    for ( int i = 0; i < m_handles.size(); ++i ) {
-        if ( QLineF(m_handles[i]->scenePos(), scenePos).length()
-            <= m_handleRadius * 2.0 )
-            return i;
-    }
-    return -1;
+    if ( !m_handlesVisible )
+        return -1;
+    return m_index.nearestVertex(m_poly->polygon(), scenePos, m_handleRadius * 2.0);
 }
 
+// nearest edge within 3 pixel (at least the handle radius)
 int EditablePolygonItem::hitTestEdge( const QPointF& scenePos ) const
 {
-    const QPolygonF& poly = m_poly->polygon();
-    for ( int i = 0; i < poly.size(); ++i ) {
-        QPointF a = poly[i];
-        QPointF b = poly[(i + 1) % poly.size()];
-        QLineF l(a, b);
-        if ( l.length() < 1e-3 )
-            continue;
-        qreal d = QLineF(a, scenePos).length()
-                + QLineF(scenePos, b).length()
-                - l.length();
-        if ( qAbs(d) < 3.0 )
-            return i;
-    }
-    return -1;
+    return m_index.nearestEdge(m_poly->polygon(), scenePos, qMax(3.0, m_handleRadius));
 }
 
 int EditablePolygonItem::hitTestPolygon( const QPointF& scenePos ) const
@@ -289,19 +292,117 @@ int EditablePolygonItem::hitTestPolygon( const QPointF& scenePos ) const
 
 void EditablePolygonItem::updateGeometry()
 {
+    m_fillTolerance = -1.0;
+    if ( m_indexCurrent && m_dirtyRect.isValid() ) {
+      // a moved point inside the old bounds, only its two edges are repainted
+      m_indexCurrent = false;
+      update(m_dirtyRect);
+      m_dirtyRect = QRectF();
+      return;
+    }
     prepareGeometryChange();
-    rebuildHandles();
+    if ( !m_indexCurrent ) {
+      rebuildIndex();
+    }
+    m_indexCurrent = false;
+    m_dirtyRect = QRectF();
     update();
 }
 
+QRectF EditablePolygonItem::pointDirtyRect( int idx, const QPointF& oldPos ) const
+{
+    const QPolygonF& poly = m_poly->polygon();
+    const int n = poly.size();
+    const QPointF& prev = poly[(idx + n - 1) % n];
+    const QPointF& next = poly[(idx + 1) % n];
+    qreal x0 = qMin(qMin(prev.x(), next.x()), qMin(oldPos.x(), poly[idx].x()));
+    qreal x1 = qMax(qMax(prev.x(), next.x()), qMax(oldPos.x(), poly[idx].x()));
+    qreal y0 = qMin(qMin(prev.y(), next.y()), qMin(oldPos.y(), poly[idx].y()));
+    qreal y1 = qMax(qMax(prev.y(), next.y()), qMax(oldPos.y(), poly[idx].y()));
+    const qreal margin = 2.0 * m_handleRadius + 2.0;
+    return QRectF(QPointF(x0, y0), QPointF(x1, y1)).adjusted(-margin, -margin, margin, margin);
+}
+
+void EditablePolygonItem::onPointMoved( int idx, const QPointF& oldPos )
+{
+    const QRectF bounds = m_index.bounds();
+    m_index.pointMoved(m_poly->polygon(), idx, oldPos);
+    m_indexCurrent = true;
+    // bounds only grow incrementally, unchanged bounds mean an unchanged geometry
+    m_dirtyRect = ( m_index.bounds() == bounds && idx >= 0 && idx < m_poly->pointCount() ) ? pointDirtyRect(idx, oldPos) : QRectF();
+}
+
+void EditablePolygonItem::onPointInserted( int idx )
+{
+    m_index.pointInserted(m_poly->polygon(), idx);
+    m_indexCurrent = true;
+    m_dirtyRect = QRectF();
+}
+
+void EditablePolygonItem::onPointRemoved( int idx, const QPointF& oldPos )
+{
+    m_index.pointRemoved(m_poly->polygon(), idx, oldPos);
+    m_indexCurrent = true;
+    m_dirtyRect = QRectF();
+}
+
+const QPolygonF& EditablePolygonItem::fillPolygon( qreal lod )
+{
+    // power of two steps, zooming does not thin the polygon on every frame
+    const qreal tolerance = lod > 0.0 ? qPow(2.0, qFloor(std::log2(0.5 / lod))) : 0.0;
+    if ( tolerance == m_fillTolerance )
+      return m_fillPolygon;
+    const QPolygonF& poly = m_poly->polygon();
+    m_fillTolerance = tolerance;
+    m_fillPolygon.clear();
+    m_fillPolygon.reserve(poly.size());
+    const qreal tol2 = tolerance * tolerance;
+    for ( const QPointF& pt : poly ) {
+      if ( !m_fillPolygon.isEmpty() ) {
+        const QPointF d = pt - m_fillPolygon.last();
+        if ( QPointF::dotProduct(d, d) < tol2 )
+          continue;
+      }
+      m_fillPolygon.append(pt);
+    }
+    return m_fillPolygon;
+}
+
+QPainterPath EditablePolygonItem::outlinePath( const QRectF& area, qreal lod ) const
+{
+    const QPolygonF& poly = m_poly->polygon();
+    const int n = poly.size();
+    const QVector<int> edges = m_index.edgesIn(poly, area);
+    // consecutive edges form one subpath, inner vertices closer than half a
+    // screen pixel to the last emitted one are skipped
+    const qreal tol2 = lod > 0.0 ? 0.25 / (lod * lod) : 0.0;
+    QPainterPath path;
+    QPointF last;
+    for ( int k = 0; k < edges.size(); ++k ) {
+      const int e = edges[k];
+      if ( k == 0 || edges[k - 1] != e - 1 ) {
+        last = poly[e];
+        path.moveTo(last);
+      }
+      const QPointF& b = poly[(e + 1) % n];
+      const bool runEnd = k + 1 == edges.size() || edges[k + 1] != e + 1;
+      const QPointF d = b - last;
+      if ( runEnd || QPointF::dotProduct(d, d) >= tol2 ) {
+        path.lineTo(b);
+        last = b;
+      }
+    }
+    return path;
+}
+
 void EditablePolygonItem::visibilityChangedTo( bool isVisible )
 {
   qCDebug(logEditor) << "EditablePolygonItem::visibilityChangedTo(): isVisible =" << isVisible;
   {
     m_poly->setVisible(isVisible);
     setVisible(isVisible);
-    for ( auto* p : m_handles )
-      p->setVisible(isVisible);
+    m_handlesVisible = isVisible;
+    update();
   }
 }
 
@@ -312,8 +413,8 @@ void EditablePolygonItem::onVisibilityChanged()
     // Polygon
     setVisible(m_poly->polygonVisible());
     // Marker (Control Points)
-    for ( auto* p : m_handles )
-      p->setVisible(m_poly->markersVisible());
+    m_handlesVisible = m_poly->markersVisible();
+    update();
   }
 }
 
@@ -322,30 +423,16 @@ void EditablePolygonItem::onSelectionChanged()
   qCDebug(logEditor) << "EditablePolygonItem::onSelectionChanged(): Processing...";
   { 
     // Marker (Control Points)
-    for ( auto* p : m_handles )
-        p->setVisible(m_poly->isSelected());
+    m_handlesVisible = m_poly->isSelected();
+    update();
   }
 }
 
-void EditablePolygonItem::rebuildHandles()
+void EditablePolygonItem::rebuildIndex()
 {
-  qCDebug(logEditor) << "EditablePolygonItem::rebuildHandles(): Processing...";
+  qCDebug(logEditor) << "EditablePolygonItem::rebuildIndex(): Processing...";
   {
-    qDeleteAll(m_handles);
-    m_handles.clear();
-    const QPolygonF& poly = m_poly->polygon();
-    for ( const QPointF& p : poly ) {
-        auto* h = new QGraphicsEllipseItem(
-            -m_handleRadius,
-            -m_handleRadius,
-            2 * m_handleRadius,
-            2 * m_handleRadius,
-            this);
-        h->setBrush(m_handleColor);
-        h->setPen(Qt::NoPen);
-        h->setPos(p);
-        h->setZValue(1001);
-        m_handles.push_back(h);
-    }
+    // the polygon lives in scene coordinates, so does the index
+    m_index.rebuild(m_poly->polygon());
   }
 }
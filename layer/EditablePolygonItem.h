@@ -18,6 +18,7 @@
 #pragma once
 
 #include <QGraphicsObject>
+#include <QPainterPath>
 #include <QPolygonF>
 #include <QVector>
 #include <QJsonObject>
@@ -25,6 +26,7 @@
 
 #include "EditablePolygon.h"
 #include "LayerItem.h"
+#include "PolygonIndex.h"
 
 class EditablePolygonItem : public QGraphicsObject
 {
@@ -76,6 +78,9 @@ class EditablePolygonItem : public QGraphicsObject
   private slots:
   
     void updateGeometry();
+    void onPointMoved( int idx, const QPointF& oldPos );
+    void onPointInserted( int idx );
+    void onPointRemoved( int idx, const QPointF& oldPos );
     void onVisibilityChanged();
     void onSelectionChanged();
 
@@ -84,7 +89,10 @@ class EditablePolygonItem : public QGraphicsObject
     // --- Hilfsfunktionen ---
     int hitTestPoint( const QPointF& scenePos ) const;
     int hitTestEdge( const QPointF& scenePos ) const;
-    void rebuildHandles();
+    void rebuildIndex();
+    const QPolygonF& fillPolygon( qreal lod );
+    QPainterPath outlinePath( const QRectF& area, qreal lod ) const;
+    QRectF pointDirtyRect( int idx, const QPointF& oldPos ) const;
 
   private:
 
@@ -96,8 +104,17 @@ class EditablePolygonItem : public QGraphicsObject
     QPointF m_dragStartPos;
     QPointF m_dragMousePressPos;
 
-    // Darstellung
-    QVector<QGraphicsEllipseItem*> m_handles;
+    // vertex/edge grid for hit tests and culling, kept in sync by the point signals
+    PolygonIndex m_index;
+    bool    m_indexCurrent = false;   // set by a point signal, updateGeometry() then skips the rebuild
+    QRectF  m_dirtyRect;              // repaint area of a single point edit
+
+    // fill outline thinned to half a screen pixel, m_fillTolerance < 0: stale
+    QPolygonF m_fillPolygon;
+    qreal   m_fillTolerance = -1.0;
+
+    // Darstellung (all handles are painted by this item in one call)
+    bool    m_handlesVisible = true;
     qreal   m_handleRadius = 4.0;
 
     // Styling
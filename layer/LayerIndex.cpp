@@ -0,0 +1,172 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "LayerIndex.h"
+#include "LayerItem.h"
+
+#include <QGraphicsScene>
+
+#include <algorithm>
+#include <cmath>
+
+std::atomic<quint64> LayerIndex::s_generation{1};
+QVector<LayerIndex*> LayerIndex::s_indexes;
+
+// ------------------------------  ------------------------------
+LayerIndex::LayerIndex()
+{
+  s_indexes.append(this);
+}
+
+LayerIndex::~LayerIndex()
+{
+  s_indexes.removeOne(this);
+}
+
+void LayerIndex::geometryChanged( LayerItem* layer )
+{
+  for ( LayerIndex* index : s_indexes ) {
+    index->m_moved.insert(layer);
+  }
+}
+
+// ------------------------------  ------------------------------
+void LayerIndex::sync()
+{
+  const quint64 generation = s_generation.load();
+  if ( generation == m_generation ) {
+    // a dragged layer only moves its own cells
+    for ( LayerItem* layer : std::as_const(m_moved) ) {
+      if ( !updateEntry(layer) ) {
+        m_generation = 0;
+        break;
+      }
+    }
+    m_moved.clear();
+    if ( m_generation != 0 )
+      return;
+  }
+  m_generation = generation;
+  m_moved.clear();
+  m_entries.clear();
+  m_cells.clear();
+  if ( !m_scene )
+    return;
+  // items() in descending order is the exact stacking order of the scene
+  for ( QGraphicsItem* item : m_scene->items(Qt::DescendingOrder) ) {
+    LayerItem* layer = dynamic_cast<LayerItem*>(item);
+    if ( !layer || layer->isDeleted() || !layer->isVisible() || !layer->isRendered() )
+      continue;
+    const QRectF bounds = layer->sceneBoundingRect();
+    if ( bounds.isEmpty() )
+      continue;
+    m_entries.append({layer, bounds});
+    addCells(m_entries.size() - 1);
+  }
+}
+
+// new scene bounds of a listed layer, false if the layer is not listed
+// (its place in the stacking order is unknown, the grid is rebuilt)
+bool LayerIndex::updateEntry( LayerItem* layer )
+{
+  for ( int index = 0; index < m_entries.size(); ++index ) {
+    Entry& entry = m_entries[index];
+    if ( entry.layer != layer )
+      continue;
+    removeCells(index);
+    const bool listed = !layer->isDeleted() && layer->isVisible() && layer->isRendered();
+    entry.bounds = listed ? layer->sceneBoundingRect() : QRectF();
+    addCells(index);
+    return true;
+  }
+  return m_scene == nullptr || layer->scene() != m_scene || layer->isDeleted() || 
+         !layer->isVisible() || !layer->isRendered();
+}
+
+void LayerIndex::addCells( int index )
+{
+  const QRectF& bounds = m_entries[index].bounds;
+  if ( bounds.isEmpty() )
+    return;
+  const int cx0 = int(std::floor(bounds.left() / CellSize));
+  const int cy0 = int(std::floor(bounds.top() / CellSize));
+  const int cx1 = int(std::floor(bounds.right() / CellSize));
+  const int cy1 = int(std::floor(bounds.bottom() / CellSize));
+  for ( int cy = cy0; cy <= cy1; ++cy ) {
+    for ( int cx = cx0; cx <= cx1; ++cx ) {
+      QVector<int>& cell = m_cells[cellKey(cx, cy)];
+      cell.insert(std::lower_bound(cell.begin(), cell.end(), index), index);
+    }
+  }
+}
+
+void LayerIndex::removeCells( int index )
+{
+  const QRectF& bounds = m_entries[index].bounds;
+  if ( bounds.isEmpty() )
+    return;
+  const int cx0 = int(std::floor(bounds.left() / CellSize));
+  const int cy0 = int(std::floor(bounds.top() / CellSize));
+  const int cx1 = int(std::floor(bounds.right() / CellSize));
+  const int cy1 = int(std::floor(bounds.bottom() / CellSize));
+  for ( int cy = cy0; cy <= cy1; ++cy ) {
+    for ( int cx = cx0; cx <= cx1; ++cx ) {
+      auto cell = m_cells.find(cellKey(cx, cy));
+      if ( cell == m_cells.end() )
+        continue;
+      cell->removeOne(index);
+      if ( cell->isEmpty() )
+        m_cells.erase(cell);
+    }
+  }
+}
+
+template<typename Accept>
+LayerItem* LayerIndex::find( const QPointF& scenePos, QPoint* localPos, Accept accept )
+{
+  sync();
+  const auto cell = m_cells.constFind(cellKey(int(std::floor(scenePos.x() / CellSize)), int(std::floor(scenePos.y() / CellSize))));
+  if ( cell == m_cells.constEnd() )
+    return nullptr;
+  for ( int index : cell.value() ) {
+    const Entry& entry = m_entries[index];
+    if ( !entry.bounds.contains(scenePos) )
+      continue;
+    const QPoint pos = entry.layer->mapFromScene(scenePos).toPoint();
+    if ( !entry.layer->image().rect().contains(pos) || !accept(entry.layer, pos) )
+      continue;
+    if ( localPos != nullptr ) *localPos = pos;
+    return entry.layer;
+  }
+  return nullptr;
+}
+
+LayerItem* LayerIndex::layerAt( const QPointF& scenePos, QPoint* localPos )
+{
+  return find(scenePos, localPos, []( LayerItem*, const QPoint& ){ return true; });
+}
+
+LayerItem* LayerIndex::opaqueLayerAt( const QPointF& scenePos, QColor* color, QPoint* localPos )
+{
+  QRgb pixel = 0;
+  LayerItem* layer = find(scenePos, localPos, [&pixel]( LayerItem* l, const QPoint& pos ){
+    pixel = l->image().pixel(pos);
+    return qAlpha(pixel) != 0;
+  });
+  if ( color != nullptr ) *color = layer ? QColor::fromRgba(pixel) : QColor(Qt::transparent);
+  return layer;
+}
@@ -0,0 +1,93 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+#include <QColor>
+#include <QHash>
+#include <QPoint>
+#include <QPointF>
+#include <QRectF>
+#include <QSet>
+#include <QVector>
+
+#include <atomic>
+
+class QGraphicsScene;
+class LayerItem;
+
+/*
+ * LayerIndex
+ * ----------
+ * Uniform grid over the scene bounds of all LayerItems, used for hit tests
+ * on mouse motion instead of QGraphicsScene::items() (which also walks
+ * overlays, handles and polygon items).
+ * - entries are kept in stacking order, topmost first
+ * - moves, transforms and new image sizes of a layer only update the cells
+ *   of that layer (old and new scene bounds) on the next query
+ * - visibility, stacking order and scene changes bump a global generation,
+ *   the grid is then rebuilt lazily from the scene on the next query
+ */
+
+class LayerIndex
+{
+
+  public:
+
+    static constexpr int CellSize = 512;
+
+    LayerIndex();
+    ~LayerIndex();
+    LayerIndex( const LayerIndex& ) = delete;
+    LayerIndex& operator=( const LayerIndex& ) = delete;
+
+    static void invalidate() { s_generation++; }
+    // scene bounds of layer changed, GUI thread only
+    static void geometryChanged( LayerItem* layer );
+
+    void setScene( QGraphicsScene* scene ) { m_scene = scene; m_generation = 0; }
+
+    // topmost visible layer whose image contains scenePos
+    LayerItem* layerAt( const QPointF& scenePos, QPoint* localPos = nullptr );
+    // topmost visible layer with a non transparent pixel at scenePos
+    LayerItem* opaqueLayerAt( const QPointF& scenePos, QColor* color = nullptr, QPoint* localPos = nullptr );
+
+  private:
+
+    struct Entry {
+      LayerItem* layer = nullptr;
+      QRectF bounds;      // scene coordinates
+    };
+
+    void sync();
+    bool updateEntry( LayerItem* layer );
+    void addCells( int index );
+    void removeCells( int index );
+    template<typename Accept>
+    LayerItem* find( const QPointF& scenePos, QPoint* localPos, Accept accept );
+    static quint64 cellKey( int cx, int cy ) { return (quint64(quint32(cx)) << 32) | quint32(cy); }
+
+    static std::atomic<quint64> s_generation;
+    static QVector<LayerIndex*> s_indexes;
+
+    QGraphicsScene* m_scene = nullptr;
+    quint64 m_generation = 0;
+    QVector<Entry> m_entries;
+    QHash<quint64, QVector<int>> m_cells;   // ascending entry indices per cell
+    QSet<LayerItem*> m_moved;               // layers to update before the next query
+
+};
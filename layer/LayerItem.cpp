@@ -18,9 +18,10 @@
 #include "LayerItem.h"
 #include "Layer.h"
 #include "TransformHandleItem.h"
-#include "CageControlPointItem.h"
 #include "CageOverlayItem.h"
 #include "CageMesh.h"
+#include "LayerIndex.h"
+#include "CageWarpPipeline.h"
 
 #include "../core/IMainSystem.h"
 #include "../gui/MainWindow.h"
@@ -30,6 +31,7 @@
 #include "../undo/MoveLayerCommand.h"
 #include "../undo/CageWarpCommand.h"
 #include "../util/Interpolation.h"
+#include "../util/BrushEngine.h"
 #include "../util/GeometryUtils.h"
 #include "../util/TriangleWarp.h"
 #include "../util/CageWarp.h"
@@ -39,15 +41,16 @@
 #include <QFile>
 #include <QCryptographicHash>
 #include <QByteArray>
-#include <QGraphicsColorizeEffect>
 #include <QGraphicsSceneMouseEvent>
 #include <QGraphicsScene>
 #include <QPainter>
+#include <QStyleOptionGraphicsItem>
 #include <QBuffer>
+#include <cstring>
 #include <iostream>
 
 // ------------------------ LayerItem ------------------------
-LayerItem::LayerItem( const QString& name, const QPixmap& pixmap, QGraphicsItem* parent ) : QGraphicsPixmapItem(pixmap,parent)
+LayerItem::LayerItem( const QString& name, const QPixmap& pixmap, QGraphicsItem* parent ) : QGraphicsPixmapItem(parent)
 { 
   qCDebug(logEditor) << "LayerItem::LayerItem(): Pixmap processing of layer " << name << "...";
   {
@@ -70,12 +73,23 @@ LayerItem::LayerItem( const QString& name, const QImage& image, QGraphicsItem* p
    m_originalImageType = ImageType::Original; 
    m_nogui = (qobject_cast<QApplication*>(qApp) == nullptr);
    if ( !m_nogui ) {
-     setPixmap(QPixmap::fromImage(m_image));
      init();
    }
   }
 }
 
+int LayerItem::s_soloLayers = 0;
+quint64 LayerItem::s_contentGenerations = 0;
+
+LayerItem::~LayerItem()
+{
+  if ( m_renderState.solo ) {
+    s_soloLayers -= 1;
+  }
+  delete m_warpPipeline;
+  LayerIndex::invalidate();
+}
+
 // >>>
 QString LayerItem::operationModeName( int mode )
 {
@@ -107,17 +121,15 @@ void LayerItem::applyPerspective()
 {
    QImage warped = m_perspective.apply(m_originalImage);
    // OLD: setPixmap(QPixmap::fromImage(warped));
+   prepareGeometryChange();
    m_image = warped;
-   if ( !m_nogui && qobject_cast<QApplication*>(qApp) ) {
-     setPixmap(QPixmap::fromImage(warped));
-   }
+   updatePixmap();
 }
 
-// returns unified rect of the pixmap AND the m_cageMesh
+// returns unified rect of the displayed image AND the m_cageMesh
 QRectF LayerItem::boundingRect() const
 {
-   QSize s = pixmap().isNull() ? m_image.size() : pixmap().size();
-   QRectF pixmapRect(offset(),s);
+   QRectF pixmapRect(offset(),displayImage().size());
    if ( m_cageMesh.isActive() ) {
       QRectF cageRect = QPolygonF(m_cageMesh.points()).boundingRect();
       QRectF united = pixmapRect.united(cageRect);
@@ -127,6 +139,35 @@ QRectF LayerItem::boundingRect() const
    return pixmapRect;
 }
 
+// the item holds no pixmap, the default shape of QGraphicsPixmapItem would be empty
+QPainterPath LayerItem::shape() const
+{
+   QPainterPath path;
+   path.addRect(QRectF(offset(),displayImage().size()));
+   return path;
+}
+
+QVariant LayerItem::itemChange( GraphicsItemChange change, const QVariant& value )
+{
+  switch ( change ) {
+    case ItemPositionHasChanged:
+    case ItemTransformHasChanged:
+    case ItemRotationHasChanged:
+    case ItemScaleHasChanged:
+      LayerIndex::geometryChanged(this);
+      break;
+    case ItemVisibleHasChanged:
+    case ItemZValueHasChanged:
+    case ItemSceneHasChanged:
+    case ItemParentHasChanged:
+      LayerIndex::invalidate();
+      break;
+    default:
+      break;
+  }
+  return QGraphicsPixmapItem::itemChange(change, value);
+}
+
 // per default moveable layer item
 // NOTE: QGraphicsItem::ItemIsSelectable expands the size of the QGraphicsPixmapItem by +1+1 !   
 void LayerItem::init() 
@@ -134,7 +175,8 @@ void LayerItem::init()
   setFlags(QGraphicsItem::ItemIsSelectable |
              QGraphicsItem::ItemIsMovable |
              QGraphicsItem::ItemSendsGeometryChanges |
-             QGraphicsItem::ItemIsFocusable);
+             QGraphicsItem::ItemIsFocusable |
+             QGraphicsItem::ItemUsesExtendedStyleOption); // exact exposedRect for tiled painting
   setTransformationMode(EditorStyle::instance().transformationMode()); // for on screen visualization
   setAcceptedMouseButtons(Qt::LeftButton);
   setShapeMode(QGraphicsPixmapItem::BoundingRectShape);
@@ -170,6 +212,7 @@ void LayerItem::printself( bool debugSave )
   qInfo() << "  + cage overlay =" << (m_cageOverlay != nullptr ? "ok" : "null");
   qInfo() << "  + operation mode =" << m_operationMode;
   qInfo() << "  + bounding box =" << m_showBoundingBox;
+  qInfo() << "  + tile pyramid =" << m_tilePyramid.byteCount() / 1024 << "kB";
   qInfo() << "  + parent ="  << ( m_parent != nullptr ? "null" : "ok" );
 }
 
@@ -240,10 +283,15 @@ void LayerItem::setType( LayerType layerType ) {
     }
 }
 
-void LayerItem::setFileInfo( const QString &filePath )
+void LayerItem::setFileInfo( const QString &filePath, const QString &checksum )
 {
   // set filename
   m_filename = filePath;
+  // checksum already computed while loading
+  if ( !checksum.isEmpty() ) {
+   m_checksum = checksum;
+   return;
+  }
   // compute checksum
   QFile file(filePath);
   if ( file.open(QIODevice::ReadOnly) ) {
@@ -284,30 +332,96 @@ QString LayerItem::name() const {
   return m_name;
 }
 
-// ------------------------ Update ------------------------
-void LayerItem::updatePixmap() {
-  if ( qobject_cast<QApplication*>(qApp) ) {
-    setPixmap(QPixmap::fromImage(m_image));
-  }
+// ------------------------ History state ------------------------
+LayerItem::HistoryState LayerItem::historyState() const
+{
+  HistoryState state;
+  state.image = m_image;
+  state.originalImage = m_originalImage;
+  state.originalImageType = m_originalImageType;
+  state.pos = pos();
+  state.transform = transform();
+  state.totalTransform = m_totalTransform;
+  state.rotation = m_currentRotation;
+  state.cagePoints = m_cageMesh.points();
+  state.cageApplied = m_cageApplied;
+  return state;
 }
 
-void LayerItem::resetPixmap() {
-  if ( qobject_cast<QApplication*>(qApp) ) {
-    setPixmap(QPixmap::fromImage(m_originalImage));
+void LayerItem::restoreHistoryState( const HistoryState& state )
+{
+  qCDebug(logEditor) << "LayerItem::restoreHistoryState(): name =" << name() << ", position =" << state.pos;
+  {
+    prepareGeometryChange();
+    m_image = state.image;
+    m_originalImage = state.originalImage;
+    m_originalImageType = state.originalImageType;
+    m_cageApplied = state.cageApplied;
+    m_totalTransform = state.totalTransform;
+    m_currentRotation = state.rotation;
+    if ( state.cagePoints.size() == m_cageMesh.pointCount() ) {
+      m_cageMesh.setPoints(state.cagePoints);
+    }
+    setTransform(state.transform);
+    setPos(state.pos);
+    updatePixmap();
   }
 }
 
+// ------------------------ Render state ------------------------
+void LayerItem::setRenderOpacity( qreal opacity ) {
+  opacity = qBound(0.0, opacity, 1.0);
+  if ( qFuzzyCompare(opacity, m_renderState.opacity) ) return;
+  m_renderState.opacity = opacity;
+  if ( m_layer ) m_layer->m_opacity = float(opacity);
+  update();
+}
+
+void LayerItem::setRenderVisible( bool visible ) {
+  m_renderState.visible = visible;
+  if ( m_layer ) m_layer->m_visible = visible;
+  // item visibility also removes the layer from hit testing
+  setVisible(visible);
+}
+
+void LayerItem::setHighlighted( bool highlighted ) {
+  if ( m_renderState.highlighted == highlighted ) return;
+  m_renderState.highlighted = highlighted;
+  update();
+}
+
+void LayerItem::setSolo( bool solo ) {
+  if ( m_renderState.solo == solo ) return;
+  m_renderState.solo = solo;
+  s_soloLayers += solo ? 1 : -1;
+  LayerIndex::invalidate();
+  // every layer changes its appearance
+  if ( scene() ) scene()->update();
+}
+
+bool LayerItem::isRendered() const {
+  if ( !m_renderState.visible || m_isDeleted ) return false;
+  // the main image stays as backdrop of a solo layer
+  return s_soloLayers == 0 || m_renderState.solo || m_index == 0;
+}
+
+// ------------------------ Update ------------------------
+// there is no pixmap copy of the image anymore, paint() draws displayImage()
+// through the tile pyramid, only bounds, LayerIndex and generation follow
+void LayerItem::updatePixmap() {
+  prepareGeometryChange();
+  m_contentGeneration = ++s_contentGenerations;
+  LayerIndex::geometryChanged(this);
+  update();
+}
+
 void LayerItem::updateImageRegion( const QRect& rect ) {
   if ( rect.isEmpty() )
     return;
-  QPixmap pm = pixmap();
-  if ( pm.isNull() )
-    return;
-  QPainter painter(&pm);
-   painter.setCompositionMode(QPainter::CompositionMode_Source);
-   painter.drawImage(rect.topLeft(),m_image,rect);
-  painter.end();
-  setPixmap(pm);
+  // the item draws m_image through the tile pyramid, only the tiles covering
+  // rect are rebuilt on the next paint (same size, the LayerIndex stays valid)
+  m_contentGeneration = ++s_contentGenerations;
+  m_tilePyramid.invalidate(rect,m_image);
   update(rect);
 }
 
@@ -417,7 +531,7 @@ void LayerItem::resetImageState( const QImage& image, const QPointF& position, c
 	  }
 	}
 
-void LayerItem::setImageTransform( const QTransform& transform, bool combine ) {
+void LayerItem::setImageTransform( const QTransform& transform, bool combine, const QImage& transformed ) {
   qDebug() << "LayerItem::setImageTransform(): nonGUI =" << m_nogui << ", position =" << pos() << ", combine =" 
                         << combine << ", originalImageType =" << m_originalImageType;
   {
@@ -430,7 +544,7 @@ void LayerItem::setImageTransform( const QTransform& transform, bool combine ) {
       QPointF imageCenter = QRectF(m_originalImage.rect()).center();
       QPointF sceneCenter = mapToScene(imageCenter);
       QPointF newImageCenter(m_image.width() / 2.0, m_image.height() / 2.0);
-      setPixmap(QPixmap::fromImage(m_image));
+      updatePixmap();
       setPos(sceneCenter - newImageCenter);
       // QGraphicsPixmapItem::setTransform(transform,combine);
       return;
@@ -445,47 +559,77 @@ void LayerItem::setImageTransform( const QTransform& transform, bool combine ) {
     }
     // transform image
     prepareGeometryChange();
-    QPointF sceneCenter = qobject_cast<QApplication*>(qApp) ? mapToScene(QRectF(pixmap().rect()).center()) : mapToScene(QRectF(m_originalImage.rect()).center());
-    QPointF imageCenter = QRectF(m_originalImage.rect()).center();
-    if ( combine ) {
-      m_totalTransform.translate(imageCenter.x(), imageCenter.y());
-      m_totalTransform *= transform;
-      m_totalTransform.translate(-imageCenter.x(), -imageCenter.y());
-    } else {
-      m_totalTransform = QTransform();
-      m_totalTransform.translate(imageCenter.x(), imageCenter.y());
-      m_totalTransform *= transform;
-      m_totalTransform.translate(-imageCenter.x(), -imageCenter.y());
-    }
+    QPointF sceneCenter = qobject_cast<QApplication*>(qApp) ? mapToScene(QRectF(m_image.rect()).center()) : mapToScene(QRectF(m_originalImage.rect()).center());
+    m_totalTransform = combinedTransform(m_originalImage, transform, combine);
+    // an image prepared by transformedImage() saves the interpolation
+    m_image = transformed.isNull() ? interpolatedImage(m_originalImage, m_totalTransform) : transformed;
+    QPointF newImageCenter(m_image.width() / 2.0, m_image.height() / 2.0);
+    setPos(sceneCenter - newImageCenter);
+    // reset transform
+    setTransform(QTransform());
+    // >>>
+    updatePixmap();
+  }
+}
+
+// The image setImageTransform( transform, combine ) computes, the layer is only
+// read, so this may run on a worker thread as long as the layer is not modified.
+QImage LayerItem::transformedImage( const QTransform& transform, bool combine ) const
+{
+  qCDebug(logEditor) << "LayerItem::transformedImage(): combine =" << combine;
+  {
+    const QImage& source = ( m_cageApplied && m_originalImageType == ImageType::Original ) ? m_image : m_originalImage;
+    return interpolatedImage(source, combinedTransform(source, transform, combine));
+  }
+}
+
+QTransform LayerItem::combinedTransform( const QImage& source, const QTransform& transform, bool combine ) const
+{
+    QTransform total = combine ? m_totalTransform : QTransform();
+    QPointF imageCenter = QRectF(source.rect()).center();
+    total.translate(imageCenter.x(), imageCenter.y());
+    total *= transform;
+    total.translate(-imageCenter.x(), -imageCenter.y());
+    return total;
+}
+
+QImage LayerItem::interpolatedImage( const QImage& source, const QTransform& total ) const
+{
     // the interpolation step (Qt only supports nearest neighbor und linear interpolation)
     if ( !m_nogui && EditorStyle::instance().interpolationMode() == EditorStyle::InterpolationMode::System ) {
       // !!! only in gui mode !!!
-      m_image = Interpolation::transformWithHighQuality(m_originalImage, m_totalTransform);
+      return Interpolation::transformWithHighQuality(source, total);
     } else if ( EditorStyle::instance().interpolationMode() == EditorStyle::InterpolationMode::Bicubic ) {
       // this use external bicubic interpolation
-      m_image = Interpolation::transformBicubic(m_originalImage, m_totalTransform);
+      return Interpolation::transformBicubic(source, total);
     } else if ( EditorStyle::instance().interpolationMode() == EditorStyle::InterpolationMode::Nearest ) {
       // this use internal nearest transformation
-      m_image = m_originalImage.transformed(m_totalTransform,Qt::FastTransformation);
-    } else { 
-      // this use internal linear transformation
-      m_image = m_originalImage.transformed(m_totalTransform,Qt::SmoothTransformation);
+      return source.transformed(total,Qt::FastTransformation);
     }
-    // end
-    QPointF newImageCenter(m_image.width() / 2.0, m_image.height() / 2.0);
-    setPos(sceneCenter - newImageCenter);
-    // reset transform
-    setTransform(QTransform());
-    // >>>
-    updatePixmap();
-  }
+    // this use internal linear transformation
+    return source.transformed(total,Qt::SmoothTransformation);
 }
 
 // ------------------------ Paint ------------------------
 void LayerItem::paint( QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget )
 {
   {
-    QGraphicsPixmapItem::paint(painter,option,widget);
+    if ( !isRendered() ) {
+      return;
+    }
+    // only the exposed tiles of the mip level matching the view scale
+    const qreal itemOpacity = painter->opacity();
+    painter->setOpacity(itemOpacity * m_renderState.opacity);
+    m_tilePyramid.draw(painter, displayImage(), offset(), option->exposedRect, 
+                         transformationMode() == Qt::SmoothTransformation);
+    painter->setOpacity(itemOpacity);
+    if ( m_renderState.highlighted ) {
+      QColor tint = m_selectedPen.color();
+      painter->setPen(QPen(tint, 0));
+      tint.setAlpha(64);
+      painter->setBrush(tint);
+      painter->drawRect(boundingRect());
+    }
     if ( m_operationMode == OperationMode::Perspective ) {
       return;
     }
@@ -507,37 +651,71 @@ void LayerItem::paint( QPainter* painter, const QStyleOptionGraphicsItem* option
   }
 }
 
-void LayerItem::paintStrokeSegment( const QPoint& p0, const QPoint& p1, const QColor &color, int radius, float hardness )
+// The image before the stroke is kept in m_originalImage, every segment adds
+// to the stroke coverage and its area is composited again from that image.
+// Each pixel thus carries the coverage of the whole stroke blended once,
+// exactly what PaintStrokeCommand::paint() gives for the same points.
+void LayerItem::beginStroke()
+{
+  qCDebug(logEditor) << "LayerItem::beginStroke(): Processing...";
+  {
+    updateOriginalImage();
+    m_strokeCoverage = std::make_unique<BrushEngine::Coverage>(QRect());
+    m_strokeSegments = 0;
+  }
+}
+
+void LayerItem::paintStrokeSegment( const QPoint& p0, const QPoint& p1, const QColor &color, int radius, float hardness, int brushMode )
 {
   qCDebug(logEditor) << "LayerItem::paintStrokeSegment(): Processing...";
   if ( radius < 0.0 ) return;
   {
-    const float spacing = std::max(1.0f, radius * 0.35f);
-    const float dx = p1.x() - p0.x();
-    const float dy = p1.y() - p0.y();
-    const float dist = std::sqrt(dx*dx + dy*dy);
-    if ( dist <= 0.0f ) {
-     Interpolation::dab(m_image, p0, color, radius, hardness);
-     return;
+    if ( !m_strokeCoverage ) {
+      beginStroke();
     }
-    const int steps = std::ceil(dist / spacing);
-    for ( int i = 0; i <= steps; ++i ) {
-        float t = float(i) / float(steps);
-        QPoint p(
-            int(p0.x() + t * dx),
-            int(p0.y() + t * dy)
-        );
-        Interpolation::dab(m_image, p, color, radius, hardness);
+    const QRect segment = BrushEngine::segmentBounds(m_image, p0, p1, radius);
+    if ( segment.isEmpty() )
+      return;
+    // some slack, so a growing stroke does not reallocate for every segment
+    if ( !m_strokeCoverage->rect().contains(segment) ) {
+      m_strokeCoverage->grow(segment.adjusted(-256, -256, 256, 256) & m_image.rect());
     }
+    // the dab shown on press is replaced by the first segment, which starts
+    // there as well; the command paints a lone dab only for a single click
+    if ( p0 != p1 && m_strokeSegments++ == 0 ) {
+      m_strokeCoverage->clear();
+    }
+    m_strokeCoverage->addSegment(brushMode, p0, p1, radius, hardness, color.alpha());
     // ---
-    QRect dirtyRect = QRect(p0, QSize(1,1));
-    dirtyRect |= QRect(p1, QSize(1,1));
-    int pad = radius + 2;
-    dirtyRect.adjust(-pad, -pad, pad, pad);
-    dirtyRect &= m_image.rect();
-    updateImageRegion(dirtyRect);
-    // ---
-    // setPixmap(QPixmap::fromImage(m_image));
+    if ( m_originalImage.size() == m_image.size() && m_originalImage.format() == m_image.format() && m_image.depth() >= 8 ) {
+      const int bytes = segment.width() * m_image.depth() / 8;
+      const int offset = segment.left() * m_image.depth() / 8;
+      for ( int y = segment.top(); y <= segment.bottom(); ++y ) {
+        std::memcpy(m_image.scanLine(y) + offset, m_originalImage.constScanLine(y) + offset, bytes);
+      }
+    }
+    m_strokeCoverage->composite(m_image, color, segment);
+    updateImageRegion(segment);
+  }
+}
+
+// Reverts the painted area to the image before the stroke, the
+// PaintStrokeCommand pushed next paints it again from the same points
+void LayerItem::endStroke()
+{
+  qCDebug(logEditor) << "LayerItem::endStroke(): Processing...";
+  {
+    if ( !m_strokeCoverage )
+      return;
+    const QRect area = m_strokeCoverage->rect() & m_image.rect();
+    m_strokeCoverage.reset();
+    if ( area.isEmpty() || m_originalImage.size() != m_image.size() || m_originalImage.format() != m_image.format() )
+      return;
+    QPainter painter(&m_image);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage(area.topLeft(), m_originalImage, area);
+    painter.end();
+    updateImageRegion(area);
   }
 }
 
@@ -555,6 +733,8 @@ QImage LayerItem::applyCageWarp( const QString &caller )
       return m_cageMesh.image();
      }
     #endif
+    // the exact warp replaces any preview frame still in flight
+    cancelInteractiveWarp(false);
     if ( !m_cageMesh.isInitialized(true) ) {
       m_cageMesh.setImage(m_image);
     }
@@ -570,31 +750,72 @@ QImage LayerItem::applyCageWarp( const QString &caller )
       options.inverseMapping = CageWarpRenderer::InverseMapping::Newton;
       options.inverseIterations = 10;
       QImage warped = m_cageWarpRenderer->warp(m_cageMesh.points(),nullptr,options);
-      setPixmap(QPixmap::fromImage(warped));
+      prepareGeometryChange();
       m_image = warped;
+      updatePixmap();
       QGraphicsPixmapItem::setPos(QGraphicsPixmapItem::pos() + m_cageMesh.getOffset());
       m_cageApplied = true;
       return m_image.copy();
     } else {
       // NOT YET WORKING: QuadWarp::WarpResult warped = QuadWarp::warp(m_cageMesh.image(),m_cageMesh);
       TriangleWarp::WarpResult warped = TriangleWarp::warp(m_image, m_cageMesh.image(),m_cageMesh);
-      m_cageMesh.setActiveCagePointId(-1);
-      m_cageMesh.setOffset(0,0);   // CLAUDE reset after each drawing
-      if ( !warped.image.isNull() ) {
-       setPixmap(QPixmap::fromImage(warped.image));
-       m_image = warped.image;
-       QGraphicsPixmapItem::setPos(QGraphicsPixmapItem::pos());
-       // QGraphicsPixmapItem::setPos(QGraphicsPixmapItem::pos() + m_cageMesh.getOffset());
-       m_cageApplied = true;
-       return m_image.copy();
-      } else {
-       qCritical() << "CRITICAL - LayerItem::applyCageWarp(): WARNING: Image isNull.";
-      }
+      return finishCageWarp(warped.image);
     }
-    return QImage(); 
   }
 }
 
+// The CPU warp of applyCageWarp() after initCage( pts, rect, rows, columns ),
+// done on copies of the mesh and the image. The layer is only read, so this
+// may run on a worker thread as long as the layer is not modified meanwhile.
+// Null if the warp has to run on the GPU.
+QImage LayerItem::cageWarpImage( const QVector<QPointF>& pts, const QRectF& rect, int rows, int columns ) const
+{
+  qCDebug(logEditor) << "LayerItem::cageWarpImage(): rect =" << rect << ", rows =" << rows << ", columns =" << columns;
+  {
+    if ( Config::gpuCageWarpProcessing || EditorStyle::instance().useGPU() ) 
+      return QImage();
+    CageMesh mesh = m_cageMesh;
+    mesh.setIsInitialized();
+    mesh.create(rect,rows,columns);
+    mesh.setPoints(pts);
+    QImage current = m_image;
+    if ( !mesh.isInitialized(true) ) {
+      mesh.setImage(current);
+    }
+    return TriangleWarp::warp(current, mesh.image(), mesh).image;
+  }
+}
+
+// applies a warp computed by cageWarpImage() like applyCageWarp() does
+QImage LayerItem::applyPreparedCageWarp( const QImage& warped )
+{
+  qCDebug(logEditor) << "LayerItem::applyPreparedCageWarp(): name =" << name() << ", size =" << warped.size();
+  {
+    cancelInteractiveWarp(false);
+    if ( !m_cageMesh.isInitialized(true) ) {
+      m_cageMesh.setImage(m_image);
+    }
+    return finishCageWarp(warped);
+  }
+}
+
+QImage LayerItem::finishCageWarp( const QImage& warped )
+{
+    m_cageMesh.setActiveCagePointId(-1);
+    m_cageMesh.setOffset(0,0);   // CLAUDE reset after each drawing
+    if ( warped.isNull() ) {
+      qCritical() << "CRITICAL - LayerItem::applyCageWarp(): WARNING: Image isNull.";
+      return QImage();
+    }
+    prepareGeometryChange();
+    m_image = warped;
+    updatePixmap();
+    QGraphicsPixmapItem::setPos(QGraphicsPixmapItem::pos());
+    // QGraphicsPixmapItem::setPos(QGraphicsPixmapItem::pos() + m_cageMesh.getOffset());
+    m_cageApplied = true;
+    return m_image.copy();
+}
+
 void LayerItem::enableCage( int cols, int rows )
 {
   qCDebug(logEditor) << "LayerItem::enableCage(): cols =" << cols << ", rows =" << rows 
@@ -613,20 +834,10 @@ void LayerItem::enableCage( int cols, int rows )
       m_cageOverlay->setParentItem(this);
     }
     m_cageOverlay->setVisible(true);
-    // Handles
+    // Handles (drawn and hit tested by the overlay, replace the transform handles)
     qDeleteAll(m_handles);
     m_handles.clear();
-    for ( int i = 0; i < m_cageMesh.pointCount(); ++i ) {
-      auto* h = new CageControlPointItem(this, i);
-      h->setParentItem(this);
-      h->setPos(m_cageMesh.point(i));
-      int col = i % m_cageMesh.cols();
-      int row = i / m_cageMesh.rows();
-      int dx = ( col == 0 ) ? 0 : ( ( col == m_cageMesh.cols()-1 ) ? -2*m_cageMesh.getRadius() : -m_cageMesh.getRadius() );
-      int dy = ( row == 0 ) ? 0 : ( ( row == m_cageMesh.rows()-1 ) ? -2*m_cageMesh.getRadius() : -m_cageMesh.getRadius() );
-      h->setRect(dx, dy, 2*m_cageMesh.getRadius(), 2*m_cageMesh.getRadius() );
-      m_handles << h;
-    }
+    m_cageOverlay->setHandlesVisible(true);
   }
 }
 
@@ -663,9 +874,7 @@ void LayerItem::setCageVisible( int caller, bool isVisible )
        m_cageMesh.setActive(true);
        m_cageEnabled = true;
        m_cageEditing = true;
-       for ( int i = 0; i < m_handles.size(); ++i ) {
-         m_handles[i]->setVisible(true);
-       }
+       m_cageOverlay->setHandlesVisible(true);
        m_cageOverlay->setVisible(true);
      } else {
 #if 0
@@ -684,9 +893,7 @@ void LayerItem::setCageVisible( int caller, bool isVisible )
        m_cageMesh.setActive(false);
        m_cageEnabled = false;
        m_cageEditing = false;
-       for ( int i = 0; i < m_handles.size(); ++i ) {
-         m_handles[i]->setVisible(false);
-       }
+       m_cageOverlay->setHandlesVisible(false);
        m_cageOverlay->setVisible(false);
     }
     update();
@@ -704,26 +911,8 @@ void LayerItem::setCageVisible( LayerItem::OperationMode mode, bool isVisible, b
     switch ( mode ) {
       case LayerItem::OperationMode::CageWarp:
         if ( m_cageOverlay != nullptr ) {
-          if( m_handles.size() == 0 ) {
-            // create handles if they have not been created (when read from .json)
-            // CLAUDE -- this should be moved to a more convenient place.
-            qDeleteAll(m_handles);
-            m_handles.clear();
-            for ( int i = 0; i < m_cageMesh.pointCount(); ++i ) {
-              auto* h = new CageControlPointItem(this, i);
-              h->setParentItem(this);
-              h->setPos(m_cageMesh.point(i));
-              int col = i % m_cageMesh.cols();
-              int row = i / m_cageMesh.cols();
-              int dx = ( col == 0 ) ? 0 : ( ( col == m_cageMesh.cols()-1 ) ? -2*m_cageMesh.getRadius() : -m_cageMesh.getRadius() );
-              int dy = ( row == 0 ) ? 0 : ( ( row == m_cageMesh.rows()-1 ) ? -2*m_cageMesh.getRadius() : -m_cageMesh.getRadius() );
-              h->setRect(dx, dy, 2*m_cageMesh.getRadius(), 2*m_cageMesh.getRadius() );
-              m_handles << h;
-            }
-          }
-          for ( int i = 0; i < m_handles.size(); ++i ) {
-            m_handles[i]->setVisible(isVisible);
-          }
+          // the overlay draws the control points of the current mesh, also when read from .json
+          m_cageOverlay->setHandlesVisible(isVisible);
           m_cageOverlay->setVisible(isVisible);
         } else {
           qCDebug(logEditor) << "WARNING: m_cageOverlay is null."; 
@@ -765,16 +954,9 @@ int LayerItem::changeNumberOfActiveCagePoints( int step )
       // update handles
       qDeleteAll(m_handles);
       m_handles.clear();
-      for ( int i = 0; i < m_cageMesh.pointCount(); ++i ) {
-       auto* h = new CageControlPointItem(this, i);
-       h->setParentItem(this);
-       h->setPos(m_cageMesh.point(i));
-       int col = i % m_cageMesh.cols();
-       int row = i / m_cageMesh.cols();
-       int dx = ( col == 0 ) ? 0 : ( ( col == m_cageMesh.cols()-1 ) ? -2*m_cageMesh.getRadius() : -m_cageMesh.getRadius() );
-       int dy = ( row == 0 ) ? 0 : ( ( row == m_cageMesh.rows()-1 ) ? -2*m_cageMesh.getRadius() : -m_cageMesh.getRadius() );
-       h->setRect(dx, dy, 2*m_cageMesh.getRadius(), 2*m_cageMesh.getRadius() );
-       m_handles << h;
+      if ( m_cageOverlay != nullptr ) {
+        m_cageOverlay->setHandlesVisible(true);
+        m_cageOverlay->update();
       }
       return rows;
      }
@@ -821,14 +1003,14 @@ void LayerItem::updateCagePoint( TransformHandleItem* handle, const QPointF& loc
 
 void LayerItem::resetCageToPixmap()
 {
-  qCDebug(logEditor) << "LayerItem::resetCageToPixmap(): size =" << m_handles.size();
+  qCDebug(logEditor) << "LayerItem::resetCageToPixmap(): size =" << m_cageMesh.pointCount();
   {
     prepareGeometryChange();
-    qreal w = pixmap().width();
-    qreal h = pixmap().height();
+    qreal w = m_image.width();
+    qreal h = m_image.height();
     setOffset(0, 0);
     QList<QPointF> resetPoints;
-    int nrc = qSqrt(m_handles.size());
+    int nrc = qSqrt(m_cageMesh.pointCount());
     qreal dx = w/(nrc-1);
     qreal dy = h/(nrc-1);
     for ( int i=0 ; i<nrc ; i++ ) {
@@ -839,11 +1021,6 @@ void LayerItem::resetCageToPixmap()
       }
     }
     m_cageMesh.setPoints(resetPoints);
-    for ( int i = 0; i < m_handles.size(); ++i ) {
-        if ( i < resetPoints.size() ) {
-            m_handles[i]->setPos(resetPoints[i]);
-        }
-    }
     applyCageWarp("LayerItem");
   }
 }
@@ -870,15 +1047,65 @@ void LayerItem::setCagePoint( int idx, const QPointF& pos )
         }
         m_cageMesh.setPoints(pts);
     }
-    for ( int i = 0; i < m_handles.size(); ++i ) {
-        m_handles[i]->setPos(m_cageMesh.point(i));
-    }
     m_cageMesh.setActiveCagePointId(idx);
     m_cageMesh.relax();
+    if ( m_cageEditing ) {
+      requestInteractiveWarp();
+    }
     update();
   }
 }
 
+void LayerItem::requestInteractiveWarp()
+{
+  qCDebug(logEditor) << "LayerItem::requestInteractiveWarp(): name =" << name();
+  {
+    // the GPU renderer owns a GL context of the GUI thread, it warps on release only
+    if ( Config::gpuCageWarpProcessing || EditorStyle::instance().useGPU() )
+      return;
+    if ( !m_cageMesh.isInitialized(true) ) {
+      m_cageMesh.setImage(m_image);
+    }
+    if ( m_warpPipeline == nullptr ) {
+      m_warpPipeline = new CageWarpPipeline();
+      QObject::connect(m_warpPipeline, &CageWarpPipeline::frameReady, m_warpPipeline, [this](const QImage& frame, quint64 generation){
+        // preview only, m_image stays the base of the exact warp on release
+        if ( !m_cageEditing || generation != m_warpPipeline->generation() )
+          return;
+        prepareGeometryChange();
+        m_warpPreview = frame;
+        m_warpPreviewShown = true;
+        updatePixmap();
+      });
+    }
+    // the worker gets its own copies, the mesh keeps changing while it warps
+    CageMesh mesh = m_cageMesh;
+    QImage current = m_image;
+    m_warpPipeline->request([mesh, current](const CageWarpPipeline::CancelFn& isCanceled) mutable {
+      return TriangleWarp::warp(current, mesh.image(), mesh, isCanceled).image;
+    });
+  }
+}
+
+void LayerItem::cancelInteractiveWarp( bool restorePixmap )
+{
+  qCDebug(logEditor) << "LayerItem::cancelInteractiveWarp(): name =" << name() << ", previewShown =" << m_warpPreviewShown;
+  {
+    if ( m_warpPipeline != nullptr ) {
+      m_warpPipeline->cancel();
+    }
+    const bool previewShown = m_warpPreviewShown;
+    if ( previewShown ) {
+      prepareGeometryChange();
+    }
+    m_warpPreviewShown = false;
+    m_warpPreview = QImage();
+    if ( previewShown && restorePixmap ) {
+      updatePixmap();
+    }
+  }
+}
+
 /** */
 
 void LayerItem::commitCageTransform( const QVector<QPointF> &cage )
@@ -1053,11 +1280,8 @@ void LayerItem::mousePressEvent( QGraphicsSceneMouseEvent* event )
         if ( ( event->modifiers() & Qt::AltModifier ) || ( event->modifiers() & Qt::ControlModifier ) ) {
           setOpacity(EditorStyle::instance().layerOverlayOpacity());
           if ( event->modifiers() & Qt::ControlModifier ) {
-            // color effect
-            QGraphicsColorizeEffect* colorEffect = new QGraphicsColorizeEffect();
-            colorEffect->setColor(Qt::red);
-            colorEffect->setStrength(1.0);
-            setGraphicsEffect(colorEffect);
+            // tinted while drawn, an offscreen graphics effect would re-render the layer each frame
+            setHighlighted(true);
           }
         }
       }
@@ -1094,7 +1318,7 @@ void LayerItem::mouseReleaseEvent( QGraphicsSceneMouseEvent* event )
   {
     if ( !isSelected() ) return;
     setOpacity(1.0);
-    setGraphicsEffect(nullptr);
+    setHighlighted(false);
     if ( !m_undoStack ) {
       QGraphicsPixmapItem::mouseReleaseEvent(event);
       return;
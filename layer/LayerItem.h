@@ -24,20 +24,24 @@
 #include <QImage>
 #include <QPen>
 
+#include <memory>
+
 #include "CageMesh.h"
 #include "PerspectiveTransform.h"
+#include "TilePyramid.h"
 #include "../undo/CageWarpCommand.h"
 
 // ---
 class Layer;
 class CageOverlayItem;
-class CageControlPointItem;
 class CageWarpRenderer;
+class CageWarpPipeline;
 class TransformHandleItem;
 class TransformOverlay;
 class PerspectiveOverlay;
 class TransformLayerCommand;
 class ImageViewer;
+namespace BrushEngine { class Coverage; }
 
 // ---
 class LayerItem : public QGraphicsPixmapItem
@@ -52,21 +56,48 @@ class LayerItem : public QGraphicsPixmapItem
                           
     static QString operationModeName( int mode );
 
+    // presentation only, applied while drawing or compositing, pixel buffers are never touched
+    struct RenderState {
+      qreal opacity = 1.0;
+      bool visible = true;
+      bool highlighted = false;
+      bool solo = false;
+    };
+    
+    // pixels and geometry as left by the undo commands of this layer, all
+    // members are implicitly shared, so capturing is O(1)
+    struct HistoryState {
+      QImage image;
+      QImage originalImage;
+      ImageType originalImageType = ImageType::Unknown;
+      QPointF pos;
+      QTransform transform;
+      QTransform totalTransform;
+      double rotation = 0.0;
+      QVector<QPointF> cagePoints;
+      bool cageApplied = false;
+    };
+
     LayerItem( const QString& name, const QPixmap& pixmap, QGraphicsItem* parent = nullptr );
     LayerItem( const QString& name, const QImage& image, QGraphicsItem* parent = nullptr );
+    ~LayerItem() override;
     
     QRectF boundingRect() const override;
+    QPainterPath shape() const override;
     
-    void paintStrokeSegment( const QPoint& p0, const QPoint &p1, const QColor &color, int radius, float hardness );
+    // --- live painting, one coverage buffer per stroke as in PaintStrokeCommand::paint() ---
+    void beginStroke();
+    void paintStrokeSegment( const QPoint& p0, const QPoint &p1, const QColor &color, int radius, float hardness, int brushMode = 0 );
+    void endStroke();
 
     QImage& image( int id=0 );
     QString getAlphaMaskData( bool base64Encoding = true );
     void setOriginalImage( const QImage& originalImage, ImageType imageType = ImageType::Original );
     const QImage& originalImage();
+    // call after m_image changed, the item keeps no pixmap of its own
     void updatePixmap();
-    void resetPixmap();
     void resetTotalTransform();
-    void setFileInfo( const QString& filePath );
+    void setFileInfo( const QString& filePath, const QString& checksum = QString() );
     void setImage( const QImage &image );
     void setLayer( Layer *layer );
     QString filename() const { return m_filename; }
@@ -87,7 +118,8 @@ class LayerItem : public QGraphicsPixmapItem
     void setRotationAngle( double value );
     double getRotationAngle() const { return m_currentRotation; }
     void setImageRect( const QRectF& rect );
-    void setImageTransform( const QTransform& transform, bool combine = true );
+    void setImageTransform( const QTransform& transform, bool combine = true, const QImage& transformed = QImage() );
+    QImage transformedImage( const QTransform& transform, bool combine = true ) const;
     void resetImageState( const QImage& image, const QPointF& position, const QTransform& transform );
     void endCageEdit( int idx, const QPointF& pos );
     void setType( LayerType layerType );
@@ -138,6 +170,9 @@ class LayerItem : public QGraphicsPixmapItem
     void resetCageToPixmap();
     QVector<QPointF> cagePoints() const;
     QImage applyCageWarp( const QString& caller = "unknown" );
+    QImage cageWarpImage( const QVector<QPointF>& pts, const QRectF& rect, int rows, int columns ) const;
+    QImage applyPreparedCageWarp( const QImage& warped );
+    void cancelInteractiveWarp( bool restorePixmap = true );
     void enableCage( int cols = -1, int nrows = -1 );
     
     void applyPerspective();
@@ -149,6 +184,22 @@ class LayerItem : public QGraphicsPixmapItem
         prepareGeometryChange();
     }
     
+    // changes whenever the pixels change, e.g. to refresh thumbnails
+    quint64 contentGeneration() const { return m_contentGeneration; }
+    // whole coarse mip level with at least minExtent pixels on the larger side
+    QImage previewImage( int minExtent ) { return m_tilePyramid.levelImage(displayImage(), minExtent); }
+    
+    const RenderState& renderState() const { return m_renderState; }
+    void setRenderOpacity( qreal opacity );
+    void setRenderVisible( bool visible );
+    void setHighlighted( bool highlighted );
+    void setSolo( bool solo );
+    bool isRendered() const;          // visible and not hidden by a solo layer
+    static bool hasSoloLayer() { return s_soloLayers > 0; }
+    
+    HistoryState historyState() const;
+    void restoreHistoryState( const HistoryState& state );
+    
     void printself( bool debugSave = false );
 
   protected:
@@ -159,6 +210,7 @@ class LayerItem : public QGraphicsPixmapItem
     void mouseMoveEvent(QGraphicsSceneMouseEvent*) override;
     void mouseReleaseEvent( QGraphicsSceneMouseEvent* ) override;
     void mouseDoubleClickEvent( QGraphicsSceneMouseEvent* ) override;
+    QVariant itemChange( GraphicsItemChange change, const QVariant& value ) override;
     
     QImage m_image;
     QImage m_originalImage;
@@ -170,6 +222,12 @@ class LayerItem : public QGraphicsPixmapItem
 
     void init();
     bool isValidMouseEventOperation();
+    void requestInteractiveWarp();
+    QImage finishCageWarp( const QImage& warped );
+    // pixels drawn by paint(), the tile pyramid is built from them
+    const QImage& displayImage() const { return m_warpPreviewShown ? m_warpPreview : m_image; }
+    QTransform combinedTransform( const QImage& source, const QTransform& transform, bool combine ) const;
+    QImage interpolatedImage( const QImage& source, const QTransform& total ) const;
     
     int m_index = 0;
     
@@ -193,6 +251,12 @@ class LayerItem : public QGraphicsPixmapItem
     PerspectiveTransform m_perspective;
     CageWarpCommand* m_cageWarpCommand = nullptr;
     CageWarpRenderer* m_cageWarpRenderer = nullptr;
+    CageWarpPipeline* m_warpPipeline = nullptr;
+    TilePyramid m_tilePyramid;
+    RenderState m_renderState;
+    static int s_soloLayers;
+    static quint64 s_contentGenerations;
+    quint64 m_contentGeneration = ++s_contentGenerations;
 
     Layer* m_layer = nullptr;
 	
@@ -203,6 +267,10 @@ class LayerItem : public QGraphicsPixmapItem
     bool m_cageEnabled = false;
     bool m_cageEditing = false;
     bool m_cageApplied = false;
+    bool m_warpPreviewShown = false;
+    QImage m_warpPreview;         // frame of the interactive warp, shown instead of m_image
+    std::unique_ptr<BrushEngine::Coverage> m_strokeCoverage;   // coverage of the stroke being painted
+    int m_strokeSegments = 0;
     bool m_mouseOperationActive = false;
     bool m_isDeleted = false;
 	
@@ -0,0 +1,116 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "OverlayBatch.h"
+
+#include <algorithm>
+
+void OverlayBatch::setPoints( const QVector<QPointF>& points )
+{
+  m_points = points;
+  m_gridDirty = true;
+}
+
+void OverlayBatch::buildGrid() const
+{
+  m_gridDirty = false;
+  m_cellStart.clear();
+  m_cellPoints.clear();
+  m_gridCols = 0;
+  m_gridRows = 0;
+  const int n = m_points.size();
+  if ( n == 0 )
+    return;
+  qreal x0 = m_points[0].x(), x1 = x0;
+  qreal y0 = m_points[0].y(), y1 = y0;
+  for ( const QPointF& p : m_points ) {
+    x0 = std::min(x0, p.x());
+    x1 = std::max(x1, p.x());
+    y0 = std::min(y0, p.y());
+    y1 = std::max(y1, p.y());
+  }
+  m_gridBounds = QRectF(QPointF(x0, y0), QPointF(x1, y1));
+  // about one point per cell, degenerate (flat) point sets fall back to a row of cells
+  const qreal w = x1 - x0;
+  const qreal h = y1 - y0;
+  m_cellSize = std::max({ qSqrt(w * h / n), std::max(w, h) / n, qreal(1.0) });
+  m_gridCols = int(w / m_cellSize) + 1;
+  m_gridRows = int(h / m_cellSize) + 1;
+  // counting sort into cells
+  m_cellStart.fill(0, m_gridCols * m_gridRows + 1);
+  QVector<int> cellOf(n);
+  for ( int i = 0; i < n; ++i ) {
+    const int cx = std::min(int((m_points[i].x() - x0) / m_cellSize), m_gridCols - 1);
+    const int cy = std::min(int((m_points[i].y() - y0) / m_cellSize), m_gridRows - 1);
+    cellOf[i] = cy * m_gridCols + cx;
+    m_cellStart[cellOf[i] + 1] += 1;
+  }
+  for ( int c = 0; c < m_gridCols * m_gridRows; ++c ) {
+    m_cellStart[c + 1] += m_cellStart[c];
+  }
+  m_cellPoints.resize(n);
+  QVector<int> fill = m_cellStart;
+  for ( int i = 0; i < n; ++i ) {
+    m_cellPoints[fill[cellOf[i]]++] = i;
+  }
+}
+
+int OverlayBatch::hitTest( const QPointF& pos, qreal radius ) const
+{
+  if ( m_gridDirty )
+    buildGrid();
+  if ( m_gridCols == 0 )
+    return -1;
+  if ( !m_gridBounds.adjusted(-radius, -radius, radius, radius).contains(pos) )
+    return -1;
+  const int c0 = std::max(0, int((pos.x() - radius - m_gridBounds.left()) / m_cellSize));
+  const int c1 = std::min(m_gridCols - 1, int((pos.x() + radius - m_gridBounds.left()) / m_cellSize));
+  const int r0 = std::max(0, int((pos.y() - radius - m_gridBounds.top()) / m_cellSize));
+  const int r1 = std::min(m_gridRows - 1, int((pos.y() + radius - m_gridBounds.top()) / m_cellSize));
+  int best = -1;
+  qreal bestDist = radius * radius;
+  for ( int r = r0; r <= r1; ++r ) {
+    for ( int c = c0; c <= c1; ++c ) {
+      const int cell = r * m_gridCols + c;
+      for ( int k = m_cellStart[cell]; k < m_cellStart[cell + 1]; ++k ) {
+        const int i = m_cellPoints[k];
+        const QPointF d = m_points[i] - pos;
+        const qreal dist = d.x() * d.x() + d.y() * d.y();
+        // equal distances resolve to the lower index, independent of the cell order
+        if ( dist < bestDist || ( dist == bestDist && ( best < 0 || i < best ) ) ) {
+          best = i;
+          bestDist = dist;
+        }
+      }
+    }
+  }
+  return best;
+}
+
+QVector<int> OverlayBatch::visibleIndices( const QRectF& exposed, qreal margin, qreal lod, qreal cellPixels ) const
+{
+  QVector<int> result;
+  const QRectF area = exposed.adjusted(-margin, -margin, margin, margin);
+  // screen cells mapped back to item coordinates
+  ScreenCellFilter cells(( lod > 0.0 && cellPixels > 0.0 ) ? cellPixels / lod : 0.0);
+  for ( int i = 0; i < m_points.size(); ++i ) {
+    const QPointF& p = m_points[i];
+    if ( area.contains(p) && cells.accept(p) )
+      result.append(i);
+  }
+  return result;
+}
@@ -0,0 +1,88 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+#include <QPointF>
+#include <QRectF>
+#include <QSet>
+#include <QVector>
+#include <QtMath>
+
+// -------------------------- ScreenCellFilter --------------------------
+// Accepts one point per square cell (item coordinates, usually a handle
+// sized screen cell mapped back by the level of detail). Handles sharing
+// a cell would overlap anyway. A cell size <= 0 accepts every point.
+class ScreenCellFilter {
+
+public:
+
+    explicit ScreenCellFilter( qreal cell ) : m_cell(cell) {}
+
+    bool accept( const QPointF& p ) {
+      if ( m_cell <= 0.0 )
+        return true;
+      const quint64 key = (quint64(quint32(qFloor(p.x() / m_cell))) << 32) | quint32(qFloor(p.y() / m_cell));
+      if ( m_occupied.contains(key) )
+        return false;
+      m_occupied.insert(key);
+      return true;
+    }
+
+private:
+
+    qreal m_cell;
+    QSet<quint64> m_occupied;
+
+};
+
+// -------------------------- OverlayBatch --------------------------
+// Control points of one overlay (e.g. the cage grid) kept as plain
+// points instead of one QGraphicsItem each. The owning item paints all of
+// them in a single call: points outside the exposed rect are culled and at
+// low zoom only one point per handle sized screen cell is drawn. Hit tests
+// go through a uniform bucket grid which is rebuilt lazily after a change.
+class OverlayBatch {
+
+public:
+
+    void setPoints( const QVector<QPointF>& points );   // implicitly shared, O(1)
+    const QVector<QPointF>& points() const { return m_points; }
+    int pointCount() const { return m_points.size(); }
+
+    // nearest point within radius (item coordinates) or -1
+    int hitTest( const QPointF& pos, qreal radius ) const;
+
+    // indices of the points to draw for the exposed rect, margin extends the
+    // rect by the handle size, lod is the painter's level of detail and
+    // cellPixels the minimum distance of two drawn points on screen
+    QVector<int> visibleIndices( const QRectF& exposed, qreal margin, qreal lod, qreal cellPixels ) const;
+
+private:
+
+    void buildGrid() const;
+
+    QVector<QPointF> m_points;
+    mutable bool m_gridDirty = true;
+    mutable QRectF m_gridBounds;
+    mutable qreal m_cellSize = 1.0;
+    mutable int m_gridCols = 0;
+    mutable int m_gridRows = 0;
+    mutable QVector<int> m_cellStart;   // m_gridCols*m_gridRows+1 offsets into m_cellPoints
+    mutable QVector<int> m_cellPoints;
+
+};
@@ -0,0 +1,288 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+#include "PolygonIndex.h"
+
+#include <QtMath>
+
+#include <algorithm>
+
+namespace {
+
+  qreal segmentDistance2( const QPointF& p, const QPointF& a, const QPointF& b )
+  {
+    const QPointF ab = b - a;
+    const QPointF ap = p - a;
+    const qreal len2 = QPointF::dotProduct(ab, ab);
+    const qreal t = len2 > 0.0 ? qBound(qreal(0.0), QPointF::dotProduct(ap, ab) / len2, qreal(1.0)) : 0.0;
+    const QPointF d = ap - ab * t;
+    return QPointF::dotProduct(d, d);
+  }
+
+  void eraseValue( QVector<int>& list, int value )
+  {
+    const int k = list.indexOf(value);
+    if ( k >= 0 ) {
+      list[k] = list.last();
+      list.removeLast();
+    }
+  }
+
+  constexpr int MaxCells = 1024;   // per axis
+
+}
+
+// -------------------------- Build --------------------------
+void PolygonIndex::clear()
+{
+  m_count = 0;
+  m_bounds = QRectF();
+  m_cols = 0;
+  m_rows = 0;
+  m_cellVertices.clear();
+  m_cellEdges.clear();
+}
+
+void PolygonIndex::rebuild( const QPolygonF& poly )
+{
+  clear();
+  m_count = poly.size();
+  if ( m_count == 0 )
+    return;
+  m_bounds = poly.boundingRect();
+  m_origin = m_bounds.topLeft();
+  // about one vertex per cell, flat polygons fall back to a row of cells
+  const qreal w = m_bounds.width();
+  const qreal h = m_bounds.height();
+  m_cellSize = std::max({ qSqrt(w * h / m_count), std::max(w, h) / MaxCells, qreal(1.0) });
+  m_cols = qMin(MaxCells, int(w / m_cellSize) + 1);
+  m_rows = qMin(MaxCells, int(h / m_cellSize) + 1);
+  m_cellVertices.resize(m_cols * m_rows);
+  m_cellEdges.resize(m_cols * m_rows);
+  for ( int i = 0; i < m_count; ++i ) {
+    m_cellVertices[cellOf(poly[i])].append(i);
+    addEdge(i, poly[i], poly[(i + 1) % m_count]);
+  }
+}
+
+int PolygonIndex::cellColumn( qreal x ) const
+{
+  return qBound(0, int(qFloor((x - m_origin.x()) / m_cellSize)), m_cols - 1);
+}
+
+int PolygonIndex::cellRow( qreal y ) const
+{
+  return qBound(0, int(qFloor((y - m_origin.y()) / m_cellSize)), m_rows - 1);
+}
+
+// -------------------------- Cells --------------------------
+void PolygonIndex::addVertex( int idx, const QPointF& p )
+{
+  m_cellVertices[cellOf(p)].append(idx);
+  // QRectF::united() ignores empty rects, points have no size
+  m_bounds.setCoords(qMin(m_bounds.left(), p.x()), qMin(m_bounds.top(), p.y()),
+                     qMax(m_bounds.right(), p.x()), qMax(m_bounds.bottom(), p.y()));
+}
+
+void PolygonIndex::removeVertex( int idx, const QPointF& p )
+{
+  eraseValue(m_cellVertices[cellOf(p)], idx);
+}
+
+void PolygonIndex::addEdge( int edge, const QPointF& a, const QPointF& b )
+{
+  const int c0 = cellColumn(qMin(a.x(), b.x()));
+  const int c1 = cellColumn(qMax(a.x(), b.x()));
+  const int r0 = cellRow(qMin(a.y(), b.y()));
+  const int r1 = cellRow(qMax(a.y(), b.y()));
+  for ( int r = r0; r <= r1; ++r ) {
+    for ( int c = c0; c <= c1; ++c ) {
+      m_cellEdges[r * m_cols + c].append(edge);
+    }
+  }
+}
+
+void PolygonIndex::removeEdge( int edge, const QPointF& a, const QPointF& b )
+{
+  const int c0 = cellColumn(qMin(a.x(), b.x()));
+  const int c1 = cellColumn(qMax(a.x(), b.x()));
+  const int r0 = cellRow(qMin(a.y(), b.y()));
+  const int r1 = cellRow(qMax(a.y(), b.y()));
+  for ( int r = r0; r <= r1; ++r ) {
+    for ( int c = c0; c <= c1; ++c ) {
+      eraseValue(m_cellEdges[r * m_cols + c], edge);
+    }
+  }
+}
+
+// renumbers vertices and edges >= from, integer pass without geometry
+void PolygonIndex::shift( int from, int delta )
+{
+  for ( QVector<int>& cell : m_cellVertices ) {
+    for ( int& i : cell ) {
+      if ( i >= from ) i += delta;
+    }
+  }
+  for ( QVector<int>& cell : m_cellEdges ) {
+    for ( int& i : cell ) {
+      if ( i >= from ) i += delta;
+    }
+  }
+}
+
+// -------------------------- Incremental updates --------------------------
+void PolygonIndex::pointMoved( const QPolygonF& poly, int idx, const QPointF& oldPos )
+{
+  const int n = poly.size();
+  if ( n != m_count || m_cols == 0 ) {
+    rebuild(poly);
+    return;
+  }
+  if ( idx < 0 || idx >= n )
+    return;
+  const QPointF& prev = poly[(idx + n - 1) % n];
+  const QPointF& next = poly[(idx + 1) % n];
+  removeVertex(idx, oldPos);
+  removeEdge((idx + n - 1) % n, prev, oldPos);
+  removeEdge(idx, oldPos, next);
+  addVertex(idx, poly[idx]);
+  addEdge((idx + n - 1) % n, prev, poly[idx]);
+  addEdge(idx, poly[idx], next);
+}
+
+void PolygonIndex::pointInserted( const QPolygonF& poly, int idx )
+{
+  const int n = poly.size();
+  if ( n != m_count + 1 || m_count < 3 || m_cols == 0 || idx < 0 || idx >= n ) {
+    rebuild(poly);
+    return;
+  }
+  // the edge which is split, in the numbering before the insert
+  removeEdge((idx + m_count - 1) % m_count, poly[(idx + n - 1) % n], poly[(idx + 1) % n]);
+  shift(idx, 1);
+  m_count = n;
+  addVertex(idx, poly[idx]);
+  addEdge((idx + n - 1) % n, poly[(idx + n - 1) % n], poly[idx]);
+  addEdge(idx, poly[idx], poly[(idx + 1) % n]);
+}
+
+void PolygonIndex::pointRemoved( const QPolygonF& poly, int idx, const QPointF& oldPos )
+{
+  const int n = poly.size();
+  if ( n != m_count - 1 || n < 3 || m_cols == 0 || idx < 0 || idx > n ) {
+    rebuild(poly);
+    return;
+  }
+  const QPointF& prev = poly[(idx + n - 1) % n];
+  const QPointF& next = poly[idx % n];
+  removeVertex(idx, oldPos);
+  removeEdge((idx + m_count - 1) % m_count, prev, oldPos);
+  removeEdge(idx, oldPos, next);
+  shift(idx + 1, -1);
+  m_count = n;
+  addEdge((idx + n - 1) % n, prev, next);
+}
+
+// -------------------------- Queries --------------------------
+int PolygonIndex::nearestVertex( const QPolygonF& poly, const QPointF& pos, qreal radius ) const
+{
+  if ( m_cols == 0 || poly.size() != m_count )
+    return -1;
+  const int c0 = cellColumn(pos.x() - radius);
+  const int c1 = cellColumn(pos.x() + radius);
+  const int r0 = cellRow(pos.y() - radius);
+  const int r1 = cellRow(pos.y() + radius);
+  int best = -1;
+  qreal bestDist = radius * radius;
+  for ( int r = r0; r <= r1; ++r ) {
+    for ( int c = c0; c <= c1; ++c ) {
+      for ( int i : m_cellVertices[r * m_cols + c] ) {
+        const QPointF d = poly[i] - pos;
+        const qreal dist = QPointF::dotProduct(d, d);
+        if ( dist < bestDist || ( dist == bestDist && ( best < 0 || i < best ) ) ) {
+          best = i;
+          bestDist = dist;
+        }
+      }
+    }
+  }
+  return best;
+}
+
+int PolygonIndex::nearestEdge( const QPolygonF& poly, const QPointF& pos, qreal radius ) const
+{
+  const int n = poly.size();
+  if ( m_cols == 0 || n != m_count || n < 2 )
+    return -1;
+  const int c0 = cellColumn(pos.x() - radius);
+  const int c1 = cellColumn(pos.x() + radius);
+  const int r0 = cellRow(pos.y() - radius);
+  const int r1 = cellRow(pos.y() + radius);
+  int best = -1;
+  qreal bestDist = radius * radius;
+  for ( int r = r0; r <= r1; ++r ) {
+    for ( int c = c0; c <= c1; ++c ) {
+      for ( int e : m_cellEdges[r * m_cols + c] ) {
+        const qreal dist = segmentDistance2(pos, poly[e], poly[(e + 1) % n]);
+        if ( dist < bestDist || ( dist == bestDist && ( best < 0 || e < best ) ) ) {
+          best = e;
+          bestDist = dist;
+        }
+      }
+    }
+  }
+  return best;
+}
+
+QVector<int> PolygonIndex::verticesIn( const QPolygonF& poly, const QRectF& rect ) const
+{
+  QVector<int> result;
+  if ( m_cols == 0 || poly.size() != m_count )
+    return result;
+  for ( int r = cellRow(rect.top()); r <= cellRow(rect.bottom()); ++r ) {
+    for ( int c = cellColumn(rect.left()); c <= cellColumn(rect.right()); ++c ) {
+      for ( int i : m_cellVertices[r * m_cols + c] ) {
+        if ( rect.contains(poly[i]) ) result.append(i);
+      }
+    }
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+QVector<int> PolygonIndex::edgesIn( const QPolygonF& poly, const QRectF& rect ) const
+{
+  QVector<int> result;
+  const int n = poly.size();
+  if ( m_cols == 0 || n != m_count )
+    return result;
+  for ( int r = cellRow(rect.top()); r <= cellRow(rect.bottom()); ++r ) {
+    for ( int c = cellColumn(rect.left()); c <= cellColumn(rect.right()); ++c ) {
+      for ( int e : m_cellEdges[r * m_cols + c] ) {
+        const QPointF& a = poly[e];
+        const QPointF& b = poly[(e + 1) % n];
+        const QRectF box(QPointF(qMin(a.x(), b.x()), qMin(a.y(), b.y())), QPointF(qMax(a.x(), b.x()), qMax(a.y(), b.y())));
+        // QRectF::intersects() is false for zero width boxes of axis parallel edges
+        if ( box.left() <= rect.right() && box.right() >= rect.left() && box.top() <= rect.bottom() && box.bottom() >= rect.top() )
+          result.append(e);
+      }
+    }
+  }
+  // an edge is listed in every cell its bounding box touches
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  return result;
+}
@@ -0,0 +1,75 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+#pragma once
+
+#include <QPointF>
+#include <QPolygonF>
+#include <QRectF>
+#include <QVector>
+
+// -------------------------- PolygonIndex --------------------------
+// Uniform grid over the vertices and edges of one closed polygon (edge i
+// runs from vertex i to vertex i+1, the last one closes the ring). The index
+// stores indices only, the polygon itself is passed to every call and must
+// already contain the change an update describes. Moving, inserting and
+// removing a vertex touches the cells of the vertex and its two edges, only
+// the index numbers behind an inserted/removed vertex are shifted. Points
+// leaving the grid are clamped into the border cells, queries stay exact.
+class PolygonIndex {
+
+public:
+
+    void rebuild( const QPolygonF& poly );
+    void clear();
+
+    // --- incremental updates ---
+    void pointMoved( const QPolygonF& poly, int idx, const QPointF& oldPos );
+    void pointInserted( const QPolygonF& poly, int idx );
+    void pointRemoved( const QPolygonF& poly, int idx, const QPointF& oldPos );
+
+    // --- queries, equal distances resolve to the lower index ---
+    int nearestVertex( const QPolygonF& poly, const QPointF& pos, qreal radius ) const;
+    int nearestEdge( const QPolygonF& poly, const QPointF& pos, qreal radius ) const;
+    QVector<int> verticesIn( const QPolygonF& poly, const QRectF& rect ) const;   // ascending
+    QVector<int> edgesIn( const QPolygonF& poly, const QRectF& rect ) const;      // ascending, by bounding box
+
+    // covers all vertices, may be larger after incremental updates
+    QRectF bounds() const { return m_bounds; }
+    int pointCount() const { return m_count; }
+
+private:
+
+    int cellColumn( qreal x ) const;
+    int cellRow( qreal y ) const;
+    int cellOf( const QPointF& p ) const { return cellRow(p.y()) * m_cols + cellColumn(p.x()); }
+
+    void addVertex( int idx, const QPointF& p );
+    void removeVertex( int idx, const QPointF& p );
+    void addEdge( int edge, const QPointF& a, const QPointF& b );
+    void removeEdge( int edge, const QPointF& a, const QPointF& b );
+    void shift( int from, int delta );
+
+    int m_count = 0;
+    QRectF m_bounds;
+    QPointF m_origin;
+    qreal m_cellSize = 1.0;
+    int m_cols = 0;
+    int m_rows = 0;
+    QVector<QVector<int>> m_cellVertices;
+    QVector<QVector<int>> m_cellEdges;
+
+};
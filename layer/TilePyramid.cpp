@@ -0,0 +1,245 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "TilePyramid.h"
+
+#include <QPainter>
+#include <QPaintEngine>
+#include <QStyleOptionGraphicsItem>
+
+#include <cmath>
+#include <cstring>
+
+// ------------------------------  ------------------------------
+void TilePyramid::clear()
+{
+  m_levels.clear();
+  m_cacheKey = 0;
+  m_bits = nullptr;
+  m_size = QSize();
+}
+
+// pixel rect of the source changed, source is the already updated image
+void TilePyramid::invalidate( const QRect& rect, const QImage& source )
+{
+  if ( source.size() != m_size ) {
+    clear();
+    return;
+  }
+  // a detached copy moved the pixels, no view may point into the old ones
+  if ( source.constBits() != m_bits && !m_levels.isEmpty() ) {
+    m_levels[0].tiles.fill(QImage());
+  }
+  m_bits = source.constBits();
+  for ( int i = 0; i < m_levels.size(); ++i ) {
+    Level& level = m_levels[i];
+    const int span = TileSize << i;   // source pixels per tile
+    const int c0 = qMax(0, rect.left() / span);
+    const int r0 = qMax(0, rect.top() / span);
+    const int c1 = qMin(level.cols - 1, rect.right() / span);
+    const int r1 = qMin(level.rows - 1, rect.bottom() / span);
+    for ( int r = r0; r <= r1; ++r ) {
+      for ( int c = c0; c <= c1; ++c ) {
+        level.tiles[r * level.cols + c] = QImage();
+      }
+    }
+  }
+  m_cacheKey = source.cacheKey();
+}
+
+// ------------------------------  ------------------------------
+int TilePyramid::levelForScale( qreal scale )
+{
+  if ( scale <= 0.0 || scale >= 1.0 )
+    return 0;
+  return int(std::floor(std::log2(1.0 / scale)));
+}
+
+qint64 TilePyramid::byteCount() const
+{
+  // level 0 tiles share the pixels of the image
+  qint64 bytes = 0;
+  for ( int i = 1; i < m_levels.size(); ++i ) {
+    for ( const QImage& tile : m_levels[i].tiles ) {
+      bytes += tile.sizeInBytes();
+    }
+  }
+  return bytes;
+}
+
+// ------------------------------  ------------------------------
+void TilePyramid::sync( const QImage& source )
+{
+  if ( source.cacheKey() == m_cacheKey && source.size() == m_size )
+    return;
+  m_levels.clear();
+  m_size = source.size();
+  m_cacheKey = source.cacheKey();
+  m_bits = source.constBits();
+  // down to the level where the whole image fits into one tile
+  int w = m_size.width();
+  int h = m_size.height();
+  while ( true ) {
+    Level level;
+    level.width = w;
+    level.height = h;
+    level.cols = (w + TileSize - 1) / TileSize;
+    level.rows = (h + TileSize - 1) / TileSize;
+    level.tiles.resize(level.cols * level.rows);
+    m_levels.append(level);
+    if ( w <= TileSize && h <= TileSize )
+      break;
+    w = (w + 1) / 2;
+    h = (h + 1) / 2;
+  }
+}
+
+const QImage& TilePyramid::tile( const QImage& source, int level, int col, int row )
+{
+  Level& l = m_levels[level];
+  QImage& result = l.tiles[row * l.cols + col];
+  if ( !result.isNull() )
+    return result;
+  if ( level == 0 ) {
+    // only used by texture based paint engines, uploads stay per tile; the
+    // tile wraps the image pixels, the view keeps its cacheKey (and texture)
+    // until invalidate() drops it
+    const QRect area = QRect(col * TileSize, row * TileSize, TileSize, TileSize) & source.rect();
+    if ( source.depth() < 8 || !source.colorTable().isEmpty() ) {
+      result = source.copy(area);
+      return result;
+    }
+    result = QImage(source.constScanLine(area.top()) + area.left() * (source.depth() / 8), 
+                    area.width(), area.height(), source.bytesPerLine(), source.format());
+    return result;
+  }
+  if ( level == 1 ) {
+    const QRect area = QRect(col * 2 * TileSize, row * 2 * TileSize, 2 * TileSize, 2 * TileSize) & source.rect();
+    result = downsample(source.copy(area).convertToFormat(QImage::Format_ARGB32_Premultiplied));
+    return result;
+  }
+  // 2x2 children of the finer level
+  const Level& fine = m_levels[level - 1];
+  const int fc1 = qMin(fine.cols - 1, 2 * col + 1);
+  const int fr1 = qMin(fine.rows - 1, 2 * row + 1);
+  const int w = qMin(2 * TileSize, fine.width - 2 * col * TileSize);
+  const int h = qMin(2 * TileSize, fine.height - 2 * row * TileSize);
+  QImage combined(w, h, QImage::Format_ARGB32_Premultiplied);
+  for ( int fr = 2 * row; fr <= fr1; ++fr ) {
+    for ( int fc = 2 * col; fc <= fc1; ++fc ) {
+      const QImage& child = tile(source, level - 1, fc, fr);
+      const int x0 = (fc - 2 * col) * TileSize;
+      const int y0 = (fr - 2 * row) * TileSize;
+      for ( int y = 0; y < child.height(); ++y ) {
+        std::memcpy(combined.scanLine(y0 + y) + x0 * 4, child.constScanLine(y), size_t(child.width()) * 4);
+      }
+    }
+  }
+  result = downsample(combined);
+  return result;
+}
+
+// 2x2 box filter on premultiplied pixels, odd edges repeat the last pixel
+QImage TilePyramid::downsample( const QImage& src )
+{
+  const int w = (src.width() + 1) / 2;
+  const int h = (src.height() + 1) / 2;
+  QImage dst(w, h, QImage::Format_ARGB32_Premultiplied);
+  const int xmax = src.width() - 1;
+  const int ymax = src.height() - 1;
+  for ( int y = 0; y < h; ++y ) {
+    const quint32* s0 = reinterpret_cast<const quint32*>(src.constScanLine(2 * y));
+    const quint32* s1 = reinterpret_cast<const quint32*>(src.constScanLine(qMin(2 * y + 1, ymax)));
+    quint32* d = reinterpret_cast<quint32*>(dst.scanLine(y));
+    for ( int x = 0; x < w; ++x ) {
+      const int xa = 2 * x;
+      const int xb = qMin(xa + 1, xmax);
+      const quint32 a = s0[xa], b = s0[xb], c = s1[xa], e = s1[xb];
+      // two channels per register, the sum of four bytes fits into 16 bit
+      const quint32 rb = (((a & 0x00ff00ff) + (b & 0x00ff00ff) + (c & 0x00ff00ff) + (e & 0x00ff00ff) + 0x00020002) >> 2) & 0x00ff00ff;
+      const quint32 ag = ((((a >> 8) & 0x00ff00ff) + ((b >> 8) & 0x00ff00ff) + ((c >> 8) & 0x00ff00ff) + ((e >> 8) & 0x00ff00ff) + 0x00020002) << 6) & 0xff00ff00;
+      d[x] = ag | rb;
+    }
+  }
+  return dst;
+}
+
+// ------------------------------  ------------------------------
+void TilePyramid::draw( QPainter* painter, const QImage& source, const QPointF& offset, const QRectF& exposedRect, bool smooth )
+{
+  if ( source.isNull() )
+    return;
+  const QRect area = exposedRect.translated(-offset).toAlignedRect() & source.rect();
+  if ( area.isEmpty() )
+    return;
+  painter->save();
+  painter->setRenderHint(QPainter::SmoothPixmapTransform, smooth);
+  painter->setRenderHint(QPainter::Antialiasing, false);   // no seams between tiles
+  sync(source);
+  const qreal scale = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+  const int level = qMin(levelForScale(scale), int(m_levels.size()) - 1);
+  // GL paint engines cache one texture per image: the full image would be
+  // uploaded again after every change, tiles are uploaded only when dirty
+  const bool textured = painter->paintEngine() != nullptr && 
+                        ( painter->paintEngine()->type() == QPaintEngine::OpenGL2 || 
+                          painter->paintEngine()->type() == QPaintEngine::OpenGL );
+  if ( level == 0 && !textured ) {
+    painter->drawImage(QRectF(area).translated(offset), source, QRectF(area));
+  } else {
+    const int span = TileSize << level;
+    const Level& l = m_levels[level];
+    const int c0 = area.left() / span;
+    const int r0 = area.top() / span;
+    const int c1 = qMin(l.cols - 1, area.right() / span);
+    const int r1 = qMin(l.rows - 1, area.bottom() / span);
+    for ( int r = r0; r <= r1; ++r ) {
+      for ( int c = c0; c <= c1; ++c ) {
+        const QImage& img = tile(source, level, c, r);
+        const QRectF target(c * span, r * span, qMin(span, m_size.width() - c * span), qMin(span, m_size.height() - r * span));
+        painter->drawImage(target.translated(offset), img, QRectF(img.rect()));
+      }
+    }
+  }
+  painter->restore();
+}
+
+// coarsest level whose larger side still has minExtent pixels, only dirty
+// or missing tiles are computed, the others come from the cache
+QImage TilePyramid::levelImage( const QImage& source, int minExtent )
+{
+  if ( source.isNull() )
+    return QImage();
+  sync(source);
+  int level = 0;
+  while ( level + 1 < m_levels.size() && 
+          qMax(m_levels[level + 1].width, m_levels[level + 1].height) >= minExtent ) {
+    level += 1;
+  }
+  if ( level == 0 )
+    return source;
+  const Level& l = m_levels[level];
+  QImage result(l.width, l.height, QImage::Format_ARGB32_Premultiplied);
+  for ( int r = 0; r < l.rows; ++r ) {
+    for ( int c = 0; c < l.cols; ++c ) {
+      const QImage& img = tile(source, level, c, r);
+      for ( int y = 0; y < img.height(); ++y ) {
+        std::memcpy(result.scanLine(r * TileSize + y) + c * TileSize * 4, img.constScanLine(y), size_t(img.width()) * 4);
+      }
+    }
+  }
+  return result;
+}
@@ -0,0 +1,79 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+#include <QImage>
+#include <QPixmap>
+#include <QPointF>
+#include <QRect>
+#include <QRectF>
+#include <QVector>
+
+class QPainter;
+
+/*
+ * TilePyramid
+ * -----------
+ * Mip-mapped 256x256 tiles of a layer image for drawing zoomed out views.
+ * - level L is downsampled by 2^L, level 0 is drawn from the image itself
+ *   (tiled only for texture based paint engines, i.e. the GL viewport, the
+ *   level 0 tiles are views on the image pixels, not copies)
+ * - tiles are built lazily on first draw (level L from the tiles of L-1)
+ * - a changed image (new cacheKey) drops all tiles, invalidate(rect)
+ *   drops only the tiles covering rect on every level
+ * - no reference to the image is kept, writing into it never detaches,
+ *   level 0 views are dropped as soon as the image moves its pixels
+ * - levelImage() assembles a whole coarse level, e.g. for thumbnails
+ */
+
+class TilePyramid
+{
+
+  public:
+
+    static constexpr int TileSize = 256;
+
+    void clear();
+    void invalidate( const QRect& rect, const QImage& source );
+
+    void draw( QPainter* painter, const QImage& source, const QPointF& offset, const QRectF& exposedRect, bool smooth );
+    QImage levelImage( const QImage& source, int minExtent );
+
+    static int levelForScale( qreal scale );
+    qint64 byteCount() const;
+
+  private:
+
+    struct Level {
+      int width = 0;
+      int height = 0;
+      int cols = 0;
+      int rows = 0;
+      QVector<QImage> tiles;     // null = not built yet
+    };
+
+    void sync( const QImage& source );
+    const QImage& tile( const QImage& source, int level, int col, int row );
+    static QImage downsample( const QImage& src );
+
+    QVector<Level> m_levels;     // m_levels[L] is mip level L
+    qint64 m_cacheKey = 0;
+    const uchar* m_bits = nullptr;   // pixels the level 0 views point into
+    QSize m_size;
+
+};
@@ -0,0 +1,92 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include <QtTest>
+#include <QPolygonF>
+#include <QtMath>
+
+#include "../util/PolygonSimplify.h"
+
+// -------------------------- TestPolygonSimplify --------------------------
+// Vertex reduction of large lasso outlines, run the benchmarks with
+// "tst_polygonsimplify -tickcounter" or "-callgrind" for stable numbers.
+class TestPolygonSimplify : public QObject
+{
+    Q_OBJECT
+
+private:
+
+    // closed ring with a wobbly outline, the first vertex repeated at the end
+    static QPolygonF wobblyRing( int n )
+    {
+      QPolygonF ring;
+      ring.reserve(n + 1);
+      for ( int i = 0; i < n; ++i ) {
+        const qreal a = 2.0 * M_PI * i / n;
+        const qreal r = 2000.0 + 40.0 * qSin(17.0 * a) + 3.0 * qSin(311.0 * a);
+        ring << QPointF(4000.0 + r * qCos(a), 4000.0 + r * qSin(a));
+      }
+      ring << ring.first();
+      return ring;
+    }
+
+private slots:
+
+    void douglasPeuckerKeepsOutline()
+    {
+      const QPolygonF ring = wobblyRing(100000);
+      const QPolygonF reduced = PolygonSimplify::douglasPeucker(ring, 0.5);
+      QVERIFY(reduced.size() >= 4);
+      QVERIFY(reduced.size() < ring.size());
+      QCOMPARE(reduced.first(), reduced.last());
+      // deterministic, replay gives the same points
+      QCOMPARE(PolygonSimplify::douglasPeucker(ring, 0.5), reduced);
+    }
+
+    void visvalingamHitsTargetCount()
+    {
+      const QPolygonF ring = wobblyRing(100000);
+      const QPolygonF reduced = PolygonSimplify::visvalingam(ring, 0.0, 1000);
+      // target count without the repeated closing vertex
+      QCOMPARE(reduced.size(), 1001);
+      QCOMPARE(reduced.first(), reduced.last());
+    }
+
+    void benchmarkDouglasPeucker100k()
+    {
+      const QPolygonF ring = wobblyRing(100000);
+      QPolygonF reduced;
+      QBENCHMARK {
+        reduced = PolygonSimplify::douglasPeucker(ring, 0.5);
+      }
+      QVERIFY(reduced.size() < ring.size());
+    }
+
+    void benchmarkVisvalingam100k()
+    {
+      const QPolygonF ring = wobblyRing(100000);
+      QPolygonF reduced;
+      QBENCHMARK {
+        reduced = PolygonSimplify::visvalingam(ring, 0.0, 1000);
+      }
+      QVERIFY(reduced.size() < ring.size());
+    }
+
+};
+
+QTEST_MAIN(TestPolygonSimplify)
+#include "tst_polygonsimplify.moc"
@@ -0,0 +1,145 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+
+#include <QtTest>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QFile>
+
+#include "../core/ProjectReader.h"
+
+// -------------------------- TestProjectReader --------------------------
+// ProjectReader replaces QJsonDocument for project loading, both have to
+// agree on every project file and reject the same malformed input.
+class TestProjectReader : public QObject
+{
+    Q_OBJECT
+
+private:
+
+    static QJsonObject modelToJson( const ProjectModel& model, const QJsonObject& reference )
+    {
+      QJsonObject obj = model.header();
+      if ( reference.contains("layers") ) {
+        QJsonArray layers;
+        for ( const ProjectLayer& layer : model.layers() ) {
+          layers.append(layer.toJson());
+        }
+        obj.insert("layers", layers);
+      }
+      if ( reference.contains("undoStack") ) {
+        obj.insert("undoStack", model.undoStack());
+      }
+      return obj;
+    }
+
+    static void addCase( const char* name, const QByteArray& data )
+    {
+      QTest::newRow(name) << data;
+    }
+
+private slots:
+
+    void matchesQJsonDocument_data()
+    {
+      QTest::addColumn<QByteArray>("data");
+      const QStringList files = { "imageeditor_batch1.json", "imageeditor_batch4.json",
+                                  "imageeditor_batch6.json", "imageeditor_batch7.json" };
+      for ( const QString& file : files ) {
+        QFile f(QFINDTESTDATA("../samples/projects/" + file));
+        if ( f.open(QIODevice::ReadOnly) ) {
+          QTest::newRow(qPrintable(file)) << f.readAll();
+        }
+      }
+      addCase("escaped base64", 
+              R"({"layers":[{"id":1,"name":"A","data":"iVBO\/Rw0K+Gg\/\/AA=="},{"data":"iVBORw0KGgo=","id":2}],"undoStack":[]})");
+      addCase("surrogate pairs", 
+              R"({"title":"Bild \ud83d\ude00 \u00e4\u00DF \"q\" \\ \/ \t\n","layers":[{"id":0,"name":"\uD834\uDD1E"}]})");
+      addCase("exponent numbers", 
+              R"({"scale":1.5e3,"tiny":-2.5E-4,"plus":2e+2,"big":12345678901,"neg":-7,"zero":0.0,"undoStack":[{"type":"LassoCut","newLayerId":2,"rect":{"x":1,"y":2,"width":30,"height":40},"opacity":1e0}]})");
+      addCase("nesting and literals", 
+              R"( { "a" : [ true , false , null , [ ] , { } , [ [ 1 ] ] ] , "b" : { "c" : "" } } )");
+    }
+
+    void matchesQJsonDocument()
+    {
+      QFETCH(QByteArray, data);
+      QJsonParseError error;
+      const QJsonDocument doc = QJsonDocument::fromJson(data, &error);
+      QCOMPARE(error.error, QJsonParseError::NoError);
+      ProjectReader reader;
+      ProjectModel model;
+      QVERIFY2(reader.parse(data, model), qPrintable(reader.errorString()));
+      QCOMPARE(modelToJson(model, doc.object()), doc.object());
+    }
+
+    void decodesEscapedData()
+    {
+      ProjectReader reader;
+      ProjectModel model;
+      QVERIFY(reader.parse(R"({"layers":[{"id":1,"data":"iVBO\/Rw0K+Gg\/\/AA=="}]})", model));
+      QCOMPARE(model.layers().size(), 1);
+      QCOMPARE(model.layers().first().decode(), QByteArray::fromBase64("iVBO/Rw0K+Gg//AA=="));
+      QVERIFY(!model.layers().first().json().contains("data"));
+    }
+
+    void indexesCutRects()
+    {
+      ProjectReader reader;
+      ProjectModel model;
+      QVERIFY(reader.parse(R"({"undoStack":[{"type":"LassoCut","newLayerId":2,"rect":{"x":1,"y":2,"width":30,"height":40}}]})", model));
+      QCOMPARE(model.cutRect(2), QRect(1, 2, 30, 40));
+      QVERIFY(model.cutRect(3).isNull());
+    }
+
+    void rejectsMalformedInput_data()
+    {
+      QTest::addColumn<QByteArray>("data");
+      addCase("empty", "");
+      addCase("unterminated object", R"({"a":1)");
+      addCase("unterminated string", R"({"a":"abc})");
+      addCase("missing colon", R"({"a" 1})");
+      addCase("missing comma", R"({"a":1 "b":2})");
+      addCase("trailing comma", R"({"a":1,})");
+      addCase("trailing comma in array", R"({"a":[1,2,]})");
+      addCase("invalid literal", R"({"a":tru})");
+      addCase("invalid escape", R"({"a":"\q"})");
+      addCase("short unicode escape", R"({"a":"\u12"})");
+      addCase("invalid number", R"({"a":1-2})");
+      addCase("lone minus", R"({"a":-})");
+      addCase("unterminated data", R"({"layers":[{"data":"iVBOR)");
+      addCase("data after the object", R"({"a":1} x)");
+    }
+
+    void rejectsMalformedInput()
+    {
+      QFETCH(QByteArray, data);
+      QJsonParseError error;
+      QJsonDocument::fromJson(data, &error);
+      QVERIFY(error.error != QJsonParseError::NoError);
+      ProjectReader reader;
+      ProjectModel model;
+      QVERIFY(!reader.parse(data, model));
+      QVERIFY(!reader.errorString().isEmpty());
+    }
+
+};
+
+QTEST_MAIN(TestProjectReader)
+#include "tst_projectreader.moc"
@@ -0,0 +1,205 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include <QtTest>
+#include <QUndoStack>
+#include <QImage>
+
+#include "../core/TileStore.h"
+#include "../layer/LayerItem.h"
+#include "../undo/PaintStrokeCommand.h"
+#include "../undo/InvertLayerCommand.h"
+#include "../util/BrushEngine.h"
+
+// -------------------------- TestUndoHistory --------------------------
+// Clones of the undo history (rebuilt after sorting or deleting entries)
+// must not copy or share pixel state they did not capture themselves.
+class TestUndoHistory : public QObject
+{
+    Q_OBJECT
+
+private:
+
+    // noise, so the tiles of the layer are not interned into one
+    static QImage noiseImage( int w, int h )
+    {
+      QImage img(w, h, QImage::Format_ARGB32_Premultiplied);
+      quint32 state = 12345u;
+      for ( int y = 0; y < h; ++y ) {
+        QRgb* line = reinterpret_cast<QRgb*>(img.scanLine(y));
+        for ( int x = 0; x < w; ++x ) {
+          state = state * 1664525u + 1013904223u;
+          line[x] = qRgba(state >> 24, state >> 16, state >> 8, 255);
+        }
+      }
+      return img;
+    }
+
+    static QVector<QPoint> stroke( int i )
+    {
+      const int x = ( i * 37 ) % 900 + 20;
+      const int y = ( i * 53 ) % 900 + 20;
+      return { QPoint(x, y), QPoint(x + 30, y + 10), QPoint(x + 60, y + 5) };
+    }
+
+private slots:
+
+    void cloneAllocatesNoImageMemory()
+    {
+      LayerItem layer("Layer", noiseImage(1024, 1024));
+      QUndoStack stack;
+      for ( int i = 0; i < 1000; ++i ) {
+        if ( i % 100 == 99 ) {
+          stack.push(new InvertLayerCommand(&layer, QVector<QRgb>()));
+        } else {
+          stack.push(new PaintStrokeCommand(&layer, stroke(i), QColor(255, 0, 0), 8, 0.8f));
+        }
+      }
+      QCOMPARE(stack.count(), 1000);
+
+      const qint64 bytes = TileStore::instance().bytes();
+      const int tiles = TileStore::instance().tileCount();
+      QList<AbstractCommand*> clones;
+      QList<AbstractCommand*> applied;
+      for ( int i = 0; i < stack.count(); ++i ) {
+        auto* cmd = dynamic_cast<const AbstractCommand*>(stack.command(i));
+        QVERIFY(cmd != nullptr);
+        clones << cmd->clone();
+        applied << cmd->cloneApplied();
+      }
+      QCOMPARE(TileStore::instance().bytes(), bytes);
+      QCOMPARE(TileStore::instance().tileCount(), tiles);
+      // plain clones own no backup until their first redo
+      for ( AbstractCommand* clone : clones ) {
+        for ( const TileSnapshot* snapshot : clone->snapshots() ) {
+          QVERIFY(snapshot == nullptr);
+        }
+      }
+      qDeleteAll(clones);
+      qDeleteAll(applied);
+    }
+
+    void clonedRedoCapturesBackup()
+    {
+      LayerItem layer("Layer", noiseImage(512, 512));
+      const QImage before = layer.image().copy();
+      QUndoStack stack;
+      stack.push(new PaintStrokeCommand(&layer, stroke(1), QColor(0, 0, 255), 12, 1.0f));
+      stack.undo();
+      QCOMPARE(layer.image(), before);
+
+      // replayed on a different state than the one the original captured
+      std::unique_ptr<AbstractCommand> clone(dynamic_cast<const AbstractCommand*>(stack.command(0))->clone());
+      layer.image().fill(Qt::white);
+      const QImage white = layer.image().copy();
+      clone->redo();
+      QVERIFY(layer.image() != white);
+      clone->undo();
+      QCOMPARE(layer.image(), white);
+    }
+
+    // the pixels painted live are the pixels the pushed command paints
+    void liveStrokeMatchesCommand_data()
+    {
+      QTest::addColumn<int>("brushMode");
+      QTest::newRow("dabs") << int(BrushEngine::Dabs);
+      QTest::newRow("capsule") << int(BrushEngine::Capsule);
+    }
+
+    void liveStrokeMatchesCommand()
+    {
+      QFETCH(int, brushMode);
+      LayerItem layer("Layer", noiseImage(256, 256));
+      const QColor color(255, 0, 0, 160);
+      const QVector<QPoint> points = { QPoint(20, 20), QPoint(60, 40), QPoint(62, 41), QPoint(120, 200), QPoint(250, 90) };
+      layer.beginStroke();
+      layer.paintStrokeSegment(points.first(), points.first(), color, 9, 0.4f, brushMode);
+      for ( int i = 1; i < points.size(); ++i ) {
+        layer.paintStrokeSegment(points[i-1], points[i], color, 9, 0.4f, brushMode);
+      }
+      const QImage live = layer.image().copy();
+      layer.endStroke();
+      QUndoStack stack;
+      stack.push(new PaintStrokeCommand(&layer, points, color, 9, 0.4f, brushMode));
+      QCOMPARE(layer.image(), live);
+    }
+
+    // overlapping dabs of a translucent colour accumulate past its alpha like
+    // dabs blended one after another, up to 8 bit rounding
+    void dabsAccumulateLikeSequentialBlending()
+    {
+      QImage stroke(64, 64, QImage::Format_ARGB32_Premultiplied);
+      stroke.fill(Qt::transparent);
+      QImage sequential = stroke.copy();
+      const QColor color(0, 0, 255, 100);
+      const QVector<QPoint> points = { QPoint(30, 32), QPoint(31, 32), QPoint(32, 32), QPoint(33, 32) };
+      BrushEngine::paintStroke(stroke, BrushEngine::Dabs, QVector<QPoint>{ points.first() } + points, color, 6, 1.0f);
+      BrushEngine::dab(sequential, points.first(), color, 6, 1.0f);
+      for ( int i = 1; i < points.size(); ++i ) {
+        BrushEngine::strokeSegment(sequential, points[i-1], points[i], color, 6, 1.0f);
+      }
+      QVERIFY(qAlpha(stroke.pixel(31, 32)) > color.alpha());
+      for ( int y = 0; y < stroke.height(); ++y ) {
+        for ( int x = 0; x < stroke.width(); ++x ) {
+          QVERIFY(qAbs(qAlpha(stroke.pixel(x, y)) - qAlpha(sequential.pixel(x, y))) <= 4);
+        }
+      }
+    }
+
+    // a single click is pushed as a one point stroke and must survive a reload
+    void singlePointStrokeRoundTrip()
+    {
+      LayerItem layer("Layer", noiseImage(128, 128));
+      const QImage before = layer.image().copy();
+      QUndoStack stack;
+      stack.push(new PaintStrokeCommand(&layer, { QPoint(40, 50) }, QColor(0, 255, 0), 6, 0.7f));
+      const QImage painted = layer.image().copy();
+      QVERIFY(painted != before);
+      const QJsonObject obj = dynamic_cast<const PaintStrokeCommand*>(stack.command(0))->toJson();
+      stack.undo();
+      QCOMPARE(layer.image(), before);
+
+      std::unique_ptr<PaintStrokeCommand> loaded(PaintStrokeCommand::fromJson(obj, QList<LayerItem*>{ &layer }));
+      QVERIFY(loaded != nullptr);
+      loaded->redo();
+      QCOMPARE(layer.image(), painted);
+    }
+
+    // an empty table inverts the colours (alpha kept) and reloads as invert
+    void invertLayerRoundTrip()
+    {
+      LayerItem layer("Layer", noiseImage(64, 64).convertToFormat(QImage::Format_ARGB32));
+      const QImage before = layer.image().copy();
+      QUndoStack stack;
+      stack.push(new InvertLayerCommand(&layer, QVector<QRgb>()));
+      const QRgb px = before.pixel(10, 20);
+      QCOMPARE(layer.image().pixel(10, 20), qRgba(255 - qRed(px), 255 - qGreen(px), 255 - qBlue(px), qAlpha(px)));
+      const QImage inverted = layer.image().copy();
+      const QJsonObject obj = dynamic_cast<const InvertLayerCommand*>(stack.command(0))->toJson();
+      stack.undo();
+      QCOMPARE(layer.image(), before);
+
+      std::unique_ptr<InvertLayerCommand> loaded(InvertLayerCommand::fromJson(obj, QList<LayerItem*>{ &layer }));
+      QVERIFY(loaded != nullptr);
+      loaded->redo();
+      QCOMPARE(layer.image(), inverted);
+    }
+
+};
+
+QTEST_MAIN(TestUndoHistory)
+#include "tst_undohistory.moc"
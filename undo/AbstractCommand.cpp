@@ -20,16 +20,14 @@
 // >>>
 #include <QApplication>
 #include <QCoreApplication>
+#include <QGraphicsScene>
+#include <QPainter>
+#include <QPixmap>
 
-// Include of all relevant commands
-#include "CageWarpCommand.h"
-#include "MoveLayerCommand.h"
-#include "PaintStrokeCommand.h"
-#include "InvertLayerCommand.h"
-#include "LassoCutCommand.h"
-#include "TransformLayerCommand.h"
-#include "EditablePolygonCommand.h"
-#include "DeleteUndoEntryCommand.h"
+// Commands register themselves, see CommandRegistry
+#include "CommandRegistry.h"
+#include "../gui/ImageView.h"
+#include "../layer/LayerItem.h"
 
 // >>>
 #include <QDebug>
@@ -50,47 +48,26 @@ AbstractCommand::AbstractCommand( QUndoCommand* parent )
  */
 AbstractCommand* AbstractCommand::fromJson( const QJsonObject& obj, ImageView* view )
 {
-    if ( !obj.contains("type") ) {
-        qWarning() << "AbstractCommand::fromJson(): Missing type.";
-        return nullptr;
+    if ( view == nullptr ) {
+      qWarning() << "AbstractCommand::fromJson(): No view.";
+      return nullptr;
+    }
+    CommandRegistry::Context context;
+    context.undoStack = view->undoStack();
+    for ( QGraphicsItem* item : view->getScene()->items(Qt::DescendingOrder) ) {
+      LayerItem* layer = dynamic_cast<LayerItem*>(item);
+      if ( layer != nullptr ) {
+        context.layers << layer;
+      }
     }
-    const QString type = obj["type"].toString();
-    // ---- Dispatch nach Command-Typ ----
-    // ---- ------------------------- ----
-    qWarning() << "AbstractCommand::fromJson(): Unprocessed command type: " << type;
-    return nullptr;
+    return CommandRegistry::instance().create(obj, context);
 }
 
 AbstractCommand* AbstractCommand::fromJson( const QJsonObject& obj, const QList<LayerItem*>& layers )
 {
-    if ( !obj.contains("type") ) {
-      qWarning() << "AbstractCommand::fromJson(): Missing type.";
-      return nullptr;
-    }
-    const QString type = obj["type"].toString();
-    // ---- Dispatch nach Command-Typ ----
-    if ( type == "MoveLayer" || type == "MoveLayerCommand" )
-        return MoveLayerCommand::fromJson(obj,layers);
-    if ( type == "Paint" )
-        return nullptr;
-    if ( type == "LassoCut" || type == "LassoCutCommand" )
-        return nullptr;
-    if ( type == "PaintStroke" || type == "PaintStrokeCommand" )
-        return PaintStrokeCommand::fromJson(obj,layers);
-    if ( type == "InvertLayer" || type == "InvertLayerCommand" )
-        return InvertLayerCommand::fromJson(obj,layers);
-    if ( type == "CageWarp" ||  type == "CageWarpCommand" )
-        return CageWarpCommand::fromJson(obj,layers);
-    if ( type == "LassoCut" || type == "LassoCutCommand" )
-        return LassoCutCommand::fromJson(obj,layers);
-    if ( type == "TransformLayer" || type == "TransformLayerCommand" )
-    	return TransformLayerCommand::fromJson(obj,layers);
-    if ( type == "EditablePolygonCommand" )
-        return EditablePolygonCommand::fromJson(obj,layers);
-    if ( type == "DeleteUndoEntry" )
-        return DeleteUndoEntryCommand::fromJson(nullptr,obj,layers);
-    qWarning() << "AbstractCommand::fromJson(): Unprocessed command type: " << type;
-    return nullptr;
+    CommandRegistry::Context context;
+    context.layers = layers;
+    return CommandRegistry::instance().create(obj, context);
 }
 
 /**
@@ -26,6 +26,7 @@
 
 class LayerItem;
 class ImageView;
+class TileSnapshot;
 
 /**
  * @brief Basisklasse für alle serialisierbaren Undo/Redo Commands
@@ -61,9 +62,26 @@ class AbstractCommand : public QUndoCommand
     void markDeleted( bool v ) { m_deleted = v; }
     bool isDeleted() const { return m_deleted; }
     void setSilent( bool silent ) { m_silent = silent; }
+    bool isSilent() const { return m_silent; }
     QString timeString() const { return m_timestamp.toString("HH:mm"); }
     void setIcon( const QIcon &icon ) { m_icon = icon; }
     QIcon icon() const { return m_icon; }
+    
+    // ---- Memory ----
+    virtual QList<const TileSnapshot*> snapshots() const { return {}; }
+    
+    // ---- History ----
+    // Copy which keeps the state captured by the applied command, so it can
+    // be pushed silently in its place. nullptr: the command has to run again.
+    virtual AbstractCommand* cloneApplied() const { return nullptr; }
+    // Layer read by redo() besides layer(), e.g. the source of a cut
+    virtual LayerItem* sourceLayer() const { return nullptr; }
+    
+    // ---- Replay ----
+    // Pixel work of the next redo(), done ahead on a worker thread while a
+    // project is replayed. Reads layer images only and touches no scene item,
+    // redo() applies the result on the GUI thread.
+    virtual void prepare() {}
       
     // --- Static Helper ---
     static LayerItem* getLayerItem( const QList<LayerItem*>& layers, int layerId = 0 );
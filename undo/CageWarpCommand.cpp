@@ -18,10 +18,13 @@
 #include <cstdio>
 #include <iostream>
 #include "CageWarpCommand.h"
+#include "CommandRegistry.h"
 
 #include "../gui/MainWindow.h"
 #include "../layer/LayerItem.h"
 #include "../core/Config.h"
+#include "../util/PointPack.h"
+#include "../util/QImageUtils.h"
 
 // ---------------------- Constructor ----------------------
 CageWarpCommand::CageWarpCommand( LayerItem* layer,
@@ -40,7 +43,6 @@ CageWarpCommand::CageWarpCommand( LayerItem* layer,
   {
     m_layerId = m_layer->id();
     captureInitialState();
-    layer->setCageWarpCommand(this);
     setText(QString("Cage Warp Layer %1").arg(m_layerId));
     QByteArray warpLayerSvg = 
       "<svg viewBox='0 0 64 64'>"
@@ -54,22 +56,43 @@ CageWarpCommand::CageWarpCommand( LayerItem* layer,
   }
 }
 
+// Copies share the captured layer state and the cage, no snapshot is taken.
+CageWarpCommand::CageWarpCommand( const CageWarpCommand& other, QUndoCommand* parent )
+    : AbstractCommand(parent),
+      m_layerId(other.m_layerId),
+      m_steps(other.m_steps),
+      m_rows(other.m_rows),
+      m_columns(other.m_columns),
+      m_interpolation(other.m_interpolation),
+      m_rect(other.m_rect),
+      m_newSceneRect(other.m_newSceneRect),
+      m_newPos(other.m_newPos),
+      m_layer(other.m_layer),
+      m_before(other.m_before),
+      m_after(other.m_after),
+      m_state(other.m_state)
+{
+  setText(other.text());
+  setIcon(other.icon());
+}
+
 // ---------------------- Private methods ----------------------
 void CageWarpCommand::captureInitialState()
 {
-    if ( !m_layer || m_initializedState ) return;
-    m_oldPos = m_layer->pos();
-    m_oldSceneRect = m_layer->sceneBoundingRect();
-    m_transform = m_layer->totalTransform();
-    m_originalImage = m_layer->originalImage();
-    m_initializedState = true;
+    if ( !m_layer || m_state ) return;
+    auto state = std::make_shared<State>();
+    state->oldPos = m_layer->pos();
+    state->oldSceneRect = m_layer->sceneBoundingRect();
+    state->transform = m_layer->totalTransform();
+    // the image is captured by redo(), once the warped region is known
+    m_state = std::move(state);
 }
 
 void CageWarpCommand::restoreOldSceneRect()
 {
     if ( !m_layer ) return;
     const QRectF currentSceneRect = m_layer->sceneBoundingRect();
-    const QPointF delta = m_oldSceneRect.topLeft() - currentSceneRect.topLeft();
+    const QPointF delta = m_state->oldSceneRect.topLeft() - currentSceneRect.topLeft();
     const QPointF pos = m_layer->pos() + delta;
     m_layer->setPos(pos);
 }
@@ -86,6 +109,13 @@ void CageWarpCommand::printMessage( bool isUndo )
 }
 
 // ---------------------- Methods ----------------------
+void CageWarpCommand::setImage( const QImage& image )
+{
+  auto state = std::make_shared<State>(*m_state);
+  state->warpedImage = TileSnapshot(image);
+  m_state = std::move(state);
+}
+
 void CageWarpCommand::pushNewWarpStep( const QPointF& pos, const QVector<QPointF>& points )
 {
   qCDebug(logEditor) << "CageWarpCommand::pushNewWarpStep(): pos =" << pos;
@@ -101,13 +131,23 @@ void CageWarpCommand::undo()
 {
   qCDebug(logEditor) << "CageWarpCommand::undo(): m_beforepoints =" << m_before.size();
   {
-    if ( !m_layer ) return;
+    if ( m_silent || !m_layer ) return;
     m_layer->setCagePoints(m_before);
     m_layer->setCageVisible(LayerItem::OperationMode::CageWarp,false,true);
-    m_layer->setTotalTransform(m_transform);
-    m_layer->setOriginalImage(m_originalImage,LayerItem::ImageType::Original);
+    m_layer->setTotalTransform(m_state->transform);
+    const TileSnapshot& backup = m_state->originalImage;
+    if ( backup.rect() == QRect(QPoint(0,0), backup.imageSize()) ) {
+      m_layer->setOriginalImage(backup.image(),LayerItem::ImageType::Original);
+    } else {
+      // only the pixels changed by the warp were kept, the rest comes from the
+      // warp result and not from the layer, painting or transforming it since
+      // rewrote its original image
+      QImage original = m_state->base;
+      backup.restore(original);
+      m_layer->setOriginalImage(original,LayerItem::ImageType::Original);
+    }
     m_layer->setImageTransform(QTransform());
-    m_layer->setPos(m_oldPos);
+    m_layer->setPos(m_state->oldPos);
     restoreOldSceneRect();
     printMessage(true);
   }
@@ -117,22 +157,55 @@ void CageWarpCommand::redo()
 {
   qCDebug(logEditor) << "CageWarpCommand::redo(): step =" << m_steps << ", rows =" << m_rows << ", columns =" << m_columns << ", points =" << m_after.size() << ", rect =" << m_rect;
   {
-    if ( m_silent || !m_layer ) return;
+    if ( !m_layer ) return;
+    // further warp steps go to the command on the stack. Set here and not on
+    // construction, copies of a history rebuild may be discarded unpushed.
+    m_layer->setCageWarpCommand(this);
+    if ( m_silent ) return;
     captureInitialState();
-    m_transform = m_layer->totalTransform();
-    m_originalImage = m_layer->originalImage();
+    // copying the state copies tile pointers only, clones keep the old one
+    auto state = std::make_shared<State>(*m_state);
+    state->transform = m_layer->totalTransform();
+    const QImage before = m_layer->originalImage();
+    const QPointF beforePos = m_layer->pos();
     m_layer->initCage(m_after,m_rect,m_rows,m_columns);
     m_layer->setCageVisible(LayerItem::OperationMode::CageWarp,true);
-    m_warpedImage = m_layer->applyCageWarp("CageWarpCommand");
-    m_layer->setOriginalImage(m_warpedImage,m_steps == 0 ? LayerItem::ImageType::Original : LayerItem::ImageType::Warped);
+    const QImage warpedImage = m_prepared.isNull() ? m_layer->applyCageWarp("CageWarpCommand")
+                                                   : m_layer->applyPreparedCageWarp(m_prepared);
+    m_prepared = QImage();
+    // same bounds: only the warped region is kept, otherwise both whole images
+    QRect changed;
+    if ( warpedImage.size() == before.size() && m_newPos == beforePos ) {
+      changed = QImageUtils::changedRect(before, warpedImage);
+    }
+    if ( changed.isEmpty() ) {
+      state->originalImage = TileSnapshot(before);
+      state->warpedImage = TileSnapshot(warpedImage);
+      state->base = QImage();
+    } else {
+      state->originalImage = TileSnapshot(before, changed);
+      state->warpedImage = TileSnapshot(warpedImage, changed);
+      state->base = warpedImage;
+    }
+    m_state = std::move(state);
+    m_layer->setOriginalImage(warpedImage,m_steps == 0 ? LayerItem::ImageType::Original : LayerItem::ImageType::Warped);
     m_layer->setTotalTransform(QTransform());
-    m_layer->resetPixmap();
+    m_layer->updatePixmap();
     m_layer->setPos(m_newPos);
     m_newSceneRect = m_layer->sceneBoundingRect();
     printMessage();
   }
 }
 
+void CageWarpCommand::prepare()
+{
+  qCDebug(logEditor) << "CageWarpCommand::prepare(): rows =" << m_rows << ", columns =" << m_columns << ", points =" << m_after.size();
+  {
+    if ( m_silent || !m_layer ) return;
+    m_prepared = m_layer->cageWarpImage(m_after,m_rect,m_rows,m_columns);
+  }
+}
+
 // ---------------------- JSON ----------------------
 QJsonObject CageWarpCommand::toJson() const
 {
@@ -143,23 +216,10 @@ QJsonObject CageWarpCommand::toJson() const
     obj["columns"] = m_columns;
     obj["interpolation"] = m_interpolation;
 
-    QJsonArray cageBeforeObj;
-    for (const QPointF& p : m_before) {
-        QJsonObject pointObj;
-        pointObj["x"] = p.x();
-        pointObj["y"] = p.y();
-        cageBeforeObj.append(pointObj);
-    }
-    obj["cagepoints_before"] = cageBeforeObj;
-
-    QJsonArray cageAfterObj;
-    for (const QPointF& p : m_after) {
-        QJsonObject pointObj;
-        pointObj["x"] = p.x();
-        pointObj["y"] = p.y();
-        cageAfterObj.append(pointObj);
-    }
-    obj["cagepoints_after"] = cageAfterObj;
+    // cage points as float32 arrays or {"x","y"} objects
+    const bool packed = EditorStyle::instance().packedHistory();
+    obj["cagepoints_before"] = PointPack::writePointsF(m_before, packed);
+    obj["cagepoints_after"] = PointPack::writePointsF(m_after, packed);
 
     QJsonObject rectObj;
     rectObj["x"] = m_rect.x();
@@ -201,21 +261,8 @@ CageWarpCommand* CageWarpCommand::fromJson( const QJsonObject& obj, const QList<
       return nullptr;
     }
 
-    QVector<QPointF> before;
-    const QJsonArray beforePts = obj["cagepoints_before"].toArray();
-    before.reserve(beforePts.size());
-    for ( const QJsonValue& v : beforePts ) {
-        const QJsonObject po = v.toObject();
-        before.emplace_back(po["x"].toDouble(), po["y"].toDouble());
-    }
-
-    QVector<QPointF> after;
-    const QJsonArray afterPts = obj["cagepoints_after"].toArray();
-    after.reserve(afterPts.size());
-    for (const QJsonValue& v : afterPts) {
-        const QJsonObject po = v.toObject();
-        after.emplace_back(po["x"].toDouble(), po["y"].toDouble());
-    }
+    QVector<QPointF> before = PointPack::readPointsF(obj["cagepoints_before"]);
+    QVector<QPointF> after = PointPack::readPointsF(obj["cagepoints_after"]);
 
     const QJsonObject r = obj["rect"].toObject();
     const QRectF rect(r["x"].toDouble(),
@@ -245,4 +292,14 @@ CageWarpCommand* CageWarpCommand::fromJson( const QJsonObject& obj, const QList<
         return new CageWarpCommand(layer, before, after, rect, newPos, rows, columns, parent);
     }
   }
-}
\ No newline at end of file
+}
+
+// -------------- registry --------------
+static const CommandRegistry::Registrar registrar(
+  { "CageWarp", "CageWarpCommand" },
+  []( const QJsonObject& obj, const CommandRegistry::Context& context ) -> AbstractCommand* {
+    return CageWarpCommand::fromJson(obj, context.layers);
+  },
+  []( const QJsonObject& obj, const CommandRegistry::Context& ) {
+    return CommandRegistry::rectArea(obj);
+  });
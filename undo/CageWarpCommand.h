@@ -23,6 +23,9 @@
 #include <QRectF>
 
 #include "AbstractCommand.h"
+#include "../core/TileStore.h"
+
+#include <memory>
 
 class LayerItem;
 
@@ -36,14 +39,18 @@ class CageWarpCommand : public AbstractCommand
                        int rows, int columns, QUndoCommand* parent = nullptr );
 
     QString type() const override { return "LassoCut"; }
-    AbstractCommand* clone() const override { return new CageWarpCommand(m_layer, m_before, m_after, m_rect, m_newPos, m_rows, m_columns); }
+    AbstractCommand* clone() const override { return new CageWarpCommand(*this, nullptr); }
+    AbstractCommand* cloneApplied() const override { return clone(); }
     
     void undo() override;
     void redo() override;
+    void prepare() override;
     
     LayerItem* layer() const override { return m_layer; }
     int id() const override { return 1002; }
     
+    QList<const TileSnapshot*> snapshots() const override { return { &m_state->originalImage, &m_state->warpedImage }; }
+    
     QJsonObject toJson() const override;
     static CageWarpCommand* fromJson( const QJsonObject& obj, const QList<LayerItem*>& layers, QUndoCommand* parent = nullptr );
     
@@ -53,12 +60,26 @@ class CageWarpCommand : public AbstractCommand
       m_columns = n;
     }
     
-    void setImage( const QImage& image ) { m_warpedImage = image; }
+    void setImage( const QImage& image );
     void save_image() {
-      m_warpedImage.save("/tmp/imageeditor_backuppic.png");
+      m_state->warpedImage.image().save("/tmp/imageeditor_backuppic.png");
     }
     
   private:
+
+    // layer state around the warp, never modified once published but replaced
+    // as a whole, clones share it instead of copying snapshots
+    struct State {
+      QPointF oldPos;               // old topLeft position
+      QRectF oldSceneRect;
+      QTransform transform;         // transform operations before cage warp
+      TileSnapshot originalImage;   // original image, only the warped region if the bounds stay
+      TileSnapshot warpedImage;     // warped image, same region
+      QImage base;                  // base of a region backup: the warped image as handed to the layer,
+                                    // shares its pixels until the layer rewrites its original image
+    };
+
+    explicit CageWarpCommand( const CageWarpCommand& other, QUndoCommand* parent );
   
     void printMessage( bool isUndo = false );
     void captureInitialState();
@@ -75,11 +96,8 @@ class CageWarpCommand : public AbstractCommand
     QString m_interpolation = "trlinear";
     
     QRectF m_rect;
-    QRectF m_oldSceneRect;
     QRectF m_newSceneRect;
-    bool m_initializedState = false;
     
-    QPointF m_oldPos;           // old topLeft position
     QPointF m_newPos;           // new topLeft position
     
     LayerItem* m_layer;
@@ -87,9 +105,8 @@ class CageWarpCommand : public AbstractCommand
     QVector<QPointF> m_before;  // Startposition der Cage-Punkte
     QVector<QPointF> m_after;   // Endposition der Cage-Punkte
     
-    QTransform m_transform;     // transform operations before cage warp
+    std::shared_ptr<const State> m_state;
     
-    QImage m_originalImage;     // copy of the original image
-    QImage m_warpedImage;       // warped image
+    QImage m_prepared;          // warped by prepare(), consumed by the next redo()
     
 };
\ No newline at end of file
@@ -0,0 +1,120 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "CommandRegistry.h"
+#include "AbstractCommand.h"
+#include "../layer/LayerItem.h"
+
+#include <QDebug>
+#include <QJsonValue>
+
+#include <algorithm>
+
+// -------------------------- Registrar --------------------------
+CommandRegistry::Registrar::Registrar( const QStringList& names, Factory factory, CostHook cost, LayerHook layers )
+{
+  CommandRegistry::instance().add(names, std::move(factory), std::move(cost), std::move(layers));
+}
+
+// -------------------------- CommandRegistry --------------------------
+CommandRegistry& CommandRegistry::instance()
+{
+  static CommandRegistry registry;
+  return registry;
+}
+
+int CommandRegistry::add( const QStringList& names, Factory factory, CostHook cost, LayerHook layers )
+{
+  if ( names.isEmpty() || !factory ) {
+    qWarning() << "CommandRegistry::add(): Command without name or factory.";
+    return -1;
+  }
+  Entry entry;
+  entry.typeId = m_entries.size();
+  entry.name = names.first();
+  entry.factory = std::move(factory);
+  entry.cost = std::move(cost);
+  entry.layers = std::move(layers);
+  for ( const QString& name : names ) {
+    if ( m_ids.contains(name) ) {
+      qWarning() << "CommandRegistry::add(): Type" << name << "is already registered.";
+      continue;
+    }
+    m_ids.insert(name, entry.typeId);
+  }
+  m_entries.append(entry);
+  return entry.typeId;
+}
+
+const CommandRegistry::Entry* CommandRegistry::entry( int typeId ) const
+{
+  if ( typeId < 0 || typeId >= m_entries.size() )
+    return nullptr;
+  return &m_entries[typeId];
+}
+
+AbstractCommand* CommandRegistry::create( const QJsonObject& obj, const Context& context ) const
+{
+  if ( !obj.contains("type") ) {
+    qWarning() << "CommandRegistry::create(): Missing type.";
+    return nullptr;
+  }
+  const Entry* e = entry(obj);
+  if ( e == nullptr ) {
+    qWarning() << "CommandRegistry::create(): Unregistered command type:" << obj.value("type").toString();
+    return nullptr;
+  }
+  return e->factory(obj, context);
+}
+
+qint64 CommandRegistry::cost( const QJsonObject& obj, const Context& context ) const
+{
+  const Entry* e = entry(obj);
+  return ( e != nullptr && e->cost ) ? std::max<qint64>(1, e->cost(obj, context)) : 1;
+}
+
+QList<int> CommandRegistry::layerIds( const QJsonObject& obj ) const
+{
+  const Entry* e = entry(obj);
+  if ( e == nullptr )
+    return {};
+  QList<int> ids = e->layers ? e->layers(obj) : layerIdOf(obj);
+  ids.removeIf([](int id){ return id < 0; });
+  return ids;
+}
+
+// ---- Common hooks ----
+QList<int> CommandRegistry::layerIdOf( const QJsonObject& obj )
+{
+  const int id = obj.value("layerId").toInt(-1);
+  return id >= 0 ? QList<int>{ id } : QList<int>{};
+}
+
+qint64 CommandRegistry::rectArea( const QJsonObject& obj, const char* key )
+{
+  const QJsonObject r = obj.value(key).toObject();
+  return qint64(r.value("width").toDouble()) * qint64(r.value("height").toDouble());
+}
+
+qint64 CommandRegistry::layerArea( const QJsonObject& obj, const Context& context )
+{
+  LayerItem* layer = AbstractCommand::getLayerItem(context.layers, obj.value("layerId").toInt(-1));
+  if ( layer == nullptr )
+    return 1;
+  const QImage& image = layer->image();
+  return qint64(image.width()) * image.height();
+}
@@ -0,0 +1,95 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <functional>
+
+class AbstractCommand;
+class EditablePolygon;
+class LayerItem;
+class QUndoStack;
+
+// -------------------------- CommandRegistry --------------------------
+// Process wide table of the serialisable commands. Every command registers
+// the JSON type names it is stored under (aliases share one interned id),
+// a factory and two hooks which work on the JSON alone, so a loader can plan
+// a replay before any command exists:
+//  - cost:   rough number of pixels touched by redo(), 1 for bookkeeping
+//  - layers: ids of the layers read or written by the command
+class CommandRegistry {
+
+public:
+
+    // Everything a factory may need, loaders fill in what they have
+    struct Context {
+      QList<LayerItem*> layers;
+      QUndoStack* undoStack = nullptr;      // stack the command is pushed to
+      EditablePolygon* polygon = nullptr;   // owner of polygon edit commands
+    };
+
+    using Factory = std::function<AbstractCommand*( const QJsonObject& obj, const Context& context )>;
+    using CostHook = std::function<qint64( const QJsonObject& obj, const Context& context )>;
+    using LayerHook = std::function<QList<int>( const QJsonObject& obj )>;
+
+    struct Entry {
+      int typeId = -1;
+      QString name;                         // first registered name
+      Factory factory;
+      CostHook cost;
+      LayerHook layers;
+    };
+
+    // Registers a command at static initialisation time:
+    //   static const CommandRegistry::Registrar registrar({"MoveLayer","MoveLayerCommand"}, ...);
+    struct Registrar {
+      Registrar( const QStringList& names, Factory factory, CostHook cost = nullptr, LayerHook layers = nullptr );
+    };
+
+    static CommandRegistry& instance();
+
+    int add( const QStringList& names, Factory factory, CostHook cost = nullptr, LayerHook layers = nullptr );
+
+    int typeId( const QString& name ) const { return m_ids.value(name, -1); }
+    int typeId( const QJsonObject& obj ) const { return typeId(obj.value("type").toString()); }
+    const Entry* entry( int typeId ) const;
+    const Entry* entry( const QJsonObject& obj ) const { return entry(typeId(obj)); }
+
+    AbstractCommand* create( const QJsonObject& obj, const Context& context ) const;
+    qint64 cost( const QJsonObject& obj, const Context& context ) const;
+    QList<int> layerIds( const QJsonObject& obj ) const;
+
+    // ---- Common hooks ----
+    static QList<int> layerIdOf( const QJsonObject& obj );
+    static qint64 rectArea( const QJsonObject& obj, const char* key = "rect" );
+    static qint64 layerArea( const QJsonObject& obj, const Context& context );
+
+private:
+
+    CommandRegistry() = default;
+
+    QHash<QString, int> m_ids;              // type name (and aliases) -> id
+    QVector<Entry> m_entries;               // indexed by id
+
+};
@@ -16,6 +16,7 @@
 */
 
 #include "DeleteLayerCommand.h"
+#include "CommandRegistry.h"
 #include "../core/Config.h"
 
 #include <QPainter>
@@ -89,3 +90,9 @@ DeleteLayerCommand* DeleteLayerCommand::fromJson( const QJsonObject& obj, const
                   QPointF(obj["posX"].toDouble(),obj["posY"].toDouble()),obj["layerId"].toInt());
 }
 
+// -------------- registry --------------
+static const CommandRegistry::Registrar registrar(
+  { "DeleteLayer", "DeleteLayerCommand" },
+  []( const QJsonObject& obj, const CommandRegistry::Context& context ) -> AbstractCommand* {
+    return DeleteLayerCommand::fromJson(obj, context.layers);
+  });
@@ -16,6 +16,7 @@
 */
 
 #include "DeleteUndoEntryCommand.h"
+#include "CommandRegistry.h"
 
 #include "../gui/MainWindow.h"
 #include "../core/Config.h"
@@ -107,3 +108,10 @@ DeleteUndoEntryCommand* DeleteUndoEntryCommand::fromJson( QUndoStack* stack, con
     return new DeleteUndoEntryCommand(stack,name,layerId);
   }
 }
+
+// -------------- registry --------------
+static const CommandRegistry::Registrar registrar(
+  { "DeleteUndoEntry", "DeleteUndoEntryCommand" },
+  []( const QJsonObject& obj, const CommandRegistry::Context& context ) -> AbstractCommand* {
+    return DeleteUndoEntryCommand::fromJson(context.undoStack, obj, context.layers);
+  });
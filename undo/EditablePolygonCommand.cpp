@@ -16,6 +16,7 @@
 */
 
 #include "EditablePolygonCommand.h"
+#include "CommandRegistry.h"
 
 #include "../gui/MainWindow.h"
 #include "../undo/PolygonMovePointCommand.h"
@@ -37,7 +38,10 @@ EditablePolygonCommand::EditablePolygonCommand( LayerItem *layer, QGraphicsScene
     setText(QString("Editable %1").arg(name));
     m_model = new EditablePolygon("EditablePolygonCommand::EditablePolygonCommand()",m_name);
     m_model->setPolygon(m_polygon);
-    m_item = new EditablePolygonItem(m_model,m_layer);
+    // without a scene (batch replay) only the model is kept
+    if ( m_scene != nullptr ) {
+      m_item = new EditablePolygonItem(m_model,m_layer);
+    }
     QByteArray polygonSvg = 
       "<svg viewBox='0 0 64 64'>"
       "<path d='M15 15 L50 20 L45 50 L10 40 Z' "
@@ -115,7 +119,9 @@ void EditablePolygonCommand::redo()
     if ( !m_model ) {
       m_model = new EditablePolygon("EditablePolygonCommand::redo()",m_name);
       m_model->setPolygon(m_polygon);
-      m_item = new EditablePolygonItem(m_model,m_layer);
+      if ( m_scene != nullptr ) {
+        m_item = new EditablePolygonItem(m_model,m_layer);
+      }
     }
     m_model->setVisible(true);
     if ( m_item != nullptr ) { 
@@ -189,3 +195,15 @@ EditablePolygonCommand* EditablePolygonCommand::fromJson( const QJsonObject& obj
     return editablePolygonCommand;
   }
 }
+
+// -------------- registry --------------
+static const CommandRegistry::Registrar registrar(
+  { "EditablePolygon", "EditablePolygonCommand" },
+  []( const QJsonObject& obj, const CommandRegistry::Context& context ) -> AbstractCommand* {
+    return EditablePolygonCommand::fromJson(obj, context.layers);
+  },
+  []( const QJsonObject& obj, const CommandRegistry::Context& ) {
+    return qint64(obj.value("points").toArray().size());
+  },
+  // the polygon is an overlay, no layer pixels are touched
+  []( const QJsonObject& ) { return QList<int>(); });
@@ -30,6 +30,7 @@ class EditablePolygonCommand : public AbstractCommand
 
   public:
 
+    // scene == nullptr: headless (batch replay), the polygon model is kept without a view item
     EditablePolygonCommand( LayerItem* layer, QGraphicsScene* scene, const QPolygonF& polygon, const QString& name, QUndoCommand* parent = nullptr );
 
     AbstractCommand* clone() const override { 
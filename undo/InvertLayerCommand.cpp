@@ -16,92 +16,58 @@
 */
 
 #include "InvertLayerCommand.h"
+#include "CommandRegistry.h"
 #include "../layer/LayerItem.h"
+#include "../util/LutEngine.h"
 
-#include <iostream>
-
-// ------------------------------- helper ------------------------------- 
-static void invertImage_old( QImage& img )
-{
-    // std::cout << "InvertLayerCommand::invertImage(): Processing..." << std::endl;
-    if ( img.format() != QImage::Format_ARGB32 )
-        img = img.convertToFormat(QImage::Format_ARGB32);
-    const int w = img.width();
-    const int h = img.height();
-    for (int y = 0; y < h; ++y) {
-        QRgb* line = reinterpret_cast<QRgb*>(img.scanLine(y));
-        for (int x = 0; x < w; ++x) {
-            QRgb px = line[x];
-            line[x] = qRgba(
-                255 - qRed(px),
-                255 - qGreen(px),
-                255 - qBlue(px),
-                qAlpha(px)
-            );
-        }
-    }
-}
+#include <QJsonArray>
 
-static void setImageLUT_old( QImage& img, const QVector<QRgb>& lut )
-{
-    // std::cout << "InvertLayerCommand::invertImage(): Processing..." << std::endl;
-    if ( img.format() != QImage::Format_ARGB32 )
-        img = img.convertToFormat(QImage::Format_ARGB32);
-    for (int y = 0; y < img.height(); ++y) {
-        QRgb* line = reinterpret_cast<QRgb*>(img.scanLine(y));
-        for (int x = 0; x < img.width(); ++x) {
-            QRgb src = line[x];
-            int alpha = qAlpha(src);          // Alpha unverändert
-            int r     = qRed(src);
-            int g     = qGreen(src);
-            int b     = qBlue(src);
-            // LUT über Grauwert oder individuelle Map
-            int gray = qGray(src);            // Index für LUT
-            QRgb mapped = (gray < lut.size()) ? lut[gray] : qRgb(r,g,b);
-            // Zusammensetzen mit Original-Alpha
-            line[x] = qRgba(qRed(mapped), qGreen(mapped), qBlue(mapped), alpha);
-        }
-    }
-}
+#include <iostream>
 
 // -------------------------------  ------------------------------- 
 InvertLayerCommand::InvertLayerCommand( LayerItem* layer, const QVector<QRgb>& lut, int idx, QUndoCommand* parent )
     : AbstractCommand(parent)
     , m_layer(layer)
-    , m_backup(layer->image())
+    , m_backup(std::make_shared<const TileSnapshot>(layer->image()))
     , m_layerId(idx)
     , m_lut(lut)
+    , m_invert(lut.isEmpty())
 {
-    setText("Changed Layer with LUT");
+    setText(m_invert ? "Inverted Layer" : "Changed Layer with LUT");
+}
+
+// only copies replacing the applied command share its backup
+InvertLayerCommand::InvertLayerCommand( const InvertLayerCommand& other, bool shareBackup, QUndoCommand* parent )
+    : AbstractCommand(parent)
+    , m_layerId(other.m_layerId)
+    , m_layer(other.m_layer)
+    , m_backup(shareBackup ? other.m_backup : nullptr)
+    , m_lut(other.m_lut)
+    , m_invert(other.m_invert)
+{
+    setText(other.text());
 }
 
 void InvertLayerCommand::undo()
 {
-    if ( !m_layer ) return;
-    m_layer->image() = m_backup;
+    if ( m_silent || !m_layer || !m_backup ) return;
+    m_layer->image() = m_backup->image();
     m_layer->updatePixmap();
 }
 
 void InvertLayerCommand::redo()
 {   
     if ( m_silent || !m_layer ) return;
-    QImage& img = m_layer->image();
-    const QImage& original = m_layer->originalImage(); // das Ausgangsbild
-    if ( original.format() != QImage::Format_ARGB32 ) {
-     qWarning() << "InvertLayerCommand(): Only supports ARGB32 format!";
-     return;
+    if ( !m_backup ) {
+      m_backup = std::make_shared<const TileSnapshot>(m_layer->image());
     }
-    img = original.copy();  // Basis für die LUT-Anwendung
-    for ( int y = 0; y < img.height(); ++y ) {
-        const QRgb* srcLine = reinterpret_cast<const QRgb*>(original.constScanLine(y));
-        QRgb* dstLine = reinterpret_cast<QRgb*>(img.scanLine(y));
-        for (int x = 0; x < img.width(); ++x) {
-            QRgb src = srcLine[x];
-            int alpha = qAlpha(src);
-            int gray = qGray(src); // Index für LUT
-            QRgb mapped = (gray < m_lut.size()) ? m_lut[gray] : src;
-            dstLine[x] = qRgba(qRed(mapped), qGreen(mapped), qBlue(mapped), alpha);
-        }
+    QImage& img = m_layer->image();
+    // shares the original until the table is applied in place (one detach)
+    img = m_layer->originalImage();
+    if ( m_invert ) {
+      LutEngine::invert(img);
+    } else {
+      LutEngine::apply(img, LutEngine::fromColorTable(m_lut));
     }
     m_layer->updatePixmap();
 }
@@ -109,9 +75,20 @@ void InvertLayerCommand::redo()
 // -------------- history related methods  -------------- 
 QJsonObject InvertLayerCommand::toJson() const
 {
-   return {
-     {"type", type()}
+   QJsonObject obj {
+     {"type", type()},
+     {"layerId", m_layer ? m_layer->id() : -1}
    };
+   if ( m_invert ) {
+     obj["invert"] = true;
+   } else {
+     QJsonArray lut;
+     for ( QRgb rgb : m_lut ) {
+       lut.append(qint64(rgb));
+     }
+     obj["lut"] = lut;
+   }
+   return obj;
 }
 
 InvertLayerCommand* InvertLayerCommand::fromJson( const QJsonObject& obj, const QList<LayerItem*>& layers )
@@ -130,5 +107,20 @@ InvertLayerCommand* InvertLayerCommand::fromJson( const QJsonObject& obj, const
       return nullptr;
     }
     QVector<QRgb> lut;
-    return new InvertLayerCommand(layer,lut);
-}
\ No newline at end of file
+    const QJsonArray table = obj["lut"].toArray();
+    for ( const QJsonValue& v : table ) {
+      lut.append(QRgb(v.toDouble()));
+    }
+    auto* cmd = new InvertLayerCommand(layer,lut);
+    // older projects saved neither table nor flag, they replay as before (unchanged)
+    cmd->m_invert = obj["invert"].toBool(false);
+    return cmd;
+}
+
+// -------------- registry --------------
+static const CommandRegistry::Registrar registrar(
+  { "InvertLayer", "InvertLayerCommand" },
+  []( const QJsonObject& obj, const CommandRegistry::Context& context ) -> AbstractCommand* {
+    return InvertLayerCommand::fromJson(obj, context.layers);
+  },
+  CommandRegistry::layerArea);
@@ -23,17 +23,22 @@
 #include <QRgb>
 
 #include "AbstractCommand.h"
+#include "../core/TileStore.h"
+
+#include <memory>
 
 class LayerItem;
 
 class InvertLayerCommand : public AbstractCommand
 {
 public:
+    // an empty table inverts the colour channels
     explicit InvertLayerCommand( LayerItem* layer, const QVector<QRgb>& lut, int idx = -1,
                                      QUndoCommand* parent = nullptr );
 
     QString type() const override { return "InvertLayer"; }
-    AbstractCommand* clone() const override { return new InvertLayerCommand(m_layer, m_lut, m_layerId); }
+    AbstractCommand* clone() const override { return new InvertLayerCommand(*this, false, nullptr); }
+    AbstractCommand* cloneApplied() const override { return new InvertLayerCommand(*this, true, nullptr); }
     
     void undo() override;
     void redo() override;
@@ -41,12 +46,17 @@ public:
     LayerItem* layer() const override { return m_layer; }
     int id() const override { return 1003; }
     
+    QList<const TileSnapshot*> snapshots() const override { return { m_backup.get() }; }
+    
     QJsonObject toJson() const override;
     static InvertLayerCommand* fromJson( const QJsonObject& obj, const QList<LayerItem*>& layers );
 
 private:
+    InvertLayerCommand( const InvertLayerCommand& other, bool shareBackup, QUndoCommand* parent );
+
     int m_layerId;
     LayerItem* m_layer;
-    QImage     m_backup;
+    std::shared_ptr<const TileSnapshot> m_backup;   // shared by applied clones
     QVector<QRgb> m_lut;
+    bool m_invert = false;
 };
\ No newline at end of file
@@ -16,6 +16,7 @@
 */
 
 #include "LassoCutCommand.h"
+#include "CommandRegistry.h"
 #include "EditablePolygonCommand.h"
 #include "../gui/MainWindow.h"
 
@@ -102,17 +103,8 @@ void LassoCutCommand::redo()
   qCDebug(logEditor) << "LassoCutCommand::redo(): Processing...";
   {
     if ( m_silent ) return;
-    QColor color = Config::isWhiteBackgroundImage ? Qt::white : Qt::black;
-    QImage tempImage = m_originalLayer->image();
-    for ( int y = 0; y < m_backup.height(); ++y ) {
-      for ( int x = 0; x < m_backup.width(); ++x ) {
-        QColor maskPixel = m_backup.pixelColor(x, y);
-        if ( maskPixel.alpha() > 128 ) {
-          tempImage.setPixelColor(m_bounds.x()+x,m_bounds.y()+y,color); // hier wird im orignal image ge-cuttet
-        }
-      }
-    }
-    m_originalLayer->setImage(tempImage);
+    m_originalLayer->setImage(m_prepared.isNull() ? cutOriginalImage() : m_prepared);
+    m_prepared = QImage();
     if ( !m_newLayer->scene() && m_originalLayer->scene() ) {
       m_originalLayer->scene()->addItem(m_newLayer);
     }
@@ -132,6 +124,70 @@ void LassoCutCommand::redo()
   }
 }
 
+void LassoCutCommand::prepare()
+{
+  qCDebug(logEditor) << "LassoCutCommand::prepare(): bounds =" << m_bounds;
+  {
+    if ( m_silent || !m_originalLayer ) return;
+    m_prepared = cutOriginalImage();
+  }
+}
+
+// ---------------------- Cut helpers ----------------------
+// the source layer with the cut area filled by the background color, reads the layer only
+QImage LassoCutCommand::cutOriginalImage() const
+{
+  QColor color = Config::isWhiteBackgroundImage ? Qt::white : Qt::black;
+  QImage tempImage = m_originalLayer->image();
+  for ( int y = 0; y < m_backup.height(); ++y ) {
+    for ( int x = 0; x < m_backup.width(); ++x ) {
+      QColor maskPixel = m_backup.pixelColor(x, y);
+      if ( maskPixel.alpha() > 128 ) {
+        tempImage.setPixelColor(m_bounds.x()+x,m_bounds.y()+y,color); // hier wird im orignal image ge-cuttet
+      }
+    }
+  }
+  return tempImage;
+}
+
+QImage LassoCutCommand::polygonMask( const QPolygonF& polygon, const QRect& bounds )
+{
+  QColor backgroundColor = Config::isWhiteBackgroundImage ? Qt::white : Qt::black;
+  QImage mask(bounds.size(), QImage::Format_Alpha8);
+  mask.fill(0);
+  QPainter pm(&mask);
+   pm.setRenderHint(QPainter::Antialiasing);
+   pm.setBrush(backgroundColor);
+   pm.setPen(Qt::NoPen);
+   // Polygon relativ zur Bounding-Box verschieben
+   QPolygonF relativePoly = polygon;
+   for ( int i=0; i<relativePoly.size(); ++i )
+    relativePoly[i] -= bounds.topLeft();
+   pm.drawPolygon(relativePoly);
+  pm.end();
+  return mask;
+}
+
+QImage LassoCutCommand::cutImage( const QImage& src, const QImage& mask, const QRect& bounds )
+{
+  QColor backgroundColor = Config::isWhiteBackgroundImage ? Qt::white : Qt::black;
+  QImage cut(bounds.size(), QImage::Format_ARGB32_Premultiplied);
+  cut.fill(Qt::transparent);
+  for ( int y=0; y<bounds.height(); ++y ) {
+    const uchar* m = mask.constScanLine(y);
+    unsigned int ypos = bounds.top() + y;
+    for ( int x=0; x<bounds.width(); ++x ) {
+      QPoint imgPos(bounds.left() + x, ypos);
+      QColor c = src.pixelColor(imgPos);
+      if ( c != backgroundColor && m[x] > 0 ) {
+       // results in border artefacts: c.setAlpha(m[x]); cut.setPixelColor(x,y,c);
+       cut.setPixelColor(x,y,c);
+      }
+    }
+  }
+  return cut;
+}
+
 // ---------------------- JSON ----------------------
 QJsonObject LassoCutCommand::toJson() const
 {
@@ -145,6 +201,7 @@ QJsonObject LassoCutCommand::toJson() const
    rectObj.insert("width", m_bounds.width());
    rectObj.insert("height", m_bounds.height());
    obj["rect"] = rectObj;
+   obj["featherRadius"] = m_featherRadius;
    obj["type"] = "LassoCutCommand";
    return obj;
 }
@@ -184,6 +241,21 @@ LassoCutCommand* LassoCutCommand::fromJson( const QJsonObject& obj, const QList<
     QJsonObject r = obj["rect"].toObject();
     QRect rect(r["x"].toInt(),r["y"].toInt(),r["width"].toInt(),r["height"].toInt());
     // >>>
-    return new LassoCutCommand(originalLayer,newLayer,rect,newLayer->originalImage(),newLayerId,name);
+    LassoCutCommand* cmd = new LassoCutCommand(originalLayer,newLayer,rect,newLayer->originalImage(),newLayerId,name);
+    cmd->setFeatherRadius(obj["featherRadius"].toInt(0));
+    return cmd;
   }
-}
\ No newline at end of file
+}
+
+// -------------- registry --------------
+static const CommandRegistry::Registrar registrar(
+  { "LassoCut", "LassoCutCommand" },
+  []( const QJsonObject& obj, const CommandRegistry::Context& context ) -> AbstractCommand* {
+    return LassoCutCommand::fromJson(obj, context.layers);
+  },
+  []( const QJsonObject& obj, const CommandRegistry::Context& ) {
+    return CommandRegistry::rectArea(obj);
+  },
+  []( const QJsonObject& obj ) {
+    return QList<int>{ obj.value("originalLayerId").toInt(-1), obj.value("newLayerId").toInt(-1) };
+  });
@@ -22,6 +22,7 @@
 #include <QUndoCommand>
 #include <QImage>
 #include <QPainter>
+#include <QPolygonF>
 #include <iostream>
 
 #include "AbstractCommand.h"
@@ -39,12 +40,18 @@ class LassoCutCommand : public AbstractCommand
                          const QImage& originalBackup, const int index, const QString& name, QUndoCommand* parent=nullptr );
     
     QString type() const override { return "LassoCut"; }
-    AbstractCommand* clone() const override { return new LassoCutCommand(m_originalLayer, m_newLayer, m_bounds, m_backup, m_newLayerId, m_name); }
+    AbstractCommand* clone() const override {
+      auto* cmd = new LassoCutCommand(m_originalLayer, m_newLayer, m_bounds, m_backup, m_newLayerId, m_name);
+      cmd->m_featherRadius = m_featherRadius;
+      return cmd;
+    }
     
     void undo() override;
     void redo() override;
+    void prepare() override;
     
     LayerItem* layer() const override { return m_newLayer; }
+    LayerItem* sourceLayer() const override { return m_originalLayer; }
     
     int id() const override { return 1001; }
     void printMessage( bool isUndo=false );
@@ -52,8 +59,14 @@ class LassoCutCommand : public AbstractCommand
     QJsonObject toJson() const override;
     static LassoCutCommand* fromJson( const QJsonObject& obj, const QList<LayerItem*>& layers, QUndoCommand* parent = nullptr );
     
+    // lasso mask and cut layer image of a polygon, shared by ImageView and the batch replay
+    static QImage polygonMask( const QPolygonF& polygon, const QRect& bounds );
+    static QImage cutImage( const QImage& src, const QImage& mask, const QRect& bounds );
+    
     const QRect& rect() const { return m_bounds; }
     int layerId() const { return m_newLayerId; }
+    int featherRadius() const { return m_featherRadius; }
+    void setFeatherRadius( int radius ) { m_featherRadius = radius; }
     void setController( QUndoCommand *undoCommand ) { m_controller = undoCommand; };
     
     void save_backup() {
@@ -62,8 +75,11 @@ class LassoCutCommand : public AbstractCommand
 
   private:
 
+    QImage cutOriginalImage() const;
+
     int m_originalLayerId = -1;
     int m_newLayerId = -1;
+    int m_featherRadius = 0;    // blur radius of the lasso mask, 0 = hard edge
     
     QUndoCommand* m_controller = nullptr;
     LayerItem* m_originalLayer = nullptr;
@@ -72,5 +88,6 @@ class LassoCutCommand : public AbstractCommand
     QString m_name;
     QRect m_bounds;
     QImage m_backup;
+    QImage m_prepared;          // cut by prepare(), consumed by the next redo()
     
 };
\ No newline at end of file
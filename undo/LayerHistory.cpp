@@ -0,0 +1,116 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#include "LayerHistory.h"
+#include "AbstractCommand.h"
+#include "EditablePolygonCommand.h"
+#include "../layer/LayerItem.h"
+
+#include <QUndoStack>
+
+LayerHistory::LayerHistory( const QUndoStack* stack, int count )
+{
+  count = qBound(0, count, stack != nullptr ? stack->count() : 0);
+  m_layerOf.resize(count);
+  m_sourceOf.resize(count);
+  for ( int i = 0; i < count; ++i ) {
+    const QUndoCommand* cmd = stack->command(i);
+    m_layerOf[i] = layerIdOf(cmd);
+    m_sourceOf[i] = sourceLayerIdOf(cmd);
+    if ( m_layerOf[i] >= 0 ) {
+      m_chains[m_layerOf[i]].append(i);
+    }
+  }
+}
+
+int LayerHistory::layerIdOf( const QUndoCommand* cmd )
+{
+  auto* command = dynamic_cast<const AbstractCommand*>(cmd);
+  if ( !command || dynamic_cast<const EditablePolygonCommand*>(command) != nullptr )
+    return -1;
+  return command->layer() != nullptr ? command->layer()->id() : -1;
+}
+
+int LayerHistory::sourceLayerIdOf( const QUndoCommand* cmd )
+{
+  auto* command = dynamic_cast<const AbstractCommand*>(cmd);
+  if ( !command || !command->sourceLayer() )
+    return -1;
+  return command->sourceLayer()->id();
+}
+
+QSet<int> LayerHistory::affectedLayers( const QList<int>& order, QSet<int> affected ) const
+{
+  // a layer whose chain is not the same sequence of commands is re-executed
+  QHash<int, QList<int>> chains;
+  QSet<int> kept;
+  for ( int index : order ) {
+    if ( index < 0 || index >= count() ) continue;
+    kept.insert(index);
+    if ( m_layerOf[index] >= 0 ) chains[m_layerOf[index]].append(index);
+  }
+  for ( auto it = m_chains.cbegin(); it != m_chains.cend(); ++it ) {
+    if ( chains.value(it.key()) != it.value() ) affected.insert(it.key());
+  }
+  // A cut reads its source layer at its position in the source chain and
+  // takes the region out of it. If that position changes, or the cut is
+  // removed, both layers change.
+  QList<int> cuts;
+  for ( int i = 0; i < count(); ++i ) {
+    if ( m_sourceOf[i] < 0 ) continue;
+    if ( !kept.contains(i) ) {
+      affected.insert(m_sourceOf[i]);
+      if ( m_layerOf[i] >= 0 ) affected.insert(m_layerOf[i]);
+    } else {
+      cuts.append(i);
+    }
+  }
+  QHash<int, int> newPosition;
+  for ( int p = 0; p < order.size(); ++p ) {
+    newPosition.insert(order[p], p);
+  }
+  for ( int cut : cuts ) {
+    const QList<int> source = m_chains.value(m_sourceOf[cut]);
+    int before = 0;
+    int beforeNew = 0;
+    for ( int index : source ) {
+      if ( index < cut ) ++before;
+      if ( newPosition.contains(index) && newPosition.value(index) < newPosition.value(cut) ) ++beforeNew;
+    }
+    if ( before != beforeNew ) {
+      affected.insert(m_sourceOf[cut]);
+      if ( m_layerOf[cut] >= 0 ) affected.insert(m_layerOf[cut]);
+    }
+  }
+  // re-executing one side of a cut re-executes the other one
+  bool grown = true;
+  while ( grown ) {
+    grown = false;
+    for ( int cut : cuts ) {
+      const int source = m_sourceOf[cut];
+      const int target = m_layerOf[cut];
+      const bool sourceAffected = affected.contains(source);
+      const bool targetAffected = target >= 0 && affected.contains(target);
+      if ( sourceAffected != targetAffected && target >= 0 ) {
+        affected.insert(source);
+        affected.insert(target);
+        grown = true;
+      }
+    }
+  }
+  return affected;
+}
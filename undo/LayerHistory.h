@@ -0,0 +1,58 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QVector>
+
+class QUndoCommand;
+class QUndoStack;
+
+// -------------------------- LayerHistory --------------------------
+// Layer partitioned view of the applied part of an undo stack: the global
+// order (stack index) plus one command chain per layer. A layer's result
+// only depends on its own chain and, through lasso cuts, on the chain of
+// the layer the cut was taken from. Commands without pixel effect (polygon
+// editing) belong to no layer (-1).
+class LayerHistory {
+
+public:
+
+    LayerHistory( const QUndoStack* stack, int count );
+
+    static int layerIdOf( const QUndoCommand* cmd );
+    static int sourceLayerIdOf( const QUndoCommand* cmd );  // cut source or -1
+
+    int count() const { return m_layerOf.size(); }
+    int layerOf( int index ) const { return m_layerOf.value(index, -1); }
+    QList<int> chain( int layerId ) const { return m_chains.value(layerId); }
+
+    // Layers whose state changes when the commands at the stack indices
+    // 'order' are applied instead of [0, count()). 'affected' seeds the set
+    // (e.g. layers whose commands cannot be moved over without executing).
+    QSet<int> affectedLayers( const QList<int>& order, QSet<int> affected = QSet<int>() ) const;
+
+private:
+
+    QVector<int> m_layerOf;
+    QVector<int> m_sourceOf;
+    QHash<int, QList<int>> m_chains;
+
+};
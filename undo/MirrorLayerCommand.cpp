@@ -16,6 +16,7 @@
 */
 
 #include "MirrorLayerCommand.h"
+#include "CommandRegistry.h"
 
 #include "../gui/MainWindow.h"
 
@@ -75,7 +76,7 @@ void MirrorLayerCommand::undo()
 {
   qCDebug(logEditor) << "MirrorLayerCommand::undo(): Processing...";
   {
-    if ( m_deleted || !(m_layer && m_isMirroring) ) return; 
+    if ( m_deleted || !(m_layer && !m_silent && m_isMirroring) ) return; 
     m_layer->setMirror(m_mirrorPlane);
     printMessage(true);
   }
@@ -138,3 +139,10 @@ MirrorLayerCommand* MirrorLayerCommand::fromJson( const QJsonObject& obj, const
     );
 }
 
+// -------------- registry --------------
+static const CommandRegistry::Registrar registrar(
+  { "MirrorLayer", "MirrorLayerCommand" },
+  []( const QJsonObject& obj, const CommandRegistry::Context& context ) -> AbstractCommand* {
+    return MirrorLayerCommand::fromJson(obj, context.layers);
+  },
+  CommandRegistry::layerArea);
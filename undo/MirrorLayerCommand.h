@@ -32,6 +32,7 @@ class MirrorLayerCommand : public AbstractCommand
     MirrorLayerCommand( LayerItem* layer, const int idx, int mirrorPlane, QUndoCommand* parent = nullptr );
     
     AbstractCommand* clone() const override { return new MirrorLayerCommand(m_layer,m_layerId,m_mirrorPlane); }
+    AbstractCommand* cloneApplied() const override { return clone(); }
     
     LayerItem* layer() const override { return m_layer; }
     int id() const override { return 1006; }
@@ -16,6 +16,7 @@
 */
 
 #include "MoveLayerCommand.h"
+#include "CommandRegistry.h"
 
 #include "../core/Config.h"
 #include "../core/IMainSystem.h"
@@ -76,7 +77,7 @@ void MoveLayerCommand::undo()
 { 
   qCDebug(logEditor) << "MoveLayerCommand::undo(): deleted =" << m_deleted << ", old_pos =" << m_oldPos;
   {
-    if ( !m_layer || m_deleted ) return;
+    if ( m_silent || !m_layer || m_deleted ) return;
     m_layer->setPos(m_oldPos);
     printMessage(true);
   }
@@ -127,3 +128,9 @@ MoveLayerCommand* MoveLayerCommand::fromJson( const QJsonObject& obj, const QLis
     );
 }
 
+// -------------- registry --------------
+static const CommandRegistry::Registrar registrar(
+  { "MoveLayer", "MoveLayerCommand" },
+  []( const QJsonObject& obj, const CommandRegistry::Context& context ) -> AbstractCommand* {
+    return MoveLayerCommand::fromJson(obj, context.layers);
+  });
@@ -31,6 +31,7 @@ public:
     MoveLayerCommand( LayerItem* layer, const QPointF& oldPos, const QPointF& newPos, const int idx=0, QUndoCommand* parent = nullptr );
     
     AbstractCommand* clone() const override { return new MoveLayerCommand(m_layer,m_oldPos,m_newPos,m_layerId); }
+    AbstractCommand* cloneApplied() const override { return clone(); }
     
     QString type() const override { return "MoveLayer"; }
     LayerItem* layer() const override { return m_layer; }
@@ -16,13 +16,15 @@
 */
 
 #include "PaintStrokeCommand.h"
+#include "CommandRegistry.h"
 #include "AbstractCommand.h"
 #include <QPainter>
 #include <QtMath>
 
 #include "../core/Config.h"
-#include "../util/BrushUtils.h"
+#include "../util/BrushEngine.h"
 #include "../util/Compress.h"
+#include "../util/PointPack.h"
 
 #include <iostream>
 
@@ -31,7 +33,7 @@ PaintStrokeCommand::PaintStrokeCommand( LayerItem* layer,
         const QPoint& pos, const QColor& color, int radius,qreal hardness, QUndoCommand* parent )
     : AbstractCommand(parent),
       m_layer(layer),
-      m_backup(layer->image()),  // Backup für Undo
+      m_backup(std::make_shared<const TileSnapshot>(layer->image())),  // Backup für Undo
       m_pos(pos),
       m_radius(radius),
       m_hardness(hardness),
@@ -43,13 +45,14 @@ PaintStrokeCommand::PaintStrokeCommand( LayerItem* layer,
 }
 
 PaintStrokeCommand::PaintStrokeCommand( LayerItem* layer,
-        const QVector<QPoint>& strokePoints, const QColor& color, int radius, float hardness, QUndoCommand* parent )
+        const QVector<QPoint>& strokePoints, const QColor& color, int radius, float hardness, int brushMode, QUndoCommand* parent )
     : AbstractCommand(parent)
     , m_layer(layer)
     , m_points(strokePoints)
     , m_color(color)
     , m_radius(radius)
     , m_hardness(hardness)
+    , m_brushMode(brushMode)
 {
     Q_ASSERT(m_layer);
     Q_ASSERT(!m_points.isEmpty());
@@ -60,40 +63,42 @@ PaintStrokeCommand::PaintStrokeCommand( LayerItem* layer,
     int pad = m_radius + 2;
     m_dirtyRect.adjust(-pad, -pad, pad, pad);
     m_dirtyRect &= m_layer->image().rect();
-    m_backup = m_layer->image(1).copy(m_dirtyRect);
+    m_backup = std::make_shared<const TileSnapshot>(m_layer->image(1), m_dirtyRect);
     // --- test save ---
-    // QString text = CompressUtils::toGZipBase64(m_backup);
+    // QString text = CompressUtils::toGZipBase64(m_backup.image());
     // CompressUtils::saveToFile("/tmp/testimage.txt",text);
     // --- --- --- ---
     m_layerId = layer->id();
 }
 
+// Copies share the stroke points, nothing is painted or captured. Only copies
+// replacing the applied command share its backup tiles, the others capture
+// their own on the first redo.
+PaintStrokeCommand::PaintStrokeCommand( const PaintStrokeCommand& other, bool shareBackup, QUndoCommand* parent )
+    : AbstractCommand(parent)
+    , m_layerId(other.m_layerId)
+    , m_layer(other.m_layer)
+    , m_points(other.m_points)
+    , m_pos(other.m_pos)
+    , m_radius(other.m_radius)
+    , m_hardness(other.m_hardness)
+    , m_color(other.m_color)
+    , m_brushMode(other.m_brushMode)
+    , m_dirtyRect(other.m_dirtyRect)
+    , m_backup(shareBackup ? other.m_backup : nullptr)
+{
+    setText(other.text());
+}
+
 // --------------------------------  --------------------------------
 void PaintStrokeCommand::paint( QImage &img )
 {
-  qCDebug(logEditor)<< "PaintStrokeCommand::paint(): image=(" << img.width() << "x" << img.height() << "), type=" << img.format() << ", npoints=" << m_points.size();
+  qCDebug(logEditor)<< "PaintStrokeCommand::paint(): image=(" << img.width() << "x" << img.height() << "), type=" << img.format() << ", npoints=" << m_points.size()
+                    << ", mode=" << BrushEngine::modeName(m_brushMode);
   {
-    if ( m_points.size() == 1 ) {
-      BrushUtils::dab(
-            img,
-            m_points.first(),
-            m_color,
-            m_radius,
-            m_hardness
-      );
-      return;
-    }
-    for ( int i = 1; i < m_points.size(); ++i ) {
-      // std::cout << " point1=(" << m_points[i-1].x() << ":" << m_points[i-1].y() << ") -> point2=(" << m_points[i].x() << ":" << m_points[i].y() << ")" << std::endl;
-      BrushUtils::strokeSegment(
-            img,
-            m_points[i - 1],
-            m_points[i],
-            m_color,
-            m_radius,
-            m_hardness
-      );
-    }
+    // whole stroke in one coverage buffer, the same one LayerItem::paintStrokeSegment()
+    // builds while painting, each pixel is blended once
+    BrushEngine::paintStroke(img, m_brushMode, m_points, m_color, m_radius, m_hardness);
   }
 }
 
@@ -102,12 +107,11 @@ void PaintStrokeCommand::undo()
 {
   qCDebug(logEditor) << "PaintStrokeCommand::undo(): Processing...";
   {
-    if ( !m_layer || m_backup.isNull() )
+    if ( m_silent || !m_layer || !m_backup || m_backup->isNull() )
         return;
     QImage& img = m_layer->image();
-    QPainter p(&img);
-    p.drawImage(m_dirtyRect.topLeft(), m_backup);
-    m_layer->updateImageRegion(m_dirtyRect);
+    m_backup->restore(img);
+    m_layer->updateImageRegion(m_backup->rect());
   }
 }
 
@@ -117,6 +121,10 @@ void PaintStrokeCommand::redo()
   {
     if ( m_silent || !m_layer || m_points.isEmpty() )
       return;
+    if ( !m_backup ) {
+      // the pixels this redo paints over, undo restores them
+      m_backup = std::make_shared<const TileSnapshot>(m_layer->image(), m_dirtyRect);
+    }
     QImage& img = m_layer->image();
     paint(img);
     m_layer->updateImageRegion(m_dirtyRect);
@@ -133,21 +141,15 @@ QJsonObject PaintStrokeCommand::toJson() const
     // Brush
     obj["radius"]   = m_radius;
     obj["hardness"] = m_hardness;
+    obj["brushMode"] = BrushEngine::modeName(m_brushMode);
     QJsonObject colorObj;
     colorObj["r"] = m_color.red();
     colorObj["g"] = m_color.green();
     colorObj["b"] = m_color.blue();
     colorObj["a"] = m_color.alpha();
     obj["color"] = colorObj;
-    // Stroke Points
-    QJsonArray pts;
-    for ( const QPoint& p : m_points ) {
-        QJsonObject po;
-        po["x"] = p.x();
-        po["y"] = p.y();
-        pts.append(po);
-    }
-    obj["points"] = pts;
+    // Stroke Points (delta varints or {"x","y"} objects)
+    obj["points"] = PointPack::writePoints(m_points, EditorStyle::instance().packedHistory());
     return obj; 
 }
 
@@ -193,16 +195,11 @@ PaintStrokeCommand* PaintStrokeCommand::fromJson( const QJsonObject& obj, const
     // Brush
     int radius     = obj["radius"].toInt(1);
     float hardness = float(obj["hardness"].toDouble(1.0));
+    int brushMode  = BrushEngine::modeFromName(obj["brushMode"].toString("Dabs"));
     
-    // Stroke Points
-    QVector<QPoint> points;
-    QJsonArray pts = obj["points"].toArray();
-    points.reserve(pts.size());
-    for ( const QJsonValue& v : pts ) {
-        QJsonObject po = v.toObject();
-        points.emplace_back(po["x"].toInt(), po["y"].toInt());
-    }
-    if ( points.size() < 2 ) {
+    // Stroke Points, a single point is a click (one dab)
+    const QVector<QPoint> points = PointPack::readPoints(obj["points"]);
+    if ( points.isEmpty() ) {
         qWarning() << "PaintStrokeCommand::fromJson(): Invalid stroke.";
         return nullptr;
     }
@@ -214,6 +211,19 @@ PaintStrokeCommand* PaintStrokeCommand::fromJson( const QJsonObject& obj, const
         color,
         radius,
         hardness,
+        brushMode,
         parent
     );
-}
\ No newline at end of file
+}
+
+// -------------- registry --------------
+static const CommandRegistry::Registrar registrar(
+  { "PaintStroke", "PaintStrokeCommand" },
+  []( const QJsonObject& obj, const CommandRegistry::Context& context ) -> AbstractCommand* {
+    return PaintStrokeCommand::fromJson(obj, context.layers);
+  },
+  []( const QJsonObject& obj, const CommandRegistry::Context& ) {
+    // every dab covers a square of the brush diameter
+    const qint64 d = 2 * qint64(obj.value("radius").toInt(1)) + 1;
+    return qint64(PointPack::readPoints(obj.value("points")).size()) * d * d;
+  });
@@ -21,18 +21,22 @@
 #include <QColor>
 
 #include "AbstractCommand.h"
+#include "../core/TileStore.h"
 #include "../layer/LayerItem.h"
 
+#include <memory>
+
 class PaintStrokeCommand : public AbstractCommand
 {
 
 public:
 
     PaintStrokeCommand( LayerItem* layer, const QPoint& pos, const QColor& color, int radius, qreal hardness, QUndoCommand* parent = nullptr );
-    PaintStrokeCommand( LayerItem* layer, const QVector<QPoint>& strokePoints, const QColor& color, int radius, float hardness, QUndoCommand* parent = nullptr );
+    PaintStrokeCommand( LayerItem* layer, const QVector<QPoint>& strokePoints, const QColor& color, int radius, float hardness, int brushMode = 0, QUndoCommand* parent = nullptr );
 
     QString type() const override { return "PaintStroke"; }
-    AbstractCommand* clone() const override { return new PaintStrokeCommand(m_layer, m_pos, m_color, m_radius, m_hardness); }
+    AbstractCommand* clone() const override { return new PaintStrokeCommand(*this, false, nullptr); }
+    AbstractCommand* cloneApplied() const override { return new PaintStrokeCommand(*this, true, nullptr); }
     
     void undo() override;
     void redo() override;
@@ -40,12 +44,16 @@ public:
     LayerItem* layer() const override { return m_layer; }
     int id() const override { return 1004; }
     
+    QList<const TileSnapshot*> snapshots() const override { return { m_backup.get() }; }
+    
     QJsonObject toJson() const override;
     static PaintStrokeCommand* fromJson( const QJsonObject& obj, const QList<LayerItem*>& layers, QUndoCommand* parent = nullptr );
     static PaintStrokeCommand* fromJson( const QJsonObject& obj, LayerItem* layer );
     
 private:
 
+    PaintStrokeCommand( const PaintStrokeCommand& other, bool shareBackup, QUndoCommand* parent );
+
 	void paint( QImage& img );
 
 private:
@@ -58,9 +66,9 @@ private:
     int        m_radius = 1;
     qreal      m_hardness = 1.0;
     QColor     m_color;
+    int        m_brushMode = 0;  // BrushEngine::Mode
     
     QRect      m_dirtyRect;
-    QRect      m_backupRect;
-    QImage     m_backup;
+    std::shared_ptr<const TileSnapshot> m_backup;    // tiles of m_dirtyRect before the stroke, shared by applied clones
     
 };
\ No newline at end of file
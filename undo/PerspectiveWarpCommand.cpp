@@ -16,6 +16,7 @@
 */
 
 #include "PerspectiveWarpCommand.h"
+#include "CommandRegistry.h"
 
 #include "../gui/MainWindow.h"
 #include "../core/Config.h"
@@ -36,12 +37,16 @@ PerspectiveWarpCommand::PerspectiveWarpCommand(
   qCDebug(logEditor) << "PerspectiveWarpCommand::PerspectiveWarpCommand(): Processing...";
   {
     m_isInitialized = false;
-    m_origPosition = m_layer->pos();
-    m_origTransform = m_layer->transform();
-    m_origSceneTransform = m_layer->sceneTransform();
-    m_origImage = m_layer->image(0);
+    auto origin = std::make_shared<Origin>();
+    origin->position = m_layer->pos();
+    origin->transform = m_layer->transform();
+    origin->sceneTransform = m_layer->sceneTransform();
+    // the warp always replaces size and position of the layer, so the old
+    // rect is the whole layer; it is also the source of every re-warp
+    origin->image = TileSnapshot(m_layer->image(0));
     const QRectF r = m_layer->boundingRect();
-    m_startQuad = { r.topLeft(), r.topRight(), r.bottomRight(), r.bottomLeft() };
+    origin->startQuad = { r.topLeft(), r.topRight(), r.bottomRight(), r.bottomLeft() };
+    m_origin = std::move(origin);
     setAfterQuad(after);
     m_layerId = m_layer->id();
     m_name = QString("Perspective Warp Layer %1").arg(m_layerId);
@@ -60,21 +65,27 @@ PerspectiveWarpCommand::PerspectiveWarpCommand(
   }
 }
 
+// Copies share the captured origin and the derived warp, neither the layer
+// nor the pixels are touched.
+PerspectiveWarpCommand::PerspectiveWarpCommand( const PerspectiveWarpCommand& other, QUndoCommand* parent )
+    : AbstractCommand(parent)
+    , m_layerId(other.m_layerId)
+    , m_layer(other.m_layer)
+    , m_name(other.m_name)
+    , m_isInitialized(other.m_isInitialized)
+    , m_origin(other.m_origin)
+    , m_warpTransform(other.m_warpTransform)
+    , m_newPosition(other.m_newPosition)
+    , m_beforeQuad(other.m_beforeQuad)
+    , m_afterQuad(other.m_afterQuad)
+{
+    setText(other.text());
+    setIcon(other.icon());
+}
+
 AbstractCommand* PerspectiveWarpCommand::clone() const
 {
-    auto* cmd = new PerspectiveWarpCommand(m_layer, m_beforeQuad, m_afterQuad);
-    cmd->m_layerId = m_layerId;
-    cmd->m_name = m_name;
-    cmd->m_isInitialized = m_isInitialized;
-    cmd->m_origImage = m_origImage;
-    cmd->m_origPosition = m_origPosition;
-    cmd->m_origTransform = m_origTransform;
-    cmd->m_origSceneTransform = m_origSceneTransform;
-    cmd->m_warpTransform = m_warpTransform;
-    cmd->m_newPosition = m_newPosition;
-    cmd->m_startQuad = m_startQuad;
-    cmd->setText(text());
-    return cmd;
+    return new PerspectiveWarpCommand(*this, nullptr);
 }
 
 // -------------- Methods --------------
@@ -100,11 +111,11 @@ bool PerspectiveWarpCommand::mergeWith( const QUndoCommand* other )
         return false;
     if ( cmd->m_deleted != m_deleted )
         return false;
-    if ( cmd->m_startQuad.size() != 4 || m_startQuad.size() != 4 )
+    if ( cmd->m_origin->startQuad.size() != 4 || m_origin->startQuad.size() != 4 )
         return false;
-    if ( cmd->m_startQuad != m_startQuad )
+    if ( cmd->m_origin->startQuad != m_origin->startQuad )
         return false;
-    if ( cmd->m_origTransform != m_origTransform )
+    if ( cmd->m_origin->transform != m_origin->transform )
         return false;
     m_afterQuad = cmd->m_afterQuad;
     rebuildWarp();
@@ -127,7 +138,7 @@ void PerspectiveWarpCommand::setAfterQuadFromScene( const QVector<QPointF>& scen
   {
     if ( sceneQuad.size() != 4 ) return;
     bool invertible = false;
-    QTransform sceneToOriginal = m_origSceneTransform.inverted(&invertible);
+    QTransform sceneToOriginal = m_origin->sceneTransform.inverted(&invertible);
     if ( !invertible ) {
       qWarning() << "PerspectiveWarpCommand::setAfterQuadFromScene(): Original scene transform is not invertible.";
       return;
@@ -168,6 +179,7 @@ QVector<QPointF> PerspectiveWarpCommand::displayQuad() const
 void PerspectiveWarpCommand::rebuildWarp()
 {
     m_warpTransform = QTransform();
+    m_prepared = QImage();
     if ( m_beforeQuad.size() != 4 || m_afterQuad.size() != 4 ) {
         return;
     }
@@ -185,21 +197,12 @@ void PerspectiveWarpCommand::rebuildWarp()
         return;
     }
 
-    m_newPosition = m_origSceneTransform.map(targetBounds.topLeft());
+    m_newPosition = m_origin->sceneTransform.map(targetBounds.topLeft());
 }
 
-bool PerspectiveWarpCommand::applyWarp()
+// reads the captured origin only, safe on a worker thread
+QImage PerspectiveWarpCommand::warpedImage() const
 {
-    if ( !m_layer || m_beforeQuad.size() != 4 || m_afterQuad.size() != 4 || m_origImage.isNull() ) {
-        return false;
-    }
-
-    if ( m_afterQuad == m_beforeQuad ) {
-        m_layer->resetImageState(m_origImage, m_origPosition, m_origTransform);
-        m_layer->setOriginalImage(m_origImage,LayerItem::ImageType::Original);
-        return true;
-    }
-
     const QRectF targetBounds = QPolygonF(m_afterQuad).boundingRect();
     const QSize targetSize(qMax(1, qCeil(targetBounds.width())),
                            qMax(1, qCeil(targetBounds.height())));
@@ -209,9 +212,26 @@ bool PerspectiveWarpCommand::applyWarp()
     QPainter painter(&warped);
     painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
     painter.setTransform(m_warpTransform);
-    painter.drawImage(QPointF(0, 0), m_origImage);
+    painter.drawImage(QPointF(0, 0), m_origin->image.image());
     painter.end();
+    return warped;
+}
 
+bool PerspectiveWarpCommand::applyWarp()
+{
+    if ( !m_layer || m_beforeQuad.size() != 4 || m_afterQuad.size() != 4 || m_origin->image.isNull() ) {
+        return false;
+    }
+
+    if ( m_afterQuad == m_beforeQuad ) {
+        const QImage origImage = m_origin->image.image();
+        m_layer->resetImageState(origImage, m_origin->position, m_origin->transform);
+        m_layer->setOriginalImage(origImage,LayerItem::ImageType::Original);
+        return true;
+    }
+
+    const QImage warped = m_prepared.isNull() ? warpedImage() : m_prepared;
+    m_prepared = QImage();
     m_layer->resetImageState(warped, m_newPosition, QTransform());
     m_layer->setOriginalImage(warped,LayerItem::ImageType::Original);
     return true;
@@ -220,11 +240,12 @@ bool PerspectiveWarpCommand::applyWarp()
 // -------------- Undo / redo --------------
 void PerspectiveWarpCommand::undo()
 {
-  qCDebug(logEditor) << "PerspectiveWarpCommand::undo(): position =" << m_origPosition;
+  qCDebug(logEditor) << "PerspectiveWarpCommand::undo(): position =" << m_origin->position;
   {
-    if ( !m_layer ) return;
-    m_layer->resetImageState(m_origImage,m_origPosition,m_origTransform);
-    m_layer->setOriginalImage(m_origImage,LayerItem::ImageType::Original);
+    if ( m_silent || !m_layer ) return;
+    const QImage origImage = m_origin->image.image();
+    m_layer->resetImageState(origImage,m_origin->position,m_origin->transform);
+    m_layer->setOriginalImage(origImage,LayerItem::ImageType::Original);
     printMessage(true);
   }
 }
@@ -233,13 +254,23 @@ void PerspectiveWarpCommand::redo()
 {
   qCDebug(logEditor) << "PerspectiveWarpCommand::redo(): isInitialized =" << m_isInitialized << ", position =" << m_newPosition;
   {
-    if ( !m_layer || m_deleted ) return;
+    if ( m_silent || !m_layer || m_deleted ) return;
     if ( applyWarp() ) {
       printMessage();
     }
   }
 }
 
+void PerspectiveWarpCommand::prepare()
+{
+  qCDebug(logEditor) << "PerspectiveWarpCommand::prepare(): Processing...";
+  {
+    if ( m_beforeQuad.size() != 4 || m_afterQuad.size() != 4 || m_afterQuad == m_beforeQuad || m_origin->image.isNull() ) 
+      return;
+    m_prepared = warpedImage();
+  }
+}
+
 // -------------- History --------------
 void PerspectiveWarpCommand::buildFromJson( const QPointF& position )
 {
@@ -311,3 +342,11 @@ PerspectiveWarpCommand* PerspectiveWarpCommand::fromJson( const QJsonObject& obj
     perspectiveWarpCommand->buildFromJson(hasNewPosition ? newPosition : perspectiveWarpCommand->m_newPosition);
     return perspectiveWarpCommand;
 }
+
+// -------------- registry --------------
+static const CommandRegistry::Registrar registrar(
+  { "PerspectiveWarp", "PerspectiveWarpCommand" },
+  []( const QJsonObject& obj, const CommandRegistry::Context& context ) -> AbstractCommand* {
+    return PerspectiveWarpCommand::fromJson(obj, context.layers);
+  },
+  CommandRegistry::layerArea);
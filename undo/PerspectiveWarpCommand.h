@@ -18,11 +18,14 @@
 #pragma once
 
 #include "AbstractCommand.h"
+#include "../core/TileStore.h"
 #include <QVector>
 #include <QPointF>
 #include <QImage>
 #include <QTransform>
 
+#include <memory>
+
 class LayerItem;
 
 class PerspectiveWarpCommand : public AbstractCommand
@@ -33,6 +36,7 @@ class PerspectiveWarpCommand : public AbstractCommand
     PerspectiveWarpCommand( LayerItem* layer, const QVector<QPointF>& before, const QVector<QPointF>& after, QUndoCommand* parent = nullptr );
                            
     AbstractCommand* clone() const override;
+    AbstractCommand* cloneApplied() const override { return clone(); }
 
     void buildFromJson( const QPointF& position );
     void setAfterQuad( const QVector<QPointF>& after );
@@ -48,13 +52,28 @@ class PerspectiveWarpCommand : public AbstractCommand
     
     void undo() override;
     void redo() override;
+    void prepare() override;
 
+    QList<const TileSnapshot*> snapshots() const override { return { &m_origin->image }; }
+    
     QJsonObject toJson() const override;
     static PerspectiveWarpCommand* fromJson( const QJsonObject& obj, const QList<LayerItem*>& layers, QUndoCommand* parent = nullptr );
 
   private:
 
+    // state of the layer before the warp, captured once and shared by all clones
+    struct Origin {
+      TileSnapshot image;
+      QPointF position;
+      QTransform transform;
+      QTransform sceneTransform;
+      QVector<QPointF> startQuad;
+    };
+
+    explicit PerspectiveWarpCommand( const PerspectiveWarpCommand& other, QUndoCommand* parent );
+
     void rebuildWarp();
+    QImage warpedImage() const;
     bool applyWarp();
   
     int m_layerId = -1;
@@ -64,16 +83,14 @@ class PerspectiveWarpCommand : public AbstractCommand
     
     bool m_isInitialized;
     
-    QImage m_origImage;
-    QPointF m_origPosition;
-    QTransform m_origTransform;
-    QTransform m_origSceneTransform;
+    std::shared_ptr<const Origin> m_origin;
     
     QTransform m_warpTransform;
     QPointF m_newPosition;
     
-    QVector<QPointF> m_startQuad;
     QVector<QPointF> m_beforeQuad;
     QVector<QPointF> m_afterQuad;
     
+    QImage m_prepared;          // warped by prepare(), consumed by the next redo()
+    
 };
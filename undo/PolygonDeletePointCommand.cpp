@@ -16,6 +16,7 @@
 */
 
 #include "PolygonDeletePointCommand.h"
+#include "CommandRegistry.h"
 
 // --------------------- Constructor ---------------------
 PolygonDeletePointCommand::PolygonDeletePointCommand(
@@ -57,4 +58,13 @@ PolygonDeletePointCommand* PolygonDeletePointCommand::fromJson( const QJsonObjec
         obj["idx"].toInt(),
         QPointF(obj["x"].toDouble(), obj["y"].toDouble())
     );
-}
\ No newline at end of file
+}
+
+// -------------- registry --------------
+static const CommandRegistry::Registrar registrar(
+  { "PolygonDeletePoint", "DeletePolygonPoint" },
+  []( const QJsonObject& obj, const CommandRegistry::Context& context ) -> AbstractCommand* {
+    return context.polygon != nullptr ? PolygonDeletePointCommand::fromJson(obj, context.polygon) : nullptr;
+  },
+  nullptr,
+  []( const QJsonObject& ) { return QList<int>(); });
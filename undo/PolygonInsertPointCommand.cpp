@@ -16,6 +16,7 @@
 */
 
 #include "PolygonInsertPointCommand.h"
+#include "CommandRegistry.h"
 
 PolygonInsertPointCommand::PolygonInsertPointCommand( EditablePolygon* poly,
                                                      int idx,
@@ -58,3 +59,12 @@ PolygonInsertPointCommand* PolygonInsertPointCommand::fromJson( const QJsonObjec
         QPointF(obj["x"].toDouble(), obj["y"].toDouble())
     );
 }
+
+// -------------- registry --------------
+static const CommandRegistry::Registrar registrar(
+  { "PolygonInsertPoint", "InsertPolygonPoint" },
+  []( const QJsonObject& obj, const CommandRegistry::Context& context ) -> AbstractCommand* {
+    return context.polygon != nullptr ? PolygonInsertPointCommand::fromJson(obj, context.polygon) : nullptr;
+  },
+  nullptr,
+  []( const QJsonObject& ) { return QList<int>(); });
@@ -16,6 +16,7 @@
 */
 
 #include "PolygonMovePointCommand.h"
+#include "CommandRegistry.h"
 
 PolygonMovePointCommand::PolygonMovePointCommand(
     EditablePolygon* poly, int idx, const QPointF& o, const QPointF& n,
@@ -59,3 +60,12 @@ PolygonMovePointCommand* PolygonMovePointCommand::fromJson(
         QPointF(o["nx"].toDouble(), o["ny"].toDouble())
     );
 }
+
+// -------------- registry --------------
+static const CommandRegistry::Registrar registrar(
+  { "PolygonMovePoint", "MovePolygonPoint" },
+  []( const QJsonObject& obj, const CommandRegistry::Context& context ) -> AbstractCommand* {
+    return context.polygon != nullptr ? PolygonMovePointCommand::fromJson(obj, context.polygon) : nullptr;
+  },
+  nullptr,
+  []( const QJsonObject& ) { return QList<int>(); });
@@ -1,9 +1,12 @@
 #include "PolygonReduceCommand.h"
+#include "CommandRegistry.h"
 
 // ---------------------------- Constructor ----------------------------
-PolygonReduceCommand::PolygonReduceCommand( EditablePolygon* poly, QUndoCommand* parent )
+PolygonReduceCommand::PolygonReduceCommand( EditablePolygon* poly, qreal tolerance, int targetCount, QUndoCommand* parent )
     : AbstractCommand(parent),
-      m_poly(poly)
+      m_poly(poly),
+      m_tolerance(tolerance),
+      m_targetCount(targetCount)
 {
   m_before = m_poly->polygon();
   setText(QString("Reduce polygon"));
@@ -21,7 +24,12 @@ void PolygonReduceCommand::redo()
 {
     if ( !m_poly )
       return; 
-    m_poly->reduce();
+    // deterministic for a given polygon, batch replay gives the same points
+    if ( m_legacy ) {
+      m_poly->reduceLegacy(m_tolerance);
+    } else {
+      m_poly->reduce(m_tolerance, m_targetCount);
+    }
 }
 
 // ----------------------------  ---------------------------- 
@@ -30,6 +38,11 @@ QJsonObject PolygonReduceCommand::toJson() const
     QJsonObject obj = AbstractCommand::toJson();
     obj["type"] = "PolygonReduce";
     obj["layerId"] = 0;
+    // legacy entries stay without parameters, so they keep the old algorithm
+    if ( !m_legacy ) {
+      obj["tolerance"] = m_tolerance;
+      obj["targetCount"] = m_targetCount;
+    }
     QJsonArray pts;
     for ( const QPointF& p : m_before ) {
         QJsonObject jp;
@@ -53,5 +66,19 @@ PolygonReduceCommand* PolygonReduceCommand::fromJson( const QJsonObject& obj, Ed
         polygon << QPointF(jp["x"].toDouble(), jp["y"].toDouble());
     }
     poly->setPolygon(polygon);
-    return new PolygonReduceCommand(poly);
-}
\ No newline at end of file
+    auto* cmd = new PolygonReduceCommand(poly, obj["tolerance"].toDouble(0.5), obj["targetCount"].toInt(0));
+    // older projects have no parameters, they were reduced by the old algorithm
+    cmd->m_legacy = !obj.contains("tolerance") && !obj.contains("targetCount");
+    return cmd;
+}
+
+// -------------- registry --------------
+static const CommandRegistry::Registrar registrar(
+  { "PolygonReduce", "ReducePolygon" },
+  []( const QJsonObject& obj, const CommandRegistry::Context& context ) -> AbstractCommand* {
+    return context.polygon != nullptr ? PolygonReduceCommand::fromJson(obj, context.polygon) : nullptr;
+  },
+  []( const QJsonObject& obj, const CommandRegistry::Context& ) {
+    return qint64(obj.value("points").toArray().size());
+  },
+  []( const QJsonObject& ) { return QList<int>(); });
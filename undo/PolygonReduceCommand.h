@@ -27,9 +27,13 @@ class PolygonReduceCommand : public AbstractCommand
 
   public:
   
-    PolygonReduceCommand( EditablePolygon* poly, QUndoCommand* parent = nullptr );
+    PolygonReduceCommand( EditablePolygon* poly, qreal tolerance = 0.5, int targetCount = 0, QUndoCommand* parent = nullptr );
 
-    AbstractCommand* clone() const override { return new PolygonReduceCommand(m_poly); }
+    AbstractCommand* clone() const override {
+      auto* cmd = new PolygonReduceCommand(m_poly, m_tolerance, m_targetCount);
+      cmd->m_legacy = m_legacy;
+      return cmd;
+    }
     QString type() const override { return "ReducePolygon"; }
     
     LayerItem* layer() const override { return nullptr; }
@@ -45,6 +49,10 @@ class PolygonReduceCommand : public AbstractCommand
 
     EditablePolygon* m_poly;
     
+    qreal m_tolerance = 0.5;    // Douglas-Peucker distance in pixel
+    int m_targetCount = 0;      // > 0: Visvalingam-Whyatt down to this number of points
+    bool m_legacy = false;      // loaded without parameters: QPainterPath::simplified() + distance filter
+    
     QPolygonF m_before;
     
 };
\ No newline at end of file
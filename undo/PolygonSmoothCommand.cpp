@@ -16,11 +16,15 @@
 */
 
 #include "PolygonSmoothCommand.h"
+#include "CommandRegistry.h"
 
 // ---------------------------- Constructor ----------------------------
-PolygonSmoothCommand::PolygonSmoothCommand( EditablePolygon* poly, QUndoCommand* parent )
+PolygonSmoothCommand::PolygonSmoothCommand( EditablePolygon* poly, qreal maxError, int maxPoints, int basis, QUndoCommand* parent )
     : AbstractCommand(parent),
-      m_poly(poly)
+      m_poly(poly),
+      m_maxError(maxError),
+      m_maxPoints(maxPoints),
+      m_basis(basis)
 {
   m_before = m_poly->polygon();
   setText(QString("Smooth polygon"));
@@ -38,7 +42,11 @@ void PolygonSmoothCommand::redo()
 {
     if ( m_silent || !m_poly )
       return; 
-    m_poly->smooth();
+    if ( m_legacy ) {
+      m_poly->smoothLegacy();
+    } else {
+      m_poly->smooth(m_maxError, m_maxPoints, m_basis);
+    }
 }
 
 // ----------------------------  ---------------------------- 
@@ -47,6 +55,12 @@ QJsonObject PolygonSmoothCommand::toJson() const
     QJsonObject obj = AbstractCommand::toJson();
     obj["type"] = "PolygonSmooth";
     obj["layerId"] = 0;
+    // legacy entries stay without parameters, so they keep the old algorithm
+    if ( !m_legacy ) {
+      obj["maxError"] = m_maxError;
+      obj["maxPoints"] = m_maxPoints;
+      obj["basis"] = m_basis;
+    }
     QJsonArray pts;
     for ( const QPointF& p : m_before ) {
         QJsonObject jp;
@@ -70,5 +84,19 @@ PolygonSmoothCommand* PolygonSmoothCommand::fromJson( const QJsonObject& obj, Ed
         polygon << QPointF(jp["x"].toDouble(), jp["y"].toDouble());
     }
     poly->setPolygon(polygon);
-    return new PolygonSmoothCommand(poly);
-}
\ No newline at end of file
+    auto* cmd = new PolygonSmoothCommand(poly, obj["maxError"].toDouble(0.25), obj["maxPoints"].toInt(0), obj["basis"].toInt(0));
+    // older projects have no parameters, they were smoothed by the old algorithm
+    cmd->m_legacy = !obj.contains("maxError") && !obj.contains("maxPoints");
+    return cmd;
+}
+
+// -------------- registry --------------
+static const CommandRegistry::Registrar registrar(
+  { "PolygonSmooth", "SmoothPolygon" },
+  []( const QJsonObject& obj, const CommandRegistry::Context& context ) -> AbstractCommand* {
+    return context.polygon != nullptr ? PolygonSmoothCommand::fromJson(obj, context.polygon) : nullptr;
+  },
+  []( const QJsonObject& obj, const CommandRegistry::Context& ) {
+    return qint64(obj.value("points").toArray().size());
+  },
+  []( const QJsonObject& ) { return QList<int>(); });
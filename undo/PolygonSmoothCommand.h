@@ -26,10 +26,14 @@ class PolygonSmoothCommand : public AbstractCommand
 {
 
   public:
-    PolygonSmoothCommand( EditablePolygon* poly,
+    PolygonSmoothCommand( EditablePolygon* poly, qreal maxError = 0.25, int maxPoints = 0, int basis = 0,
                             QUndoCommand* parent = nullptr );
 
-    AbstractCommand* clone() const override { return new PolygonSmoothCommand(m_poly); }
+    AbstractCommand* clone() const override {
+      auto* cmd = new PolygonSmoothCommand(m_poly, m_maxError, m_maxPoints, m_basis);
+      cmd->m_legacy = m_legacy;
+      return cmd;
+    }
     QString type() const override { return "SmoothPolygon"; }
     
     LayerItem* layer() const override { return nullptr; }
@@ -46,4 +50,9 @@ class PolygonSmoothCommand : public AbstractCommand
     EditablePolygon* m_poly;  
     QPolygonF m_before;
     
+    qreal m_maxError = 0.25;    // max. chord error in pixel
+    int m_maxPoints = 0;        // vertex budget, 0: see EditablePolygon::smooth()
+    int m_basis = 0;            // SplineSmooth::Basis
+    bool m_legacy = false;      // loaded without parameters: quadTo() path + toFillPolygon()
+    
 };
\ No newline at end of file
@@ -16,6 +16,7 @@
 */
 
 #include "PolygonTranslateCommand.h"
+#include "CommandRegistry.h"
 
 #include <iostream>
 
@@ -66,4 +67,13 @@ PolygonTranslateCommand* PolygonTranslateCommand::fromJson( const QJsonObject& o
     QPointF start = QPointF(obj["x_start"].toDouble(),obj["y_start"].toDouble());
     QPointF end = QPointF(obj["x_end"].toDouble(),obj["y_end"].toDouble());
     return new PolygonTranslateCommand(poly,start,end);
-}
\ No newline at end of file
+}
+
+// -------------- registry --------------
+static const CommandRegistry::Registrar registrar(
+  { "PolygonTranslate", "TranslatePolygon" },
+  []( const QJsonObject& obj, const CommandRegistry::Context& context ) -> AbstractCommand* {
+    return context.polygon != nullptr ? PolygonTranslateCommand::fromJson(obj, context.polygon) : nullptr;
+  },
+  nullptr,
+  []( const QJsonObject& ) { return QList<int>(); });
@@ -16,6 +16,7 @@
 */
 
 #include "TransformLayerCommand.h"
+#include "CommandRegistry.h"
 
 #include "../gui/MainWindow.h"
 #include "../layer/LayerItem.h"
@@ -122,6 +123,7 @@ void TransformLayerCommand::printMessage( bool isUndo )
 void TransformLayerCommand::setTransform( const QTransform& transform ) 
 { 
   m_newTransform = transform; 
+  m_prepared = QImage();
 } 
 
 void TransformLayerCommand::setRotationAngle( double rotation ) 
@@ -161,7 +163,7 @@ void TransformLayerCommand::undo()
 {
   qCDebug(logEditor) << "TransformLayerCommand::undo(): Processing...";
   {
-    if ( !m_layer || m_deleted ) return;
+    if ( m_silent || !m_layer || m_deleted ) return;
     const QRectF oldSceneRect = m_layer->sceneBoundingRect();
     bool invertible = false;
     QTransform inv = m_newTransform.inverted(&invertible);
@@ -191,7 +193,8 @@ void TransformLayerCommand::redo()
     if ( m_silent || !m_layer || m_deleted ) return;
     const QRectF oldSceneRect = m_layer->sceneBoundingRect();
     m_totalTransform *= m_newTransform;
-    m_layer->setImageTransform(m_newTransform);
+    m_layer->setImageTransform(m_newTransform,true,m_prepared);
+    m_prepared = QImage();
     if ( m_trafoType == LayerTransformType::Scale ) {
       m_layer->shiftTo(m_oldPos+QPointF(m_newTransform.dx(),m_newTransform.dy()));
     }
@@ -204,6 +207,15 @@ void TransformLayerCommand::redo()
   }
 }
 
+void TransformLayerCommand::prepare()
+{
+  qCDebug(logEditor) << "TransformLayerCommand::prepare(): trafoType =" << m_trafoType;
+  {
+    if ( m_silent || !m_layer || m_deleted ) return;
+    m_prepared = m_layer->transformedImage(m_newTransform);
+  }
+}
+
 // -------------- JSON stuff -------------- 
 QJsonObject TransformLayerCommand::toJson() const
 {
@@ -296,4 +308,12 @@ TransformLayerCommand* TransformLayerCommand::fromJson( const QJsonObject& obj,
         trafoType
     );
   }
-}
\ No newline at end of file
+}
+
+// -------------- registry --------------
+static const CommandRegistry::Registrar registrar(
+  { "TransformLayer", "TransformLayerCommand" },
+  []( const QJsonObject& obj, const CommandRegistry::Context& context ) -> AbstractCommand* {
+    return TransformLayerCommand::fromJson(obj, context.layers);
+  },
+  CommandRegistry::layerArea);
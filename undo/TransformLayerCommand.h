@@ -46,6 +46,13 @@ class TransformLayerCommand : public AbstractCommand
         const QTransform& newTransform, QUndoCommand* parent = nullptr );
     
     AbstractCommand* clone() const override { return new TransformLayerCommand(m_layer, m_oldPos, m_newPos, m_rotationAngle, m_oldTransform, m_newTransform, m_name); }
+    AbstractCommand* cloneApplied() const override {
+      auto* cmd = new TransformLayerCommand(m_layer, m_oldPos, m_newPos, m_rotationAngle, m_oldTransform, m_newTransform, m_name, m_trafoType);
+      cmd->m_totalTransform = m_totalTransform;
+      cmd->m_scaleX = m_scaleX;
+      cmd->m_scaleY = m_scaleY;
+      return cmd;
+    }
     
     void printMessage( bool isUndo=false );
     void setRotationAngle( double rotation );
@@ -60,6 +67,7 @@ class TransformLayerCommand : public AbstractCommand
 
     void undo() override;
     void redo() override;
+    void prepare() override;
     
     bool mergeWith( const QUndoCommand *other ) override;
     
@@ -86,4 +94,6 @@ class TransformLayerCommand : public AbstractCommand
     QTransform m_newTransform;
     QTransform m_totalTransform;
     
+    QImage m_prepared;          // transformed by prepare(), consumed by the next redo()
+    
 };
\ No newline at end of file
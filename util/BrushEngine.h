@@ -0,0 +1,415 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+#include <QDebug>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QColor>
+#include <QPointF>
+#include <QRect>
+#include <QString>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// ---------------------- Brush rasteriser ----------------------
+// A dab is a precomputed radial falloff stamp (8 bit coverage). All dabs of one
+// stroke segment are merged into a coverage buffer which is composited once
+// onto the target image using integer arithmetic (two channels per register).
+namespace BrushEngine
+{
+
+  struct Stamp {
+    int radius = 0;
+    int size = 1;                  // 2*radius+1
+    std::vector<quint8> alpha;     // size*size, row major
+  };
+
+  using StampPtr = std::shared_ptr<const Stamp>;
+
+  // --- brush modes, stored by name in PaintStrokeCommand ---
+  enum Mode { Dabs = 0, Capsule = 1 };
+
+  inline QString modeName( int mode ) {
+    return mode == Capsule ? QString("Capsule") : QString("Dabs");
+  }
+
+  inline int modeFromName( const QString& name ) {
+    return name.compare("Capsule", Qt::CaseInsensitive) == 0 ? Capsule : Dabs;
+  }
+
+  // --- hardness profile, dist normalized to the brush radius ---
+  inline float falloff( float dist, float hardness ) {
+    if ( dist <= hardness )
+      return 1.0f;
+    float t = (dist - hardness) / (1.0f - hardness);
+    return 1.0f - std::max(0.0f, std::min(t, 1.0f));
+  }
+
+  // --- (x*a + y*b)/255 for the 4 channels of two ARGB32 pixels, a+b=255 ---
+  inline quint32 interpolatePixel255( quint32 x, quint32 a, quint32 y, quint32 b ) {
+    quint32 t = (x & 0x00ff00ff) * a + (y & 0x00ff00ff) * b;
+    t = (t + ((t >> 8) & 0x00ff00ff) + 0x00800080) >> 8;
+    t &= 0x00ff00ff;
+    x = ((x >> 8) & 0x00ff00ff) * a + ((y >> 8) & 0x00ff00ff) * b;
+    x = (x + ((x >> 8) & 0x00ff00ff) + 0x00800080);
+    x &= 0xff00ff00;
+    return x | t;
+  }
+
+  inline quint32 div255( quint32 v ) {
+    return (v + (v >> 8) + 0x80) >> 8;
+  }
+
+  // --- same profile as the former per pixel BrushUtils::dab() ---
+  inline StampPtr buildStamp( int radius, float hardness ) {
+    auto stamp = std::make_shared<Stamp>();
+    radius = std::max(0, radius);
+    hardness = std::max(0.0f, std::min(hardness, 1.0f));
+    stamp->radius = radius;
+    stamp->size = 2 * radius + 1;
+    stamp->alpha.assign(size_t(stamp->size) * size_t(stamp->size), 0);
+    const int r2 = radius * radius;
+    for ( int dy = -radius; dy <= radius; ++dy ) {
+      quint8* row = stamp->alpha.data() + size_t(dy + radius) * stamp->size;
+      for ( int dx = -radius; dx <= radius; ++dx ) {
+        const int d2 = dx*dx + dy*dy;
+        if ( d2 > r2 )
+          continue;
+        float alpha = radius > 0 ? falloff(std::sqrt(float(d2)) / float(radius), hardness) : 1.0f;
+        row[dx + radius] = quint8(std::lround(alpha * 255.0f));
+      }
+    }
+    return stamp;
+  }
+
+  // --- cached stamps, keyed by radius and hardness in 1/1000 steps ---
+  inline StampPtr stamp( int radius, float hardness ) {
+    static QMutex mutex;
+    static QHash<quint64, StampPtr> cache;
+    const int h = int(std::lround(std::max(0.0f, std::min(hardness, 1.0f)) * 1000.0f));
+    const quint64 key = (quint64(quint32(std::max(0, radius))) << 32) | quint32(h);
+    QMutexLocker locker(&mutex);
+    auto it = cache.constFind(key);
+    if ( it != cache.constEnd() )
+      return it.value();
+    if ( cache.size() > 64 )
+      cache.clear();
+    StampPtr s = buildStamp(radius, h / 1000.0f);
+    cache.insert(key, s);
+    return s;
+  }
+
+  // ---------------------- Coverage buffer ----------------------
+  class Coverage
+  {
+    public:
+
+      explicit Coverage( const QRect& bounds ) : m_rect(bounds) {
+        if ( !m_rect.isEmpty() )
+          m_data.assign(size_t(m_rect.width()) * size_t(m_rect.height()), 0);
+      }
+
+      const QRect& rect() const { return m_rect; }
+      bool isEmpty() const { return m_rect.isEmpty(); }
+
+      void clear() { std::fill(m_data.begin(), m_data.end(), quint8(0)); }
+
+      // Enlarges the buffer to cover bounds as well, the coverage so far is kept
+      void grow( const QRect& bounds ) {
+        const QRect united = m_rect.isEmpty() ? bounds : ( m_rect | bounds );
+        if ( united.isEmpty() || united == m_rect )
+          return;
+        std::vector<quint8> data(size_t(united.width()) * size_t(united.height()), 0);
+        if ( !m_rect.isEmpty() ) {
+          for ( int y = m_rect.top(); y <= m_rect.bottom(); ++y ) {
+            std::copy_n(coverageLine(y), m_rect.width(),
+                        data.data() + size_t(y - united.top()) * united.width() + (m_rect.left() - united.left()));
+          }
+        }
+        m_rect = united;
+        m_data.swap(data);
+      }
+
+      // Union of coverages c' = c + s - c*s with s = stamp * opacity. The colour
+      // alpha is folded into every dab before the union, so overlapping dabs
+      // still accumulate past it, 1 - (1-s1)(1-s2)..., as blending the dabs one
+      // after another did. Only the rounding differs: the coverage is rounded
+      // to 8 bit per dab, the old per segment compositing rounded the image,
+      // replayed Dabs strokes of older projects may differ by one or two levels.
+      // (Capsule coverage is combined by maximum and stays at the colour alpha.)
+      void addDab( const QPoint& center, const Stamp& stamp, int opacity ) {
+        if ( m_rect.isEmpty() || opacity <= 0 )
+          return;
+        const int r = stamp.radius;
+        const QRect dabRect = QRect(center.x() - r, center.y() - r, stamp.size, stamp.size) & m_rect;
+        if ( dabRect.isEmpty() )
+          return;
+        const quint32 op = quint32(std::min(opacity, 255));
+        const int w = dabRect.width();
+        for ( int y = dabRect.top(); y <= dabRect.bottom(); ++y ) {
+          const quint8* src = stamp.alpha.data() + size_t(y - center.y() + r) * stamp.size + (dabRect.left() - center.x() + r);
+          quint8* dst = m_data.data() + size_t(y - m_rect.top()) * m_rect.width() + (dabRect.left() - m_rect.left());
+          for ( int i = 0; i < w; ++i ) {
+            const quint32 s = div255(src[i] * op);
+            const quint32 c = dst[i];
+            dst[i] = quint8(c + s - div255(c * s));
+          }
+        }
+      }
+
+      // Analytic capsule: coverage from the distance of each pixel to the
+      // segment p0-p1. Only the row spans of the capsule are visited and the
+      // result is combined by maximum, so joints of a polyline are not blended
+      // twice.
+      void addCapsule( const QPoint& p0, const QPoint& p1, int radius, float hardness, int opacity ) {
+        if ( m_rect.isEmpty() || opacity <= 0 || radius < 0 )
+          return;
+        hardness = std::max(0.0f, std::min(hardness, 1.0f));
+        const float op = float(std::min(opacity, 255));
+        const float r = float(radius);
+        const float r2 = r * r;
+        const float ax = p0.x(), ay = p0.y();
+        const float dx = p1.x() - ax, dy = p1.y() - ay;
+        const float len2 = dx*dx + dy*dy;
+        // corners of the capsule body
+        QPointF body[4];
+        if ( len2 > 0.0f ) {
+          const float len = std::sqrt(len2);
+          const float nx = -dy / len * r, ny = dx / len * r;
+          body[0] = QPointF(ax + nx, ay + ny);
+          body[1] = QPointF(p1.x() + nx, p1.y() + ny);
+          body[2] = QPointF(p1.x() - nx, p1.y() - ny);
+          body[3] = QPointF(ax - nx, ay - ny);
+        }
+        const int yMin = std::max(m_rect.top(), std::min(p0.y(), p1.y()) - radius);
+        const int yMax = std::min(m_rect.bottom(), std::max(p0.y(), p1.y()) + radius);
+        for ( int y = yMin; y <= yMax; ++y ) {
+          // --- row span = union of the two end discs and the body ---
+          float lo = std::numeric_limits<float>::max();
+          float hi = std::numeric_limits<float>::lowest();
+          for ( const QPoint& c : { p0, p1 } ) {
+            const float cy = float(y - c.y());
+            if ( cy*cy <= r2 ) {
+              const float w = std::sqrt(r2 - cy*cy);
+              lo = std::min(lo, c.x() - w);
+              hi = std::max(hi, c.x() + w);
+            }
+          }
+          if ( len2 > 0.0f ) {
+            for ( int e = 0; e < 4; ++e ) {
+              const QPointF& a = body[e];
+              const QPointF& b = body[(e+1)%4];
+              if ( (y < std::min(a.y(), b.y())) || (y > std::max(a.y(), b.y())) )
+                continue;
+              if ( a.y() == b.y() ) {
+                lo = std::min(lo, float(std::min(a.x(), b.x())));
+                hi = std::max(hi, float(std::max(a.x(), b.x())));
+              } else {
+                const float x = a.x() + (y - a.y()) * (b.x() - a.x()) / (b.y() - a.y());
+                lo = std::min(lo, x);
+                hi = std::max(hi, x);
+              }
+            }
+          }
+          if ( lo > hi )
+            continue;
+          const int x0 = std::max(m_rect.left(), int(std::floor(lo)));
+          const int x1 = std::min(m_rect.right(), int(std::ceil(hi)));
+          quint8* dst = m_data.data() + size_t(y - m_rect.top()) * m_rect.width() - m_rect.left();
+          const float vy = y - ay;
+          for ( int x = x0; x <= x1; ++x ) {
+            const float vx = x - ax;
+            float t = len2 > 0.0f ? (vx*dx + vy*dy) / len2 : 0.0f;
+            t = std::max(0.0f, std::min(t, 1.0f));
+            const float ex = vx - t*dx;
+            const float ey = vy - t*dy;
+            const float d2 = ex*ex + ey*ey;
+            if ( d2 > r2 )
+              continue;
+            const float alpha = radius > 0 ? falloff(std::sqrt(d2) / r, hardness) : 1.0f;
+            const quint8 c = quint8(std::lround(alpha * op));
+            dst[x] = std::max(dst[x], c);
+          }
+        }
+      }
+
+      // One segment of a stroke: dabs with the placement of the former
+      // stamping loop (spacing radius*0.35), or an analytic capsule
+      void addSegment( int mode, const QPoint& p0, const QPoint& p1, int radius, float hardness, int opacity ) {
+        if ( radius < 0 )
+          return;
+        if ( mode == Capsule ) {
+          addCapsule(p0, p1, radius, hardness, opacity);
+          return;
+        }
+        StampPtr s = stamp(radius, hardness);
+        const float spacing = std::max(1.0f, radius * 0.35f);
+        const float dx = p1.x() - p0.x();
+        const float dy = p1.y() - p0.y();
+        const float dist = std::sqrt(dx*dx + dy*dy);
+        if ( dist <= 0.0f ) {
+          addDab(p0, *s, opacity);
+          return;
+        }
+        const int steps = std::ceil(dist / spacing);
+        for ( int i = 0; i <= steps; ++i ) {
+          float t = float(i) / float(steps);
+          QPoint p(
+              int(p0.x() + t * dx),
+              int(p0.y() + t * dy)
+          );
+          addDab(p, *s, opacity);
+        }
+      }
+
+      // clip restricts the composited pixels, e.g. to the last segment
+      bool composite( QImage& img, const QColor& color, const QRect& clip = QRect() ) const {
+        const QRect area = clip.isNull() ? ( m_rect & img.rect() ) : ( m_rect & img.rect() & clip );
+        if ( area.isEmpty() )
+          return true;
+        const int w = area.width();
+        const QImage::Format format = img.format();
+        if ( format == QImage::Format_RGB32 || format == QImage::Format_ARGB32_Premultiplied ) {
+          const quint32 src = qRgba(color.red(), color.green(), color.blue(), 255);
+          for ( int y = area.top(); y <= area.bottom(); ++y ) {
+            QRgb* line = reinterpret_cast<QRgb*>(img.scanLine(y)) + area.left();
+            const quint8* cov = coverageLine(y) + (area.left() - m_rect.left());
+            for ( int x = 0; x < w; ++x ) {
+              const quint32 a = cov[x];
+              line[x] = interpolatePixel255(src, a, line[x], 255 - a);
+            }
+          }
+        } else if ( format == QImage::Format_ARGB32 ) {
+          const quint32 src = qRgba(color.red(), color.green(), color.blue(), 255);
+          for ( int y = area.top(); y <= area.bottom(); ++y ) {
+            QRgb* line = reinterpret_cast<QRgb*>(img.scanLine(y)) + area.left();
+            const quint8* cov = coverageLine(y) + (area.left() - m_rect.left());
+            for ( int x = 0; x < w; ++x ) {
+              const quint32 a = cov[x];
+              if ( a == 0 )
+                continue;
+              const quint32 dst = qPremultiply(line[x]);
+              line[x] = qUnpremultiply(interpolatePixel255(src, a, dst, 255 - a));
+            }
+          }
+        } else if ( format == QImage::Format_Grayscale8 ) {
+          const quint32 gray = quint32(qGray(color.rgb()));
+          for ( int y = area.top(); y <= area.bottom(); ++y ) {
+            uchar* line = img.scanLine(y) + area.left();
+            const quint8* cov = coverageLine(y) + (area.left() - m_rect.left());
+            for ( int x = 0; x < w; ++x ) {
+              const quint32 a = cov[x];
+              line[x] = uchar(div255(gray * a + line[x] * (255 - a)));
+            }
+          }
+        } else {
+          qInfo() << "WARNING: Invalid data format " << format;
+          return false;
+        }
+        return true;
+      }
+
+    private:
+
+      const quint8* coverageLine( int y ) const {
+        return m_data.data() + size_t(y - m_rect.top()) * m_rect.width();
+      }
+
+      QRect m_rect;
+      std::vector<quint8> m_data;
+
+  };
+
+  // ---------------------- Public helpers ----------------------
+  inline QRect segmentBounds( const QImage& img, const QPoint& p0, const QPoint& p1, int radius ) {
+    QRect rect = QRect(p0, QSize(1,1)) | QRect(p1, QSize(1,1));
+    rect.adjust(-radius, -radius, radius, radius);
+    return rect & img.rect();
+  }
+
+  inline void dab( QImage& img, const QPoint& center, const QColor& color, int radius, float hardness ) {
+    if ( radius < 0 )
+      return;
+    StampPtr s = stamp(radius, hardness);
+    Coverage coverage(segmentBounds(img, center, center, radius));
+    coverage.addDab(center, *s, color.alpha());
+    coverage.composite(img, color);
+  }
+
+  // Same dab placement as the former stamping loop (spacing radius*0.35),
+  // but every pixel of the segment is composited only once
+  inline void strokeSegment( QImage& img, const QPoint& p0, const QPoint& p1, const QColor& color, int radius, float hardness ) {
+    if ( radius < 0 )
+      return;
+    Coverage coverage(segmentBounds(img, p0, p1, radius));
+    if ( coverage.isEmpty() )
+      return;
+    coverage.addSegment(Dabs, p0, p1, radius, hardness, color.alpha());
+    coverage.composite(img, color);
+  }
+
+  // Single pass rendering of a whole polyline: all segments go into one
+  // coverage buffer, composited once. LayerItem builds the same buffer
+  // segment by segment while painting, so live and replay give equal pixels.
+  // Overlapping Dabs accumulate as before (see Coverage::addDab), overlaps of
+  // Capsule segments are not blended twice.
+  inline void paintStroke( QImage& img, int mode, const QVector<QPoint>& points, const QColor& color, int radius, float hardness ) {
+    if ( radius < 0 || points.isEmpty() )
+      return;
+    QRect bounds;
+    for ( const QPoint& p : points )
+      bounds |= QRect(p, QSize(1,1));
+    bounds.adjust(-radius, -radius, radius, radius);
+    Coverage coverage(bounds & img.rect());
+    if ( coverage.isEmpty() )
+      return;
+    if ( points.size() == 1 ) {
+      coverage.addSegment(mode, points.first(), points.first(), radius, hardness, color.alpha());
+    } else {
+      for ( int i = 1; i < points.size(); ++i ) {
+        coverage.addSegment(mode, points[i-1], points[i], radius, hardness, color.alpha());
+      }
+    }
+    coverage.composite(img, color);
+  }
+
+  inline void capsuleStroke( QImage& img, const QVector<QPoint>& points, const QColor& color, int radius, float hardness ) {
+    paintStroke(img, Capsule, points, color, radius, hardness);
+  }
+
+  inline void capsuleSegment( QImage& img, const QPoint& p0, const QPoint& p1, const QColor& color, int radius, float hardness ) {
+    capsuleStroke(img, QVector<QPoint>{ p0, p1 }, color, radius, hardness);
+  }
+
+  inline void stroke( QImage& img, int mode, const QPoint& p0, const QPoint& p1, const QColor& color, int radius, float hardness ) {
+    if ( mode == Capsule ) {
+      capsuleSegment(img, p0, p1, color, radius, hardness);
+    } else {
+      strokeSegment(img, p0, p1, color, radius, hardness);
+    }
+  }
+
+}
@@ -15,9 +15,12 @@
 *
 */
 
+#pragma once
+
 #include <QImage>
 #include <QBuffer>
 #include <QByteArray>
+#include <QDataStream>
 #include <QFile>
 #include <QTextStream>
 #include <QString>
@@ -26,7 +29,7 @@
 namespace CompressUtils 
 {
 
-  QString toGZipBase64( const QImage &image ) {
+  inline QString toGZipBase64( const QImage &image ) {
     // 1. QImage in ein QByteArray schreiben (z.B. als PNG)
     QByteArray ba;
     QBuffer buffer(&ba);
@@ -42,7 +45,7 @@ namespace CompressUtils
     return QString(compressed.toBase64());
   }
 
-  QImage fromGZipBase64( const QString &base64String ) {
+  inline QImage fromGZipBase64( const QString &base64String ) {
     // 1. Base64 zurück in Bytes
     QByteArray compressed = QByteArray::fromBase64(base64String.toUtf8());
 
@@ -55,7 +58,7 @@ namespace CompressUtils
     return image;
   }
   
-  void saveToFile( const QString &filename, const QString &text ) {
+  inline void saveToFile( const QString &filename, const QString &text ) {
     QFile file(filename);
     // Datei zum Schreiben öffnen (WriteOnly und Text-Modus)
     if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
@@ -67,4 +70,38 @@ namespace CompressUtils
     }
   }
 
-}
\ No newline at end of file
+  // Raw pixel rows (no PNG encoding) compressed with a fast zlib level,
+  // used for spilling undo tiles where speed matters more than size.
+  inline QByteArray toCompressedRaw( const QImage &image, int level = 1 ) {
+    QByteArray raw;
+    QDataStream out(&raw, QIODevice::WriteOnly);
+    out << qint32(image.width()) << qint32(image.height()) << qint32(image.format());
+    const int lineBytes = (image.width() * image.depth() + 7) / 8;
+    for ( int y = 0; y < image.height(); ++y ) {
+      out.writeRawData(reinterpret_cast<const char*>(image.constScanLine(y)), lineBytes);
+    }
+    return qCompress(raw, level);
+  }
+
+  inline QImage fromCompressedRaw( const QByteArray &data ) {
+    const QByteArray raw = qUncompress(data);
+    QDataStream in(raw);
+    qint32 width = 0, height = 0, format = 0;
+    in >> width >> height >> format;
+    if ( in.status() != QDataStream::Ok || width <= 0 || height <= 0 ) {
+      return QImage();
+    }
+    QImage image(width, height, QImage::Format(format));
+    if ( image.isNull() ) {
+      return QImage();
+    }
+    const int lineBytes = (image.width() * image.depth() + 7) / 8;
+    for ( int y = 0; y < image.height(); ++y ) {
+      if ( in.readRawData(reinterpret_cast<char*>(image.scanLine(y)), lineBytes) != lineBytes ) {
+        return QImage();
+      }
+    }
+    return image;
+  }
+
+}
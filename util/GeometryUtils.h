@@ -67,8 +67,10 @@ namespace GeometryUtils
     // >>>
     inline QString getGeometryString( QGraphicsPixmapItem *item ) {
        if ( !item ) return QString();
-       int w = item->pixmap().width();
-       int h = item->pixmap().height();
+       // layer items draw their image and hold no pixmap, their shape is the image rect
+       QSize size = item->pixmap().isNull() ? item->shape().boundingRect().size().toSize() : item->pixmap().size();
+       int w = size.width();
+       int h = size.height();
        int x = static_cast<int>(item->scenePos().x());
        int y = static_cast<int>(item->scenePos().y());
        return QString("%1x%2+%3+%4").arg(w).arg(h).arg(x).arg(y);
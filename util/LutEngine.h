@@ -0,0 +1,157 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+#include <QImage>
+#include <QRgb>
+#include <QVector>
+
+#include "Parallel.h"
+
+// ---------------------- Point operations ----------------------
+// Lookup tables applied in place to 32 bit images. Alpha is never changed,
+// rows are processed in parallel bands. Premultiplied images are mapped on
+// their straight colours, all other non 32 bit formats are converted to
+// ARGB32 first (as the old per pixel code did).
+namespace LutEngine
+{
+
+  // --- independent 8 bit table per colour channel ---
+  struct ChannelLut {
+    uchar r[256];
+    uchar g[256];
+    uchar b[256];
+  };
+
+  // --- colour table indexed by the gray value (qGray) of a pixel ---
+  // Pixels whose gray value is beyond the table keep their colour.
+  struct GrayLut {
+    QRgb map[256];
+    int size = 0;
+  };
+
+  inline ChannelLut identity() {
+    ChannelLut lut;
+    for ( int i = 0; i < 256; ++i ) {
+      lut.r[i] = lut.g[i] = lut.b[i] = uchar(i);
+    }
+    return lut;
+  }
+
+  inline ChannelLut inverted() {
+    ChannelLut lut;
+    for ( int i = 0; i < 256; ++i ) {
+      lut.r[i] = lut.g[i] = lut.b[i] = uchar(255 - i);
+    }
+    return lut;
+  }
+
+  inline GrayLut fromColorTable( const QVector<QRgb>& table ) {
+    GrayLut lut;
+    lut.size = qMin(256, int(table.size()));
+    for ( int i = 0; i < lut.size; ++i ) {
+      lut.map[i] = table[i] & 0x00ffffff;
+    }
+    return lut;
+  }
+
+  // --- brings img into a format the row kernels work on ---
+  // returns the format to convert back to afterwards (Format_Invalid = none)
+  inline QImage::Format prepare( QImage& img ) {
+    switch ( img.format() ) {
+      case QImage::Format_ARGB32:
+      case QImage::Format_RGB32:
+        return QImage::Format_Invalid;
+      case QImage::Format_ARGB32_Premultiplied:
+        img.convertTo(QImage::Format_ARGB32);
+        return QImage::Format_ARGB32_Premultiplied;
+      default:
+        img.convertTo(QImage::Format_ARGB32);
+        return QImage::Format_Invalid;
+    }
+  }
+
+  inline void finish( QImage& img, QImage::Format restoreFormat ) {
+    if ( restoreFormat != QImage::Format_Invalid ) {
+      img.convertTo(restoreFormat);
+    }
+  }
+
+  inline void apply( QImage& img, const ChannelLut& lut ) {
+    if ( img.isNull() )
+      return;
+    const QImage::Format restoreFormat = prepare(img);
+    const int w = img.width();
+    uchar* bits = img.bits();   // detaches once, before the threads start
+    const qsizetype bpl = img.bytesPerLine();
+    ParallelUtils::forRows(img.height(), [&](int y0, int y1){
+      for ( int y = y0; y < y1; ++y ) {
+        QRgb* line = reinterpret_cast<QRgb*>(bits + y * bpl);
+        for ( int x = 0; x < w; ++x ) {
+          const QRgb px = line[x];
+          line[x] = (px & 0xff000000) | (QRgb(lut.r[(px >> 16) & 0xff]) << 16)
+                  | (QRgb(lut.g[(px >> 8) & 0xff]) << 8) | QRgb(lut.b[px & 0xff]);
+        }
+      }
+    });
+    finish(img, restoreFormat);
+  }
+
+  inline void apply( QImage& img, const GrayLut& lut ) {
+    if ( img.isNull() )
+      return;
+    const QImage::Format restoreFormat = prepare(img);
+    const int w = img.width();
+    uchar* bits = img.bits();
+    const qsizetype bpl = img.bytesPerLine();
+    ParallelUtils::forRows(img.height(), [&](int y0, int y1){
+      for ( int y = y0; y < y1; ++y ) {
+        QRgb* line = reinterpret_cast<QRgb*>(bits + y * bpl);
+        for ( int x = 0; x < w; ++x ) {
+          const QRgb px = line[x];
+          // qGray() without the function call: (11r + 16g + 5b) / 32
+          const int gray = (((px >> 16) & 0xff) * 11 + ((px >> 8) & 0xff) * 16 + (px & 0xff) * 5) >> 5;
+          if ( gray < lut.size ) {
+            line[x] = (px & 0xff000000) | lut.map[gray];
+          }
+        }
+      }
+    });
+    finish(img, restoreFormat);
+  }
+
+  // --- invert is a plain xor, the compiler vectorises this loop ---
+  inline void invert( QImage& img ) {
+    if ( img.isNull() )
+      return;
+    const QImage::Format restoreFormat = prepare(img);
+    const int w = img.width();
+    uchar* bits = img.bits();
+    const qsizetype bpl = img.bytesPerLine();
+    ParallelUtils::forRows(img.height(), [&](int y0, int y1){
+      for ( int y = y0; y < y1; ++y ) {
+        QRgb* line = reinterpret_cast<QRgb*>(bits + y * bpl);
+        for ( int x = 0; x < w; ++x ) {
+          line[x] ^= 0x00ffffff;
+        }
+      }
+    });
+    finish(img, restoreFormat);
+  }
+
+}
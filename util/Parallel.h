@@ -0,0 +1,58 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+#include <QSemaphore>
+#include <QThreadPool>
+
+#include <utility>
+
+// ---------------------- Parallel utils ----------------------
+namespace ParallelUtils
+{
+
+  // Splits [0,rows) into contiguous bands and runs fn(begin,end) for each band
+  // on the global thread pool. The caller processes the first band itself and
+  // runs a band inline whenever the pool has no free thread, so nested calls
+  // from pool threads cannot dead lock.
+  template<typename Fn>
+  inline void forRows( int rows, Fn&& fn, int minRowsPerTask = 64 ) {
+    if ( rows <= 0 )
+      return;
+    QThreadPool* pool = QThreadPool::globalInstance();
+    const int tasks = qBound(1, rows / qMax(1, minRowsPerTask), qMax(1, pool->maxThreadCount()));
+    if ( tasks == 1 ) {
+      fn(0, rows);
+      return;
+    }
+    const int band = (rows + tasks - 1) / tasks;
+    QSemaphore done;
+    int started = 0;
+    for ( int begin = band; begin < rows; begin += band ) {
+      const int end = qMin(rows, begin + band);
+      if ( pool->tryStart([&fn, &done, begin, end](){ fn(begin, end); done.release(); }) ) {
+        ++started;
+      } else {
+        fn(begin, end);
+      }
+    }
+    fn(0, qMin(rows, band));
+    done.acquire(started);
+  }
+
+}
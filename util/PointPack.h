@@ -0,0 +1,195 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QPoint>
+#include <QPointF>
+#include <QString>
+#include <QVector>
+#include <QtEndian>
+
+#include <cstring>
+
+// ---------------------- Packed point arrays ----------------------
+// Compact forms of the point arrays in project files, stored as base64
+// strings in place of the JSON array of {"x":..,"y":..} objects:
+//  - integer points: varint count, then zigzag varint deltas to the
+//    previous point (the first point relative to 0,0)
+//  - float points:   little endian float32 x,y pairs; the 24 bit mantissa
+//    rounds coordinates to 1/256 px between 32768 and 65536 px (about
+//    0.004 px near 40k), the object array keeps full doubles
+// The readers accept both the packed string and the object array.
+namespace PointPack
+{
+
+  inline void writeVarint( QByteArray& out, quint64 v ) {
+    while ( v >= 0x80 ) {
+      out.append(char(( v & 0x7f ) | 0x80));
+      v >>= 7;
+    }
+    out.append(char(v));
+  }
+
+  inline bool readVarint( const uchar*& p, const uchar* end, quint64& v ) {
+    v = 0;
+    for ( int shift = 0; p < end && shift < 64; shift += 7 ) {
+      const uchar byte = *p++;
+      v |= quint64(byte & 0x7f) << shift;
+      if ( ( byte & 0x80 ) == 0 )
+        return true;
+    }
+    return false;
+  }
+
+  inline quint64 zigzag( qint64 v ) { return ( quint64(v) << 1 ) ^ quint64(v >> 63); }
+  inline qint64 unzigzag( quint64 v ) { return qint64(v >> 1) ^ -qint64(v & 1); }
+
+  // ---- integer points ----
+  inline QString packDelta( const QVector<QPoint>& points ) {
+    QByteArray bytes;
+    bytes.reserve(2 + points.size() * 2);
+    writeVarint(bytes, quint64(points.size()));
+    QPoint prev(0, 0);
+    for ( const QPoint& p : points ) {
+      writeVarint(bytes, zigzag(qint64(p.x()) - prev.x()));
+      writeVarint(bytes, zigzag(qint64(p.y()) - prev.y()));
+      prev = p;
+    }
+    return QString::fromLatin1(bytes.toBase64());
+  }
+
+  inline bool unpackDelta( const QString& text, QVector<QPoint>& points ) {
+    const QByteArray bytes = QByteArray::fromBase64(text.toLatin1());
+    const uchar* p = reinterpret_cast<const uchar*>(bytes.constData());
+    const uchar* end = p + bytes.size();
+    quint64 count = 0;
+    // every point takes at least two bytes
+    if ( !readVarint(p, end, count) || count > quint64(end - p) / 2 )
+      return false;
+    points.clear();
+    points.reserve(int(count));
+    qint64 x = 0, y = 0;
+    for ( quint64 i = 0; i < count; ++i ) {
+      quint64 dx = 0, dy = 0;
+      if ( !readVarint(p, end, dx) || !readVarint(p, end, dy) )
+        return false;
+      x += unzigzag(dx);
+      y += unzigzag(dy);
+      points.append(QPoint(int(x), int(y)));
+    }
+    return p == end;
+  }
+
+  // ---- float points ----
+  inline QString packFloat32( const QVector<QPointF>& points ) {
+    QByteArray bytes(points.size() * 8, Qt::Uninitialized);
+    uchar* dst = reinterpret_cast<uchar*>(bytes.data());
+    for ( const QPointF& p : points ) {
+      for ( const float f : { float(p.x()), float(p.y()) } ) {
+        quint32 bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        qToLittleEndian(bits, dst);
+        dst += 4;
+      }
+    }
+    return QString::fromLatin1(bytes.toBase64());
+  }
+
+  inline bool unpackFloat32( const QString& text, QVector<QPointF>& points ) {
+    const QByteArray bytes = QByteArray::fromBase64(text.toLatin1());
+    if ( bytes.size() % 8 != 0 )
+      return false;
+    const uchar* src = reinterpret_cast<const uchar*>(bytes.constData());
+    points.clear();
+    points.reserve(bytes.size() / 8);
+    for ( qsizetype i = 0; i < bytes.size(); i += 8 ) {
+      float xy[2];
+      for ( int k = 0; k < 2; ++k ) {
+        const quint32 bits = qFromLittleEndian<quint32>(src + i + 4 * k);
+        std::memcpy(&xy[k], &bits, sizeof(bits));
+      }
+      points.append(QPointF(xy[0], xy[1]));
+    }
+    return true;
+  }
+
+  // ---- readers for both forms ----
+  inline QVector<QPoint> readPoints( const QJsonValue& value ) {
+    QVector<QPoint> points;
+    if ( value.isString() ) {
+      if ( !unpackDelta(value.toString(), points) )
+        points.clear();
+      return points;
+    }
+    const QJsonArray arr = value.toArray();
+    points.reserve(arr.size());
+    for ( const QJsonValue& v : arr ) {
+      const QJsonObject po = v.toObject();
+      points.append(QPoint(po["x"].toInt(), po["y"].toInt()));
+    }
+    return points;
+  }
+
+  inline QVector<QPointF> readPointsF( const QJsonValue& value ) {
+    QVector<QPointF> points;
+    if ( value.isString() ) {
+      if ( !unpackFloat32(value.toString(), points) )
+        points.clear();
+      return points;
+    }
+    const QJsonArray arr = value.toArray();
+    points.reserve(arr.size());
+    for ( const QJsonValue& v : arr ) {
+      const QJsonObject po = v.toObject();
+      points.append(QPointF(po["x"].toDouble(), po["y"].toDouble()));
+    }
+    return points;
+  }
+
+  // ---- writers, packed or as object array ----
+  inline QJsonValue writePoints( const QVector<QPoint>& points, bool packed ) {
+    if ( packed )
+      return packDelta(points);
+    QJsonArray arr;
+    for ( const QPoint& p : points ) {
+      QJsonObject po;
+      po["x"] = p.x();
+      po["y"] = p.y();
+      arr.append(po);
+    }
+    return arr;
+  }
+
+  inline QJsonValue writePointsF( const QVector<QPointF>& points, bool packed ) {
+    if ( packed )
+      return packFloat32(points);
+    QJsonArray arr;
+    for ( const QPointF& p : points ) {
+      QJsonObject po;
+      po["x"] = p.x();
+      po["y"] = p.y();
+      arr.append(po);
+    }
+    return arr;
+  }
+
+}
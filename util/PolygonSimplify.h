@@ -0,0 +1,187 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+#pragma once
+
+#include <QPointF>
+#include <QPolygonF>
+#include <QVector>
+
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+// ---------------------- Polygon simplification ----------------------
+// Vertex reduction for closed polygons (lasso outlines). Both algorithms are
+// pure functions of their input, ties are broken by the lower vertex index,
+// so replaying a reduction always yields the same polygon. A repeated closing
+// vertex is kept closed, at least three vertices always remain.
+namespace PolygonSimplify
+{
+
+  inline qreal segmentDistance2( const QPointF& p, const QPointF& a, const QPointF& b ) {
+    const QPointF ab = b - a;
+    const QPointF ap = p - a;
+    const qreal len2 = QPointF::dotProduct(ab, ab);
+    qreal t = len2 > 0.0 ? QPointF::dotProduct(ap, ab) / len2 : 0.0;
+    t = t < 0.0 ? 0.0 : ( t > 1.0 ? 1.0 : t );
+    const QPointF d = ap - ab * t;
+    return QPointF::dotProduct(d, d);
+  }
+
+  // --- strips the repeated closing vertex, returns true if there was one ---
+  inline bool openRing( QPolygonF& ring ) {
+    if ( ring.size() > 1 && ring.first() == ring.last() ) {
+      ring.removeLast();
+      return true;
+    }
+    return false;
+  }
+
+  inline QPolygonF collect( const QPolygonF& ring, const std::vector<char>& keep, bool closed ) {
+    QPolygonF result;
+    for ( int i = 0; i < ring.size(); ++i ) {
+      if ( keep[i] ) result << ring[i];
+    }
+    if ( closed && !result.isEmpty() ) result << result.first();
+    return result;
+  }
+
+  // --- Douglas-Peucker, iterative with an explicit span stack ---
+  // Keeps every vertex farther than tolerance from the simplified outline.
+  // The ring is split at vertex 0 and the vertex farthest from it.
+  inline QPolygonF douglasPeucker( const QPolygonF& polygon, qreal tolerance ) {
+    QPolygonF ring = polygon;
+    const bool closed = openRing(ring);
+    const int n = ring.size();
+    if ( n <= 3 )
+      return polygon;
+    int far = 0;
+    qreal farDist = -1.0;
+    for ( int i = 1; i < n; ++i ) {
+      const QPointF d = ring[i] - ring[0];
+      const qreal dist = QPointF::dotProduct(d, d);
+      if ( dist > farDist ) {
+        farDist = dist;
+        far = i;
+      }
+    }
+    std::vector<char> keep(n, 0);
+    keep[0] = keep[far] = 1;
+    const qreal tol2 = tolerance * tolerance;
+    std::vector<std::pair<int,int>> stack;   // [first,last], last == n wraps to 0
+    stack.push_back({far, n});
+    stack.push_back({0, far});
+    while ( !stack.empty() ) {
+      const auto [first, last] = stack.back();
+      stack.pop_back();
+      if ( last - first < 2 )
+        continue;
+      const QPointF& a = ring[first];
+      const QPointF& b = ring[last % n];
+      int split = -1;
+      qreal maxDist = tol2;
+      for ( int i = first + 1; i < last; ++i ) {
+        const qreal dist = segmentDistance2(ring[i], a, b);
+        if ( dist > maxDist ) {
+          maxDist = dist;
+          split = i;
+        }
+      }
+      if ( split < 0 )
+        continue;
+      keep[split] = 1;
+      stack.push_back({split, last});
+      stack.push_back({first, split});
+    }
+    // a degenerate ring (all vertices on one line) would collapse to two
+    int kept = 0;
+    for ( char k : keep ) kept += k;
+    for ( int i = 1; i < n && kept < 3; ++i ) {
+      if ( !keep[i] ) {
+        keep[i] = 1;
+        ++kept;
+      }
+    }
+    return collect(ring, keep, closed);
+  }
+
+  // --- Visvalingam-Whyatt with a binary heap ---
+  // Repeatedly removes the vertex spanning the smallest triangle with its
+  // neighbours. Stops when that triangle is at least minArea or, if
+  // targetCount > 0, as soon as targetCount vertices are left (minArea is
+  // ignored then). Stale heap entries are skipped via a per vertex version.
+  inline QPolygonF visvalingam( const QPolygonF& polygon, qreal minArea, int targetCount = 0 ) {
+    QPolygonF ring = polygon;
+    const bool closed = openRing(ring);
+    const int n = ring.size();
+    const int minCount = qMax(3, targetCount);
+    if ( n <= minCount )
+      return polygon;
+    std::vector<int> prev(n), next(n), version(n, 0);
+    std::vector<qreal> area(n);
+    std::vector<char> keep(n, 1);
+    auto triangle = [&ring]( int a, int b, int c ) {
+      const QPointF u = ring[b] - ring[a];
+      const QPointF v = ring[c] - ring[a];
+      return std::abs(u.x() * v.y() - u.y() * v.x()) * 0.5;
+    };
+    struct Entry {
+      qreal area;
+      int index;
+      int version;
+      bool operator>( const Entry& o ) const {
+        return area != o.area ? area > o.area : index > o.index;
+      }
+    };
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+    for ( int i = 0; i < n; ++i ) {
+      prev[i] = (i + n - 1) % n;
+      next[i] = (i + 1) % n;
+      area[i] = triangle(prev[i], i, next[i]);
+      heap.push({area[i], i, 0});
+    }
+    int count = n;
+    qreal removedArea = 0.0;
+    while ( count > minCount && !heap.empty() ) {
+      const Entry top = heap.top();
+      if ( top.version != version[top.index] || !keep[top.index] ) {
+        heap.pop();
+        continue;
+      }
+      if ( targetCount <= 0 && top.area >= minArea )
+        break;
+      heap.pop();
+      const int i = top.index;
+      keep[i] = 0;
+      --count;
+      // effective areas never decrease, otherwise removal order would skip back
+      removedArea = qMax(removedArea, top.area);
+      const int p = prev[i];
+      const int q = next[i];
+      next[p] = q;
+      prev[q] = p;
+      for ( int j : { p, q } ) {
+        area[j] = qMax(removedArea, triangle(prev[j], j, next[j]));
+        heap.push({area[j], j, ++version[j]});
+      }
+    }
+    return collect(ring, keep, closed);
+  }
+
+}
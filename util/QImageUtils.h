@@ -18,6 +18,9 @@
 #pragma once
 
 #include <QImage>
+#include <QRect>
+
+#include <cstring>
 
 namespace QImageUtils
 {
@@ -54,4 +57,38 @@ namespace QImageUtils
     return blurred;
   }
   
+  // bounding rect of the pixels in which a and b differ, empty if they are
+  // equal, the whole rect of b if size or format differ
+  inline QRect changedRect( const QImage& a, const QImage& b )
+  {
+    if ( a.size() != b.size() || a.format() != b.format() )
+      return b.rect();
+    const size_t lineBytes = ( size_t(b.width()) * b.depth() + 7 ) / 8;
+    int left = b.width(), right = -1, top = -1, bottom = -1;
+    for ( int y = 0; y < b.height(); ++y ) {
+      const uchar* la = a.constScanLine(y);
+      const uchar* lb = b.constScanLine(y);
+      if ( std::memcmp(la, lb, lineBytes) == 0 )
+        continue;
+      if ( top < 0 ) top = y;
+      bottom = y;
+      if ( b.depth() != 32 ) {
+        left = 0;
+        right = b.width() - 1;
+        continue;
+      }
+      const quint32* pa = reinterpret_cast<const quint32*>(la);
+      const quint32* pb = reinterpret_cast<const quint32*>(lb);
+      int x0 = 0;
+      while ( pa[x0] == pb[x0] ) ++x0;
+      int x1 = b.width() - 1;
+      while ( pa[x1] == pb[x1] ) --x1;
+      left = qMin(left, x0);
+      right = qMax(right, x1);
+    }
+    if ( top < 0 )
+      return QRect();
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+  }
+  
 }
\ No newline at end of file
@@ -0,0 +1,130 @@
+/* 
+* Copyright 2026 Forschungszentrum Jülich
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    https://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+#pragma once
+
+#include <QPointF>
+#include <QPolygonF>
+#include <QVector>
+
+#include <cmath>
+#include <vector>
+
+#include "PolygonSimplify.h"
+
+// ---------------------- Spline smoothing ----------------------
+// Closed cubic splines through (Catmull-Rom) or along (uniform B-spline) the
+// vertices of a polygon. Every segment is subdivided until the curve is
+// within maxError of its chords, the result is resampled to an arc length
+// uniform ring if it exceeds the vertex budget. Plain arithmetic in a fixed
+// order, GUI and batch replay get identical points.
+namespace SplineSmooth
+{
+
+  enum Basis { CatmullRom = 0, BSpline = 1 };
+
+  inline QPointF evaluate( Basis basis, const QPointF& p0, const QPointF& p1, const QPointF& p2, const QPointF& p3, qreal t ) {
+    const qreal t2 = t * t;
+    const qreal t3 = t2 * t;
+    if ( basis == BSpline ) {
+      return ( p0 * (-t3 + 3.0 * t2 - 3.0 * t + 1.0)
+             + p1 * (3.0 * t3 - 6.0 * t2 + 4.0)
+             + p2 * (-3.0 * t3 + 3.0 * t2 + 3.0 * t + 1.0)
+             + p3 * t3 ) / 6.0;
+    }
+    return ( p1 * 2.0
+           + (p2 - p0) * t
+           + (p0 * 2.0 - p1 * 5.0 + p2 * 4.0 - p3) * t2
+           + (p1 * 3.0 - p0 - p2 * 3.0 + p3) * t3 ) * 0.5;
+  }
+
+  // --- closed ring resampled to count points of equal arc length ---
+  inline QPolygonF resample( const QPolygonF& ring, int count ) {
+    const int n = ring.size();
+    if ( n < 2 || count < 3 )
+      return ring;
+    std::vector<qreal> length(n + 1, 0.0);
+    for ( int i = 0; i < n; ++i ) {
+      const QPointF d = ring[(i + 1) % n] - ring[i];
+      length[i + 1] = length[i] + std::sqrt(QPointF::dotProduct(d, d));
+    }
+    const qreal total = length[n];
+    if ( total <= 0.0 )
+      return ring;
+    QPolygonF result;
+    result.reserve(count);
+    int seg = 0;
+    for ( int k = 0; k < count; ++k ) {
+      const qreal s = total * k / count;
+      while ( seg < n - 1 && length[seg + 1] <= s ) ++seg;
+      const qreal segLength = length[seg + 1] - length[seg];
+      const qreal t = segLength > 0.0 ? (s - length[seg]) / segLength : 0.0;
+      result << ring[seg] + (ring[(seg + 1) % n] - ring[seg]) * t;
+    }
+    return result;
+  }
+
+  // maxError: max. distance (pixel) between the curve and the output chords
+  // maxPoints: vertex budget, larger results are resampled (<= 0: no limit)
+  inline QPolygonF smooth( const QPolygonF& polygon, Basis basis, qreal maxError, int maxPoints ) {
+    QPolygonF ring = polygon;
+    const bool closed = PolygonSimplify::openRing(ring);
+    const int n = ring.size();
+    if ( n < 3 )
+      return polygon;
+    const qreal err2 = qMax(maxError, qreal(1e-3)) * qMax(maxError, qreal(1e-3));
+    constexpr int MaxDepth = 10;   // at most 1024 chords per segment
+    struct Span {
+      qreal t0, t1;
+      QPointF a, b;
+      int depth;
+    };
+    QPolygonF result;
+    std::vector<Span> stack;
+    for ( int i = 0; i < n; ++i ) {
+      const QPointF& p0 = ring[(i + n - 1) % n];
+      const QPointF& p1 = ring[i];
+      const QPointF& p2 = ring[(i + 1) % n];
+      const QPointF& p3 = ring[(i + 2) % n];
+      stack.push_back({ 0.0, 1.0, evaluate(basis, p0, p1, p2, p3, 0.0), evaluate(basis, p0, p1, p2, p3, 1.0), 0 });
+      while ( !stack.empty() ) {
+        const Span span = stack.back();
+        stack.pop_back();
+        // two probes, a single midpoint misses S shaped spans
+        const qreal dt = span.t1 - span.t0;
+        const QPointF q1 = evaluate(basis, p0, p1, p2, p3, span.t0 + dt / 3.0);
+        const QPointF q2 = evaluate(basis, p0, p1, p2, p3, span.t0 + 2.0 * dt / 3.0);
+        if ( span.depth < MaxDepth
+             && ( PolygonSimplify::segmentDistance2(q1, span.a, span.b) > err2
+               || PolygonSimplify::segmentDistance2(q2, span.a, span.b) > err2 ) ) {
+          const qreal tm = span.t0 + dt * 0.5;
+          const QPointF m = evaluate(basis, p0, p1, p2, p3, tm);
+          stack.push_back({ tm, span.t1, m, span.b, span.depth + 1 });
+          stack.push_back({ span.t0, tm, span.a, m, span.depth + 1 });
+          continue;
+        }
+        // the end point is the start of the next span
+        result << span.a;
+      }
+    }
+    if ( maxPoints > 0 && result.size() > maxPoints ) {
+      result = resample(result, qMax(3, maxPoints));
+    }
+    if ( closed ) result << result.first();
+    return result;
+  }
+
+}
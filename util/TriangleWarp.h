@@ -23,6 +23,7 @@
 #include "../layer/CageMesh.h"
 #include "GeometryUtils.h"
 
+#include <functional>
 #include <iostream>
 
 // --------------------- TriangleWarp Methods ---------------------
@@ -76,7 +77,9 @@ namespace TriangleWarp
     
   }
 
-  WarpResult warp( QImage & currentImage, const QImage& originalImage, const CageMesh& cageMesh )
+  // isCanceled is polled once per row of cage cells, a canceled warp returns a null image
+  WarpResult warp( QImage & currentImage, const QImage& originalImage, const CageMesh& cageMesh,
+                   const std::function<bool()>& isCanceled = nullptr )
   {
    qCDebug(logEditor) << "TriangleWarp:warp(): useQuads =" << EditorStyle::instance().useCageQuads();
    {
@@ -110,6 +113,7 @@ namespace TriangleWarp
 
       // -- always use GeometryUtils::barycentric, which uses iterations and is more "exact".
       for ( int y = 0; y + 1 < rows; ++y ) {
+        if ( isCanceled && isCanceled() ) return { QImage(), QPointF(0,0) };
        for ( int x = 0; x + 1 < cols; ++x ) {
         int i00 = y * cols + x;
         int i10 = i00 + 1;
@@ -180,6 +184,7 @@ namespace TriangleWarp
      } else {
         
       for ( int y = 0; y + 1 < rows; ++y ) {
+        if ( isCanceled && isCanceled() ) return { QImage(), QPointF(0,0) };
        for ( int x = 0; x + 1 < cols; ++x ) {
         int i00 = y * cols + x;
         int i10 = i00 + 1;
@@ -221,6 +226,7 @@ namespace TriangleWarp
      // --- TRIANGLE WARP ---
      int count = 0;
      for ( int y = 0; y + 1 < rows; ++y ) {
+       if ( isCanceled && isCanceled() ) return { QImage(), QPointF(0,0) };
         for ( int x = 0; x + 1 < cols; ++x ) {
             int i00 = y*cols + x;
             int i10 = i00 + 1;